@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// number of calls to the global operator new since the start of the program, replaced by AllocationCounter.cpp
+std::size_t allocationCount();
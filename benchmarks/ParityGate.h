@@ -0,0 +1,81 @@
+#pragma once
+
+#include "FSMWithEnums.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// The parity gates fail when an implementation is more than 5% slower than the hand-written switch of with_enums on
+// the turnstile scenario. Each side is repeated and judged by its fastest repetition, which is the least disturbed by
+// the machine. The repetitions are many and short, and those of the two sides alternate, so that both see the same
+// phases of whatever else the machine is doing.
+namespace parity {
+    constexpr double TOLERANCE = 1.05;
+    constexpr int REPETITIONS = 30;
+    constexpr double MIN_TIME = 0.05;
+
+    // an approved passage, a declined card and a payment whose gateways all time out, with the stray events between
+    template <typename FSM>
+    void turnstile(benchmark::State & state) {
+        FSM fsm;
+        for (auto _ : state) {
+            fsm.process(CardPresented{"1234"}).process(TransactionSuccess{5, 25}).process(PersonPassed{});
+            fsm.process(PersonPassed{}).process(Timeout{});
+            fsm.process(CardPresented{"1234"}).process(TransactionDeclined{"No Funds"}).process(Timeout{});
+            fsm.process(CardPresented{"1234"}).process(Timeout{}).process(Timeout{}).process(Timeout{});
+            fsm.process(TransactionSuccess{5, 25}).process(Timeout{});
+            benchmark::DoNotOptimize(fsm);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 14));
+    }
+
+    // keeps the fastest repetition of each benchmark
+    class FastestReporter : public benchmark::ConsoleReporter {
+    public:
+        void ReportRuns(const std::vector<Run> & runs) override {
+            ConsoleReporter::ReportRuns(runs);
+            for (const auto & run : runs) {
+                if (run.run_type == Run::RT_Iteration) {
+                    const auto [it, added] = _fastest.try_emplace(run.run_name.function_name, run.GetAdjustedCPUTime());
+                    it->second = std::min(it->second, run.GetAdjustedCPUTime());
+                }
+            }
+        }
+
+        double fastest(const std::string & name) const {
+            const auto it = _fastest.find(name);
+            return it == _fastest.end() ? 0 : it->second;
+        }
+
+    private:
+        std::map<std::string, double> _fastest;
+    };
+
+    // runs the gate of FSM, reported as name, and returns the exit code of the program
+    template <typename FSM>
+    int gate(int argc, char ** argv, const char * name) {
+        for (int repetition = 0; repetition < REPETITIONS; ++repetition) {
+            benchmark::RegisterBenchmark("with_enums", &turnstile<with_enums::FSM>)->MinTime(MIN_TIME);
+            benchmark::RegisterBenchmark(name, &turnstile<FSM>)->MinTime(MIN_TIME);
+        }
+        benchmark::Initialize(&argc, argv);
+
+        FastestReporter reporter;
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+        benchmark::Shutdown();
+
+        const auto enums = reporter.fastest("with_enums");
+        const auto candidate = reporter.fastest(name);
+        if (enums <= 0 || candidate <= 0) {
+            std::fprintf(stderr, "both implementations must run\n");
+            return 1;
+        }
+        const auto ratio = candidate / enums;
+        std::printf("%s / with_enums: %.3f (at most %.2f)\n", name, ratio, TOLERANCE);
+        return ratio <= TOLERANCE ? 0 : 1;
+    }
+} // namespace parity
@@ -0,0 +1,117 @@
+#include "EventMailbox.h"
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Stamped {
+        Clock::time_point posted;
+    };
+
+    // consumer recording the post-to-process latency of every event
+    struct LatencySink {
+        void process(Stamped event) {
+            latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - event.posted).count());
+        }
+
+        double percentile(double p) {
+            if (latencies.empty()) {
+                return 0;
+            }
+            const auto nth = latencies.begin() + static_cast<std::ptrdiff_t>(p * (latencies.size() - 1));
+            std::nth_element(latencies.begin(), nth, latencies.end());
+            return *nth;
+        }
+
+        std::vector<double> latencies;
+    };
+
+    // the obvious alternative: a mutex-guarded deque, bounded like the lock-free mailbox
+    class MutexMailbox {
+    public:
+        explicit MutexMailbox(std::size_t capacity) : _capacity(capacity) {
+        }
+
+        bool post(Stamped event) {
+            std::lock_guard<std::mutex> lock{_mutex};
+            if (_events.size() >= _capacity) {
+                return false;
+            }
+            _events.push_back(event);
+            return true;
+        }
+
+        std::size_t drain(LatencySink & sink) {
+            std::deque<Stamped> events;
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                events.swap(_events);
+            }
+            for (auto & event : events) {
+                sink.process(event);
+            }
+            return events.size();
+        }
+
+    private:
+        const std::size_t _capacity;
+        std::mutex _mutex;
+        std::deque<Stamped> _events;
+    };
+
+    template <typename Mailbox>
+    void runProducers(benchmark::State & state, Mailbox & mailbox) {
+        constexpr std::size_t EVENTS_PER_ITERATION = 1024;
+        const auto producerCount = static_cast<std::size_t>(state.range(0));
+        std::atomic<bool> running{true};
+        std::vector<std::thread> producers;
+        for (std::size_t p = 0; p < producerCount; ++p) {
+            producers.emplace_back([&] {
+                while (running.load(std::memory_order_relaxed)) {
+                    if (!mailbox.post(Stamped{Clock::now()})) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        LatencySink sink;
+        sink.latencies.reserve(1 << 20);
+        for (auto _ : state) {
+            std::size_t processed = 0;
+            while (processed < EVENTS_PER_ITERATION) {
+                processed += mailbox.drain(sink);
+            }
+            if (sink.latencies.size() > (1 << 20)) {
+                sink.latencies.clear();
+            }
+        }
+        running = false;
+        for (auto & producer : producers) {
+            producer.join();
+        }
+        state.SetItemsProcessed(state.iterations() * EVENTS_PER_ITERATION);
+        state.counters["p50_ns"] = sink.percentile(0.5);
+        state.counters["p99_ns"] = sink.percentile(0.99);
+    }
+} // namespace
+
+static void BM_LockFreeMailbox(benchmark::State & state) {
+    adc::TEventMailbox<Stamped> mailbox{1024};
+    runProducers(state, mailbox);
+}
+BENCHMARK(BM_LockFreeMailbox)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void BM_MutexMailbox(benchmark::State & state) {
+    MutexMailbox mailbox{1024};
+    runProducers(state, mailbox);
+}
+BENCHMARK(BM_MutexMailbox)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
@@ -0,0 +1,106 @@
+#include "Executor.h"
+#include "FSMExternalTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr std::size_t GATES = 4096;
+    constexpr std::size_t EVENTS = 1 << 16;
+
+    using Gate = fsm_external_transitions::FSM;
+    using Queue = adc::TSerialQueue<Gate, CardPresented, TransactionSuccess, PersonPassed>;
+    using AnyGateEvent = std::variant<CardPresented, TransactionSuccess, PersonPassed>;
+
+    struct GateEvent {
+        std::size_t gateId;
+        AnyGateEvent event;
+    };
+
+    // Every gate cycles through card, approval and passage. The gate of each event is drawn uniformly or from a Zipf
+    // distribution, where the busiest gate gets about a tenth of all events and bounds the achievable speedup.
+    std::vector<GateEvent> gateEvents(bool skewed) {
+        std::vector<double> weights(GATES);
+        for (std::size_t id = 0; id < GATES; ++id) {
+            weights[id] = skewed ? 1.0 / static_cast<double>(id + 1) : 1.0;
+        }
+        std::mt19937 rng{42};
+        std::discrete_distribution<std::size_t> gate(weights.begin(), weights.end());
+        std::vector<std::size_t> phase(GATES);
+        std::vector<GateEvent> result(EVENTS);
+        for (auto & e : result) {
+            e.gateId = gate(rng);
+            switch (phase[e.gateId]++ % 3) {
+            case 0:
+                e.event = CardPresented{"1234"};
+                break;
+            case 1:
+                e.event = TransactionSuccess{5, 25};
+                break;
+            default:
+                e.event = PersonPassed{};
+                break;
+            }
+        }
+        return result;
+    }
+
+    void threadsAndSkew(benchmark::internal::Benchmark * benchmark) {
+        const auto cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (const auto skewed : {0, 1}) {
+            for (int threads = 1; threads < cores; threads *= 2) {
+                benchmark->Args({threads, skewed});
+            }
+            benchmark->Args({cores, skewed});
+        }
+    }
+} // namespace
+
+// one producer feeding the per-gate queues, which the workers drain in parallel
+static void BM_ExecutorScaling(benchmark::State & state) {
+    adc::Executor executor{static_cast<std::size_t>(state.range(0))};
+    const auto events = gateEvents(state.range(1) != 0);
+    // gates and their queues refer to themselves, so they are heap allocated to keep their addresses stable
+    std::vector<std::unique_ptr<Gate>> gates;
+    std::vector<std::unique_ptr<Queue>> queues;
+    for (std::size_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<Gate>());
+        queues.push_back(std::make_unique<Queue>(executor, *gates.back()));
+    }
+
+    for (auto _ : state) {
+        for (const auto & e : events) {
+            auto & queue = *queues[e.gateId];
+            std::visit(
+                [&](const auto & event) {
+                    while (!queue.post(event)) {
+                        std::this_thread::yield();
+                    }
+                },
+                e.event);
+        }
+        executor.waitIdle();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * events.size()));
+}
+BENCHMARK(BM_ExecutorScaling)->Apply(threadsAndSkew)->ArgNames({"threads", "skewed"})->UseRealTime();
+
+// the same stream processed inline on the calling thread, the baseline for the executor overhead
+static void BM_ExecutorBaseline(benchmark::State & state) {
+    const auto events = gateEvents(state.range(0) != 0);
+    std::vector<std::unique_ptr<Gate>> gates;
+    for (std::size_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<Gate>());
+    }
+
+    for (auto _ : state) {
+        for (const auto & e : events) {
+            gates[e.gateId]->process(e.event);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * events.size()));
+}
+BENCHMARK(BM_ExecutorBaseline)->Arg(0)->Arg(1)->ArgName("skewed");
@@ -0,0 +1,39 @@
+#include "AllocationCounter.h"
+#include "FSMAsyncPayments.h"
+
+#if ADC_COROUTINES
+
+#include <benchmark/benchmark.h>
+#include <deque>
+
+// every gate pays at once, so that range(0) payments are in flight together, then passes; events and resumptions run
+// on the executor
+static void BM_AsyncPayments(benchmark::State & state) {
+    GatewayStub gateway;
+    adc::Executor executor;
+    std::deque<fsm_async_payments::FSM> gates;
+    for (std::int64_t gateId = 0; gateId < state.range(0); ++gateId) {
+        gates.emplace_back(gateway, executor);
+    }
+    std::size_t allocations = 0;
+    for (auto _ : state) {
+        const auto before = allocationCount();
+        for (auto & fsm : gates) {
+            fsm.process(CardPresented{"1234"});
+        }
+        executor.waitIdle();
+        gateway.respond();
+        executor.waitIdle();
+        for (auto & fsm : gates) {
+            fsm.process(PersonPassed{});
+        }
+        executor.waitIdle();
+        allocations += allocationCount() - before;
+    }
+    const auto payments = state.iterations() * state.range(0);
+    state.SetItemsProcessed(payments);
+    state.counters["allocs/payment"] = static_cast<double>(allocations) / static_cast<double>(payments);
+}
+BENCHMARK(BM_AsyncPayments)->Arg(1000)->Arg(10000);
+
+#endif
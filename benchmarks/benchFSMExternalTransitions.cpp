@@ -0,0 +1,16 @@
+#include "FSMExternalTransitions.h"
+
+#include <benchmark/benchmark.h>
+
+static void BM_FSMExternalTransitions(benchmark::State & state) {
+    fsm_external_transitions::FSM fsm;
+    for (auto _ : state)
+        fsm.process(CardPresented{"1234"})
+            .process(Timeout{})
+            .process(Timeout{})
+            .process(TransactionSuccess{5, 25})
+            .process(Timeout{})
+            .process(PersonPassed{});
+}
+// Register the function as a benchmark
+BENCHMARK(BM_FSMExternalTransitions);
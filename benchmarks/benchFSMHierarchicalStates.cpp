@@ -0,0 +1,184 @@
+#include "FSM.h"
+
+#include <benchmark/benchmark.h>
+
+// The same machine twice: once with the handlers it shares declared on super-states, once with every leaf repeating
+// them. Both resolve to the same dispatch table, so they should cost the same per event.
+namespace {
+    struct Coin {};
+    struct Push {};
+    struct Fault {};
+    struct Repaired {};
+    struct Reset {};
+    struct Tick {};
+
+    namespace nested {
+        class Idle;
+        class Armed;
+        class Jammed;
+
+        class Powered {
+        public:
+            auto process(Reset) {
+                return adc::transitionTo<Idle>();
+            }
+            template <typename Event>
+            adc::NoTransition process(Event) {
+                return {};
+            }
+        };
+
+        class InService : public Powered {
+        public:
+            using Parent = Powered;
+
+            auto process(Fault) {
+                return adc::transitionTo<Jammed>();
+            }
+
+            auto process(Tick) {
+                return adc::transitionTo<Idle>();
+            }
+        };
+
+        class OutOfService : public Powered {
+        public:
+            using Parent = Powered;
+
+            auto process(Repaired) {
+                return adc::transitionTo<Idle>();
+            }
+        };
+
+        class Idle : public InService {
+        public:
+            using Parent = InService;
+
+            int getState() const {
+                return 0;
+            }
+
+            auto process(Coin) {
+                return adc::transitionTo<Armed>();
+            }
+        };
+
+        class Armed : public InService {
+        public:
+            using Parent = InService;
+
+            int getState() const {
+                return 1;
+            }
+
+            auto process(Push) {
+                return adc::transitionTo<Idle>();
+            }
+        };
+
+        class Jammed : public OutOfService {
+        public:
+            using Parent = OutOfService;
+
+            int getState() const {
+                return 2;
+            }
+        };
+
+        using FSM = adc::TFSMStateTransitions<Idle, Armed, Jammed>;
+    } // namespace nested
+
+    namespace flat {
+        class Idle;
+        class Armed;
+        class Jammed;
+
+        class Idle {
+        public:
+            int getState() const {
+                return 0;
+            }
+
+            auto process(Coin) {
+                return adc::transitionTo<Armed>();
+            }
+            auto process(Fault) {
+                return adc::transitionTo<Jammed>();
+            }
+            auto process(Tick) {
+                return adc::transitionTo<Idle>();
+            }
+            auto process(Reset) {
+                return adc::transitionTo<Idle>();
+            }
+            template <typename Event>
+            adc::NoTransition process(Event) {
+                return {};
+            }
+        };
+
+        class Armed {
+        public:
+            int getState() const {
+                return 1;
+            }
+
+            auto process(Push) {
+                return adc::transitionTo<Idle>();
+            }
+            auto process(Fault) {
+                return adc::transitionTo<Jammed>();
+            }
+            auto process(Tick) {
+                return adc::transitionTo<Idle>();
+            }
+            auto process(Reset) {
+                return adc::transitionTo<Idle>();
+            }
+            template <typename Event>
+            adc::NoTransition process(Event) {
+                return {};
+            }
+        };
+
+        class Jammed {
+        public:
+            int getState() const {
+                return 2;
+            }
+
+            auto process(Repaired) {
+                return adc::transitionTo<Idle>();
+            }
+            auto process(Reset) {
+                return adc::transitionTo<Idle>();
+            }
+            template <typename Event>
+            adc::NoTransition process(Event) {
+                return {};
+            }
+        };
+
+        using FSM = adc::TFSMStateTransitions<Idle, Armed, Jammed>;
+    } // namespace flat
+} // namespace
+
+// eight events a round, handled by leaves, parents, the root and nobody
+template <typename FSM, typename Idle>
+static void BM_HierarchicalStates(benchmark::State & state) {
+    FSM fsm{Idle{}};
+    for (auto _ : state) {
+        fsm.process(Coin{});
+        fsm.process(Tick{});
+        fsm.process(Coin{});
+        fsm.process(Push{});
+        fsm.process(Fault{});
+        fsm.process(Coin{});
+        fsm.process(Repaired{});
+        fsm.process(Reset{});
+        benchmark::DoNotOptimize(fsm);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 8);
+}
+BENCHMARK_TEMPLATE(BM_HierarchicalStates, flat::FSM, flat::Idle);
+BENCHMARK_TEMPLATE(BM_HierarchicalStates, nested::FSM, nested::Idle);
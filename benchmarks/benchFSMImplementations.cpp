@@ -0,0 +1,210 @@
+#include "AllocationCounter.h"
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+#include "FSMWithEnums.h"
+#include "FSMWithStatePattern.h"
+#include "FSMWithTransitionTable.h"
+#include "OldFSMExternalTransitions.h"
+#include "OldFSMStateTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::size_t STREAM_SIZE = 1 << 12;
+    // events each cold machine processes after construction
+    constexpr std::size_t COLD_EVENTS = 8;
+
+    enum class eStream { Mixed, NoOps, Declines, RetryStorm };
+
+    struct StreamInfo {
+        eStream stream;
+        const char * name;
+    };
+
+    constexpr StreamInfo STREAMS[] = {
+        {eStream::Mixed, "mixed"},
+        {eStream::NoOps, "no_ops"},
+        {eStream::Declines, "declines"},
+        {eStream::RetryStorm, "retry_storm"},
+    };
+
+    // Seeded random event streams, so that every implementation replays the same events. Strings fit the small string
+    // buffer, so that copying an event does not allocate and allocs/event only counts the engine.
+    //  - mixed: independent events, most of them no-ops for the current state
+    //  - no_ops: no card is ever presented, so the machine stays Locked and ignores everything
+    //  - declines: mostly declined payments, interleaved with stray events
+    //  - retry_storm: gateways timing out until the payment fails, with the occasional late approval
+    std::vector<AnyEvent> makeStream(eStream stream) {
+        std::mt19937 rng{static_cast<std::uint32_t>(stream) + 1};
+        std::bernoulli_distribution coin(0.2);
+        std::vector<AnyEvent> events;
+        events.reserve(STREAM_SIZE);
+        const auto stray = [&] {
+            switch (rng() % 3) {
+            case 0:
+                return AnyEvent{PersonPassed{}};
+            case 1:
+                return AnyEvent{TransactionSuccess{5, 25}};
+            default:
+                return AnyEvent{Timeout{}};
+            }
+        };
+        while (events.size() < STREAM_SIZE) {
+            switch (stream) {
+            case eStream::Mixed:
+                switch (std::discrete_distribution<int>({1, 1, 2, 3, 3})(rng)) {
+                case 0:
+                    events.emplace_back(CardPresented{"1234"});
+                    break;
+                case 1:
+                    events.emplace_back(TransactionDeclined{"No Funds"});
+                    break;
+                case 2:
+                    events.emplace_back(TransactionSuccess{5, 25});
+                    break;
+                case 3:
+                    events.emplace_back(PersonPassed{});
+                    break;
+                default:
+                    events.emplace_back(Timeout{});
+                    break;
+                }
+                break;
+            case eStream::NoOps:
+                events.push_back(coin(rng) ? AnyEvent{TransactionDeclined{"No Funds"}} : stray());
+                break;
+            case eStream::Declines:
+                if (coin(rng)) {
+                    events.push_back(stray());
+                }
+                events.emplace_back(CardPresented{"1234"});
+                if (coin(rng)) {
+                    events.emplace_back(TransactionSuccess{5, 25});
+                    events.emplace_back(PersonPassed{});
+                } else {
+                    events.emplace_back(TransactionDeclined{"No Funds"});
+                    events.emplace_back(Timeout{});
+                }
+                break;
+            case eStream::RetryStorm:
+                events.emplace_back(CardPresented{"1234"});
+                for (int retry = 0; retry < 4; ++retry) {
+                    events.emplace_back(Timeout{});
+                }
+                if (coin(rng)) {
+                    events.pop_back();
+                    events.emplace_back(TransactionSuccess{5, 25});
+                    events.emplace_back(PersonPassed{});
+                }
+                break;
+            }
+        }
+        events.resize(STREAM_SIZE);
+        return events;
+    }
+
+    const std::vector<AnyEvent> & streamOf(eStream stream) {
+        static const std::vector<AnyEvent> streams[] = {
+            makeStream(eStream::Mixed), makeStream(eStream::NoOps), makeStream(eStream::Declines),
+            makeStream(eStream::RetryStorm)};
+        return streams[static_cast<int>(stream)];
+    }
+
+    // not every implementation accepts a std::variant of events, so the alternative is picked here for all of them
+    template <typename FSM>
+    void process(FSM & fsm, const AnyEvent & event) {
+        std::visit(
+            [&](const auto & alternative) {
+                fsm.process(alternative);
+            },
+            event);
+        benchmark::DoNotOptimize(fsm);
+    }
+
+    // Selects the stream named by the first argument; see STREAMS for the order.
+    class TStreamFixture : public benchmark::Fixture {
+    public:
+        void SetUp(const benchmark::State & state) override {
+            _events = &streamOf(STREAMS[state.range(0)].stream);
+        }
+
+    protected:
+        const std::vector<AnyEvent> * _events{nullptr};
+    };
+
+    // one long-lived machine replaying the stream: the cost of dispatch and transitions once everything is warm
+    template <typename FSM>
+    class THotLoop : public TStreamFixture {
+    public:
+        void SetUp(const benchmark::State & state) override {
+            TStreamFixture::SetUp(state);
+            _fsm.emplace();
+        }
+
+        void TearDown(const benchmark::State & state) override {
+            _fsm.reset();
+        }
+
+    protected:
+        void run(benchmark::State & state) {
+            const auto allocations = allocationCount();
+            for (auto _ : state) {
+                for (const auto & event : *_events) {
+                    process(*_fsm, event);
+                }
+                benchmark::ClobberMemory();
+            }
+            const auto processed = state.iterations() * _events->size();
+            state.SetItemsProcessed(static_cast<std::int64_t>(processed));
+            state.counters["allocs/event"] =
+                static_cast<double>(allocationCount() - allocations) / static_cast<double>(processed);
+        }
+
+        std::optional<FSM> _fsm;
+    };
+
+    // a fresh machine per slice of the stream: construction, the first transitions and destruction
+    template <typename FSM>
+    class TColdStart : public TStreamFixture {
+    protected:
+        void run(benchmark::State & state) {
+            std::size_t offset = 0;
+            for (auto _ : state) {
+                FSM fsm;
+                for (std::size_t i = 0; i < COLD_EVENTS; ++i) {
+                    process(fsm, (*_events)[offset + i]);
+                }
+                offset = (offset + COLD_EVENTS) % _events->size();
+            }
+            state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * COLD_EVENTS));
+        }
+    };
+} // namespace
+
+// THotLoop<FSM>/<impl>/stream:<n> and TColdStart<FSM>/<impl>/stream:<n> over every stream of STREAMS
+#define BENCHMARK_IMPLEMENTATION(Name, Implementation)                                                                  \
+    BENCHMARK_TEMPLATE_DEFINE_F(THotLoop, Name, Implementation)(benchmark::State & state) {                            \
+        run(state);                                                                                                    \
+    }                                                                                                                  \
+    BENCHMARK_REGISTER_F(THotLoop, Name)                                                                               \
+        ->DenseRange(0, std::size(STREAMS) - 1)                                                                        \
+        ->ArgName("stream");                                                                                           \
+    BENCHMARK_TEMPLATE_DEFINE_F(TColdStart, Name, Implementation)(benchmark::State & state) {                          \
+        run(state);                                                                                                    \
+    }                                                                                                                  \
+    BENCHMARK_REGISTER_F(TColdStart, Name)                                                                             \
+        ->DenseRange(0, std::size(STREAMS) - 1)                                                                        \
+        ->ArgName("stream")
+
+BENCHMARK_IMPLEMENTATION(with_enums, with_enums::FSM);
+BENCHMARK_IMPLEMENTATION(with_state_pattern, with_state_pattern::FSM);
+BENCHMARK_IMPLEMENTATION(with_transition_table, with_transition_table::FSM);
+BENCHMARK_IMPLEMENTATION(old_state_transitions, old_fsm_state_transitions::FSM);
+BENCHMARK_IMPLEMENTATION(old_external_transitions, old_fsm_external_transitions::FSM);
+BENCHMARK_IMPLEMENTATION(state_transitions, fsm_state_transitions::FSM);
+BENCHMARK_IMPLEMENTATION(external_transitions, fsm_external_transitions::FSM);
@@ -0,0 +1,110 @@
+#include "FSM.h"
+#include "FSMStateTransitions.h"
+#include "OldFSMStateTransitions.h"
+
+#include <array>
+#include <benchmark/benchmark.h>
+
+namespace {
+    struct Ping {};
+
+    // A state large enough for the extra moves of the optional<variant> round-trip to show up.
+    template <int Id>
+    class TLargeState {
+    public:
+        explicit TLargeState(std::string name) : _name(std::move(name)) {
+            _payload.fill(Id);
+        }
+
+        int getState() const {
+            return Id;
+        }
+
+    protected:
+        std::string _name;
+        std::array<char, 512> _payload{};
+    };
+
+    class EmplacedA;
+    class EmplacedB;
+
+    class EmplacedA : public TLargeState<0> {
+    public:
+        using TLargeState::TLargeState;
+        auto process(Ping) {
+            return adc::transitionTo<EmplacedB>(std::move(_name));
+        }
+    };
+
+    class EmplacedB : public TLargeState<1> {
+    public:
+        using TLargeState::TLargeState;
+        auto process(Ping) {
+            return adc::transitionTo<EmplacedA>(std::move(_name));
+        }
+    };
+
+    class OptionalA;
+    class OptionalB;
+    using OptionalState = std::optional<std::variant<OptionalA, OptionalB>>;
+
+    class OptionalA : public TLargeState<0> {
+    public:
+        using TLargeState::TLargeState;
+        OptionalState process(Ping);
+    };
+
+    class OptionalB : public TLargeState<1> {
+    public:
+        using TLargeState::TLargeState;
+        OptionalState process(Ping) {
+            return OptionalA(std::move(_name));
+        }
+    };
+
+    OptionalState OptionalA::process(Ping) {
+        return OptionalB(std::move(_name));
+    }
+} // namespace
+
+static void BM_LargeStateOptionalTransitions(benchmark::State & state) {
+    adc::TFSMStateTransitions<OptionalA, OptionalB> fsm{std::in_place_type<OptionalA>, "a long enough card holder name"};
+    for (auto _ : state) {
+        fsm.process(Ping{});
+        benchmark::DoNotOptimize(fsm);
+    }
+}
+BENCHMARK(BM_LargeStateOptionalTransitions);
+
+static void BM_LargeStateEmplacedTransitions(benchmark::State & state) {
+    adc::TFSMStateTransitions<EmplacedA, EmplacedB> fsm{std::in_place_type<EmplacedA>, "a long enough card holder name"};
+    for (auto _ : state) {
+        fsm.process(Ping{});
+        benchmark::DoNotOptimize(fsm);
+    }
+}
+BENCHMARK(BM_LargeStateEmplacedTransitions);
+
+static void BM_TurnstileOptionalTransitions(benchmark::State & state) {
+    old_fsm_state_transitions::FSM fsm;
+    for (auto _ : state)
+        fsm.process(CardPresented{"1234"})
+            .process(TransactionDeclined{})
+            .process(Timeout{})
+            .process(CardPresented{"1234"})
+            .process(TransactionSuccess{5, 25})
+            .process(PersonPassed{});
+}
+BENCHMARK(BM_TurnstileOptionalTransitions);
+
+static void BM_TurnstileEmplacedTransitions(benchmark::State & state) {
+    fsm_state_transitions::FSM fsm;
+    for (auto _ : state)
+        fsm.process(CardPresented{"1234"})
+            .process(TransactionDeclined{})
+            .process(Timeout{})
+            .process(CardPresented{"1234"})
+            .process(TransactionSuccess{5, 25})
+            .process(PersonPassed{});
+}
+BENCHMARK(BM_TurnstileEmplacedTransitions);
@@ -0,0 +1,18 @@
+#include "FSMExternalTransitions.h"
+#include "FSMWithEnums.h"
+#include "OldFSMExternalTransitions.h"
+
+#include <benchmark/benchmark.h>
+
+// Events that every implementation ignores while Locked; measures the cost of dispatching a no-op.
+template <typename FSM>
+static void BM_NoOpDispatch(benchmark::State & state) {
+    FSM fsm;
+    for (auto _ : state) {
+        fsm.process(Timeout{}).process(PersonPassed{}).process(TransactionSuccess{5, 25}).process(Timeout{});
+        benchmark::DoNotOptimize(fsm);
+    }
+}
+BENCHMARK_TEMPLATE(BM_NoOpDispatch, with_enums::FSM);
+BENCHMARK_TEMPLATE(BM_NoOpDispatch, old_fsm_external_transitions::FSM);
+BENCHMARK_TEMPLATE(BM_NoOpDispatch, fsm_external_transitions::FSM);
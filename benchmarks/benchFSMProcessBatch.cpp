@@ -0,0 +1,39 @@
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+    const std::vector<AnyEvent> & turnstileSequence() {
+        static const std::vector<AnyEvent> events{
+            CardPresented{"1234"}, Timeout{}, Timeout{}, TransactionSuccess{5, 25}, Timeout{}, PersonPassed{}};
+        return events;
+    }
+} // namespace
+
+template <typename FSM>
+static void BM_PerEvent(benchmark::State & state) {
+    FSM fsm;
+    const auto & events = turnstileSequence();
+    for (auto _ : state) {
+        for (const auto & event : events) {
+            fsm.process(event);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+BENCHMARK_TEMPLATE(BM_PerEvent, fsm_state_transitions::FSM);
+BENCHMARK_TEMPLATE(BM_PerEvent, fsm_external_transitions::FSM);
+
+template <typename FSM>
+static void BM_Batch(benchmark::State & state) {
+    FSM fsm;
+    const auto & events = turnstileSequence();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fsm.processBatch(events));
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+BENCHMARK_TEMPLATE(BM_Batch, fsm_state_transitions::FSM);
+BENCHMARK_TEMPLATE(BM_Batch, fsm_external_transitions::FSM);
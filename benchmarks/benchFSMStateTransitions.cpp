@@ -5,7 +5,7 @@
 static void BM_FSMStateTransitions(benchmark::State & state) {
     fsm_state_transitions::FSM fsm;
     for (auto _ : state)
-        fsm.process(CardPresented{})
+        fsm.process(CardPresented{"1234"})
             .process(Timeout{})
             .process(Timeout{})
             .process(TransactionSuccess{5, 25})
@@ -0,0 +1,79 @@
+#include "Metrics.h"
+#include "Tracer.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+    struct Go {};
+    struct Stay {};
+
+    class Red;
+    class Green;
+
+    class Red {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Green>();
+        }
+        std::optional<adc::TTransition<Green>> process(Stay) {
+            return std::nullopt;
+        }
+        int getState() const {
+            return 0;
+        }
+    };
+
+    class Green {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Red>();
+        }
+        std::optional<adc::TTransition<Red>> process(Stay) {
+            return std::nullopt;
+        }
+        int getState() const {
+            return 1;
+        }
+    };
+} // namespace
+
+// a transition and an ignored event per iteration; NullTracer should match an engine without any tracing
+template <typename Tracer>
+static void BM_Tracing(benchmark::State & state) {
+    adc::TTracedFSMStateTransitions<Tracer, Red, Green> fsm{Red{}};
+    for (auto _ : state) {
+        fsm.process(Go{});
+        fsm.process(Stay{});
+        benchmark::DoNotOptimize(fsm);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+BENCHMARK_TEMPLATE(BM_Tracing, adc::NullTracer);
+BENCHMARK_TEMPLATE(BM_Tracing, adc::RingTracer);
+
+// the cost of metrics on the same traffic, alone and next to the ring tracer; the counters stay in the thread's shard
+static void BM_Metrics(benchmark::State & state) {
+    static const auto & series = adc::MetricsRegistry::instance().addSeries({"Red", "Green"}, {{"bench", "metrics"}});
+    adc::TTracedFSMStateTransitions<adc::MetricsTracer, Red, Green> fsm{Red{}};
+    fsm.tracer().attach(series);
+    for (auto _ : state) {
+        fsm.process(Go{});
+        fsm.process(Stay{});
+        benchmark::DoNotOptimize(fsm);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+BENCHMARK(BM_Metrics);
+
+static void BM_MetricsAndTracing(benchmark::State & state) {
+    static const auto & series = adc::MetricsRegistry::instance().addSeries({"Red", "Green"}, {{"bench", "both"}});
+    adc::TTracedFSMStateTransitions<adc::TTracers<adc::RingTracer, adc::MetricsTracer>, Red, Green> fsm{Red{}};
+    fsm.tracer().get<adc::MetricsTracer>().attach(series);
+    for (auto _ : state) {
+        fsm.process(Go{});
+        fsm.process(Stay{});
+        benchmark::DoNotOptimize(fsm);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+BENCHMARK(BM_MetricsAndTracing);
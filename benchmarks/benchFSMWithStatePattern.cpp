@@ -1,16 +1,20 @@
+#include "AllocationCounter.h"
 #include "FSMWithStatePattern.h"
 
 #include <benchmark/benchmark.h>
 
 static void BM_FSMWithStatePattern(benchmark::State & state) {
     with_state_pattern::FSM fsm;
+    const auto allocations = allocationCount();
     for (auto _ : state)
-        fsm.process(CardPresented{})
+        fsm.process(CardPresented{"1234"})
             .process(Timeout{})
             .process(Timeout{})
             .process(TransactionSuccess{5, 25})
             .process(Timeout{})
             .process(PersonPassed{});
+    state.counters["allocs/event"] =
+        static_cast<double>(allocationCount() - allocations) / static_cast<double>(state.iterations() * 6);
 }
 // Register the function as a benchmark
 BENCHMARK(BM_FSMWithStatePattern);
@@ -0,0 +1,94 @@
+#include "TurnstileFleet.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <vector>
+
+namespace {
+    constexpr std::size_t GATES = 8000;
+
+    std::filesystem::path journalDirectory(const char * name) {
+        auto directory = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(directory);
+        return directory;
+    }
+
+    // three events per passage: a card and its payment, then the person passing, or one gate in eight declined
+    void passage(fsm_fleet::Fleet & fleet, std::size_t gateId) {
+        fleet.process(gateId, CardPresented{"4000123412341234"});
+        if (gateId % 8 == 0) {
+            fleet.process(gateId, TransactionDeclined{"Insufficient Funds"}).process(gateId, Timeout{});
+        } else {
+            fleet.process(gateId, TransactionSuccess{5, 25}).process(gateId, PersonPassed{});
+        }
+    }
+
+    adc::JournalOptions benchOptions() {
+        adc::JournalOptions options;
+        options.segmentBytes = 16u << 20u;
+        return options;
+    }
+} // namespace
+
+// the cost on the caller's thread plus, on a single core, its share of the committing thread
+static void BM_JournalAppend(benchmark::State & state) {
+    const auto directory = journalDirectory("fsm_journal_bench_append");
+    {
+        TurnstileJournal journal{directory, "journal", benchOptions()};
+        std::size_t gateId = 0;
+        for (auto _ : state) {
+            journal.append(gateId, CardPresented{"4000123412341234"});
+            gateId = (gateId + 1) % GATES;
+        }
+        journal.flush();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_JournalAppend);
+
+static void BM_FleetPassage(benchmark::State & state) {
+    const bool journaled = state.range(0) != 0;
+    const auto directory = journalDirectory("fsm_journal_bench_fleet");
+    {
+        TurnstileJournal journal{directory, "journal", benchOptions()};
+        fsm_fleet::Fleet fleet{GATES};
+        if (journaled) {
+            fleet.setJournal(&journal);
+        }
+        std::size_t gateId = 0;
+        for (auto _ : state) {
+            passage(fleet, gateId);
+            gateId = (gateId + 1) % GATES;
+        }
+        journal.flush();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * 3);
+    state.SetLabel(journaled ? "journaled" : "plain");
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_FleetPassage)->Arg(0)->Arg(1);
+
+// one million events, replayed into a fresh fleet per iteration
+static void BM_JournalReplay(benchmark::State & state) {
+    const auto directory = journalDirectory("fsm_journal_bench_replay");
+    {
+        TurnstileJournal journal{directory, "journal", benchOptions()};
+        fsm_fleet::Fleet fleet{GATES};
+        fleet.setJournal(&journal);
+        for (std::size_t passages = 0; passages < 1000000 / 3; ++passages) {
+            passage(fleet, passages % GATES);
+        }
+    }
+    std::size_t events = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fsm_fleet::Fleet fleet{GATES};
+        TurnstileJournalReplay journal{directory};
+        state.ResumeTiming();
+        events += fleet.replay(journal);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_JournalReplay)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,68 @@
+#include "FSMWithStatePattern.h"
+#include "Logging.h"
+
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <string>
+
+namespace {
+    using FSM = with_state_pattern::FSM;
+
+    // discards the formatted output, so that only the logger itself is measured
+    class NullBuffer final : public std::streambuf {
+        int_type overflow(int_type ch) override {
+            return ch;
+        }
+    };
+} // namespace
+
+// the cost at a call site whose level is disabled: a branch, the arguments are not evaluated
+static void BM_LogDisabled(benchmark::State & state) {
+    adc::Logger::setLevel(adc::LogLevel::Off);
+    const std::string gateway = "VISA";
+    for (auto _ : state) {
+        logTransaction(gateway, "1234", 25);
+    }
+}
+BENCHMARK(BM_LogDisabled);
+
+// copying the arguments into the thread's buffer; it is drained untimed before it fills up, so that no record is
+// dropped and formatting is left out
+static void BM_LogEnabled(benchmark::State & state) {
+    NullBuffer buffer;
+    std::ostream sink{&buffer};
+    adc::Logger::setLevel(adc::LogLevel::Info);
+    adc::Logger::instance().start(sink, std::chrono::hours{1});
+    const std::string gateway = "VISA";
+    std::size_t written = 0;
+    for (auto _ : state) {
+        logTransaction(gateway, "1234", 25);
+        if (++written % 512 == 0) {
+            state.PauseTiming();
+            adc::Logger::instance().flush();
+            state.ResumeTiming();
+        }
+    }
+    adc::Logger::instance().stop();
+    adc::Logger::setLevel(adc::LogLevel::Off);
+}
+BENCHMARK(BM_LogEnabled);
+
+// a full cycle of the state pattern FSM, which logs each event, with logging off and on
+static void BM_LogFSMCycle(benchmark::State & state) {
+    NullBuffer buffer;
+    std::ostream sink{&buffer};
+    adc::Logger::setLevel(state.range(0) ? adc::LogLevel::Debug : adc::LogLevel::Off);
+    adc::Logger::instance().start(sink, std::chrono::milliseconds{1});
+    FSM fsm;
+    for (auto _ : state) {
+        fsm.process(CardPresented{"1234"});
+        fsm.process(TransactionSuccess{5, 25});
+        fsm.process(PersonPassed{});
+        logFSM(fsm);
+    }
+    adc::Logger::instance().stop();
+    adc::Logger::setLevel(adc::LogLevel::Off);
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 3));
+}
+BENCHMARK(BM_LogFSMCycle)->Arg(0)->Arg(1)->ArgName("logging");
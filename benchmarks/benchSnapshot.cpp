@@ -0,0 +1,79 @@
+#include "FSMExternalTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace {
+    using Gate = fsm_external_transitions::FSM;
+
+    constexpr std::size_t GATES = 100000;
+
+    std::string snapshotPath() {
+        return (std::filesystem::temp_directory_path() / "fsm_snapshot_bench.bin").string();
+    }
+
+    // every fourth gate in the middle of a payment, the others spread over the remaining states
+    std::vector<std::unique_ptr<Gate>> makeGates() {
+        std::vector<std::unique_ptr<Gate>> gates;
+        gates.reserve(GATES);
+        for (std::size_t id = 0; id < GATES; ++id) {
+            auto & gate = *gates.emplace_back(std::make_unique<Gate>());
+            switch (id % 4) {
+            case 0:
+                gate.process(CardPresented{"4000123412341234"}).process(Timeout{});
+                break;
+            case 1:
+                gate.process(CardPresented{"1234"}).process(TransactionDeclined{"No Funds"});
+                break;
+            case 2:
+                gate.process(CardPresented{"1234"}).process(TransactionSuccess{5, 25});
+                break;
+            default:
+                break;
+            }
+        }
+        return gates;
+    }
+
+    bool save(const std::vector<std::unique_ptr<Gate>> & gates) {
+        return adc::writeSnapshot(snapshotPath(), 1, gates.size(), [&](std::size_t id, adc::SnapshotWriter & out) {
+            gates[id]->save(out);
+        });
+    }
+} // namespace
+
+static void BM_SnapshotWrite(benchmark::State & state) {
+    const auto gates = makeGates();
+    for (auto _ : state) {
+        if (!save(gates)) {
+            state.SkipWithError("cannot write the snapshot");
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * GATES));
+    state.counters["bytes"] = static_cast<double>(std::filesystem::file_size(snapshotPath()));
+}
+BENCHMARK(BM_SnapshotWrite)->Unit(benchmark::kMillisecond);
+
+// mapping the file and restoring every gate into machines that already exist, as after a restart
+static void BM_SnapshotRestore(benchmark::State & state) {
+    auto gates = makeGates();
+    save(gates);
+    for (auto _ : state) {
+        const adc::SnapshotFile file{snapshotPath()};
+        const auto restored = file.restore(
+            [](std::size_t id, adc::SnapshotReader & in) {
+                return Gate::check(in);
+            },
+            [&](std::size_t id, adc::SnapshotReader & in) {
+                return gates[id]->restore(in);
+            });
+        if (!restored) {
+            state.SkipWithError("cannot restore the snapshot");
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * GATES));
+    std::filesystem::remove(snapshotPath());
+}
+BENCHMARK(BM_SnapshotRestore)->Unit(benchmark::kMillisecond);
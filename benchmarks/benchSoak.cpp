@@ -0,0 +1,126 @@
+#include "FSMStateTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr std::size_t GATES = 16;
+
+    // a timer owned by the traffic of one gate
+    class Trigger final : public adc::TimerNode {
+    public:
+        explicit Trigger(std::function<void()> fn) : _fn(std::move(fn)) {
+        }
+        Trigger(const Trigger & other) = delete;
+        Trigger & operator=(const Trigger & other) = delete;
+        ~Trigger() {
+            _source.cancel(*this);
+        }
+
+        void start(std::chrono::milliseconds duration) {
+            _source.schedule(*this, duration);
+        }
+
+    private:
+        void expire() override {
+            _fn();
+        }
+
+        std::function<void()> _fn;
+        adc::TimerSource & _source{adc::TimerSource::current()};
+    };
+
+    // Riders tapping at one gate with exponential inter-arrival times. The gateway answers after a random latency
+    // that exceeds the 2s timeout often enough to exercise the retries, declines some cards and loses some requests,
+    // and riders sometimes take longer than the 2s grace period to pass.
+    class GateTraffic {
+    public:
+        explicit GateTraffic(std::uint32_t seed) : _rng(seed) {
+            _tap.start(next(_interArrival));
+        }
+
+    private:
+        void tap() {
+            _fsm.process(CardPresented{"1234"});
+            if (_fsm.getState() == eState::PaymentProcessing && !_response.pending()) {
+                respondLater();
+            }
+            _tap.start(next(_interArrival));
+        }
+
+        void respond() {
+            if (_fsm.getState() != eState::PaymentProcessing) {
+                return;
+            }
+            switch (_outcome(_rng)) {
+            case 0:
+                _fsm.process(TransactionSuccess{5, 25});
+                _passage.start(next(_walk));
+                break;
+            case 1:
+                _fsm.process(TransactionDeclined{"Insufficient Funds"});
+                break;
+            default:
+                // lost; the next gateway is tried once the timeout fires
+                respondLater();
+                break;
+            }
+        }
+
+        void respondLater() {
+            _response.start(next(_latency));
+        }
+
+        void pass() {
+            _fsm.process(PersonPassed{});
+        }
+
+        template <typename Distribution>
+        std::chrono::milliseconds next(Distribution & distribution) {
+            return std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(distribution(_rng))};
+        }
+
+        std::mt19937 _rng;
+        std::exponential_distribution<> _interArrival{1.0 / 20000};
+        std::uniform_int_distribution<> _latency{50, 2500};
+        std::uniform_int_distribution<> _walk{500, 3000};
+        std::discrete_distribution<> _outcome{{90, 6, 4}};
+
+        fsm_state_transitions::FSM _fsm;
+        Trigger _tap{[this] {
+            tap();
+        }};
+        Trigger _response{[this] {
+            respond();
+        }};
+        Trigger _passage{[this] {
+            pass();
+        }};
+    };
+} // namespace
+
+// a full day of traffic per iteration in virtual time, with the timeouts of the states compiled in
+static void BM_SoakOneDay(benchmark::State & state) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    // traffic refers to itself, so it is heap allocated to keep its address stable
+    std::vector<std::unique_ptr<GateTraffic>> gates;
+    for (std::uint32_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<GateTraffic>(id));
+    }
+
+    std::size_t events = 0;
+    for (auto _ : state) {
+        // each expiry is one simulated event: a rider, a gateway response or a state timeout
+        events += clock.runFor(24h);
+    }
+    state.counters["events"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+    state.counters["simulated_s"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * std::chrono::seconds{24h}.count(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SoakOneDay)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,72 @@
+#include "FSMStateTransitions.h"
+#include "Strand.h"
+
+#include <benchmark/benchmark.h>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+    using Gate = fsm_state_transitions::FSM;
+
+    // the obvious alternative: every thread takes the lock and processes its event itself
+    class MutexGuarded {
+    public:
+        template <typename Event>
+        void post(Event event) {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _gate.process(std::move(event));
+        }
+
+    private:
+        std::mutex _mutex;
+        Gate _gate;
+    };
+
+    class Stranded {
+    public:
+        // Only a post finding another thread inside is refused, and that thread drains the mailbox before it leaves,
+        // so the retry ends. A post made from inside the strand is never refused and so never spins here.
+        template <typename Event>
+        void post(Event event) {
+            while (!_strand.post(event)) {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        using Strand = adc::TStrand<Gate, CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout>;
+
+        Gate _gate;
+        Strand _strand{_gate};
+    };
+
+    // every thread rides the same gate; the threads meet at the start and end of the loop, so thread 0 may set it up
+    // and tear it down
+    template <typename Target>
+    void rideSharedGate(benchmark::State & state) {
+        static std::optional<Target> target;
+        if (state.thread_index() == 0) {
+            target.emplace();
+        }
+        for (auto _ : state) {
+            target->post(CardPresented{"1234"});
+            target->post(TransactionSuccess{5, 25});
+            target->post(PersonPassed{});
+        }
+        if (state.thread_index() == 0) {
+            target.reset();
+        }
+        state.SetItemsProcessed(state.iterations() * 3);
+    }
+} // namespace
+
+static void BM_MutexGuardedGate(benchmark::State & state) {
+    rideSharedGate<MutexGuarded>(state);
+}
+BENCHMARK(BM_MutexGuardedGate)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+static void BM_StrandGate(benchmark::State & state) {
+    rideSharedGate<Stranded>(state);
+}
+BENCHMARK(BM_StrandGate)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
@@ -0,0 +1,36 @@
+#include "Tariff.h"
+
+#include <benchmark/benchmark.h>
+#include <ctime>
+
+namespace {
+    // getFare() as it was before the tariff service: the local time and a table lookup on every call
+    int legacyGetFare() {
+        const auto now = std::time(nullptr);
+        std::tm calTime{};
+#ifdef _WIN32
+        localtime_s(&calTime, &now);
+#else
+        localtime_r(&now, &calTime);
+#endif
+        const auto currentHour = calTime.tm_hour;
+        constexpr int rates[] = {3, 3, 3, 3, 3, 3, 7, 7, 7, 7, 5, 5, 5, 5, 5, 7, 7, 7, 5, 5, 5, 5, 3, 3};
+        return rates[currentHour % 24];
+    }
+} // namespace
+
+static void BM_LegacyGetFare(benchmark::State & state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacyGetFare());
+    }
+}
+BENCHMARK(BM_LegacyGetFare)->ThreadRange(1, 4)->UseRealTime();
+
+// the cached band, shared by all threads
+static void BM_TariffService(benchmark::State & state) {
+    static TariffService tariff;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tariff.fare());
+    }
+}
+BENCHMARK(BM_TariffService)->ThreadRange(1, 4)->UseRealTime();
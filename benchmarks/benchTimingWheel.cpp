@@ -0,0 +1,88 @@
+#include "TimingWheel.h"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr std::size_t OUTSTANDING = 100000;
+    constexpr std::uint64_t TIMEOUT_TICKS = 2000; // 2s at the default 1ms tick
+
+    struct TimeoutNode final : adc::TimerNode {
+        void expire() override {
+            ++expired;
+        }
+        std::size_t expired{0};
+    };
+
+    // 100k timers armed for 2s with deadlines spread over one second of arrivals
+    std::vector<std::uint64_t> deadlines() {
+        std::mt19937 rng{42};
+        std::uniform_int_distribution<std::uint64_t> arrival(0, 999);
+        std::vector<std::uint64_t> result(OUTSTANDING);
+        for (auto & deadline : result) {
+            deadline = arrival(rng) + TIMEOUT_TICKS;
+        }
+        return result;
+    }
+} // namespace
+
+static void BM_TimingWheelScheduleCancel(benchmark::State & state) {
+    const auto ticks = deadlines();
+    std::vector<TimeoutNode> timers(OUTSTANDING);
+    adc::TimingWheel wheel;
+    for (std::size_t i = 0; i < OUTSTANDING; ++i) {
+        wheel.schedule(timers[i], ticks[i]);
+    }
+    std::size_t i = 0;
+    for (auto _ : state) {
+        // the common case for turnstile timeouts: a pending timer cancelled and re-armed by the next event
+        auto & timer = timers[i];
+        wheel.cancel(timer);
+        wheel.schedule(timer, ticks[i]);
+        i = i + 1 < OUTSTANDING ? i + 1 : 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["wheel_bytes"] = sizeof(adc::TimingWheel);
+    state.counters["node_bytes"] = sizeof(adc::TimerNode);
+}
+BENCHMARK(BM_TimingWheelScheduleCancel);
+
+static void BM_TimingWheelExpire(benchmark::State & state) {
+    const auto ticks = deadlines();
+    std::vector<TimeoutNode> timers(OUTSTANDING);
+    for (auto _ : state) {
+        state.PauseTiming();
+        adc::TimingWheel wheel;
+        for (std::size_t i = 0; i < OUTSTANDING; ++i) {
+            wheel.schedule(timers[i], ticks[i]);
+        }
+        state.ResumeTiming();
+        adc::details::TimerLink expired;
+        wheel.advance(TIMEOUT_TICKS + 1000, expired);
+        while (const auto timer = adc::TimingWheel::takeFirst(expired)) {
+            static_cast<TimeoutNode *>(timer)->expire();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OUTSTANDING);
+}
+BENCHMARK(BM_TimingWheelExpire)->Unit(benchmark::kMillisecond);
+
+static void BM_TimerServiceScheduleCancel(benchmark::State & state) {
+    std::vector<TimeoutNode> timers(OUTSTANDING);
+    adc::TimerService service;
+    for (auto & timer : timers) {
+        service.schedule(timer, std::chrono::seconds{2});
+    }
+    std::size_t i = 0;
+    for (auto _ : state) {
+        service.schedule(timers[i], std::chrono::seconds{2});
+        i = i + 1 < OUTSTANDING ? i + 1 : 0;
+    }
+    for (auto & timer : timers) {
+        service.cancel(timer);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerServiceScheduleCancel);
@@ -0,0 +1,68 @@
+#include "AllocationCounter.h"
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+#include "FSMWithEnums.h"
+#include "FSMWithStatePattern.h"
+#include "FSMWithTransitionTable.h"
+#include "OldFSMExternalTransitions.h"
+#include "OldFSMStateTransitions.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace {
+    // a balance in cents, long enough that "Balance: ..." no longer fits a small string buffer
+    constexpr int BALANCE = 1234567;
+
+    // card, approval and passage, back to Locked; with read, the display reads the approval screen as well
+    template <typename FSM>
+    void approvedCycle(benchmark::State & state, bool read) {
+        FSM fsm;
+        const auto allocations = allocationCount();
+        for (auto _ : state) {
+            fsm.process(CardPresented{"1234"});
+            fsm.process(TransactionSuccess{5, BALANCE});
+            if (read) {
+                benchmark::DoNotOptimize(fsm.getPOS().getThirdRow());
+            }
+            fsm.process(PersonPassed{});
+            benchmark::DoNotOptimize(fsm);
+        }
+        state.counters["allocs/cycle"] =
+            static_cast<double>(allocationCount() - allocations) / static_cast<double>(state.iterations());
+    }
+
+    // card, decline and the timeout back to Locked
+    template <typename FSM>
+    void declinedCycle(benchmark::State & state) {
+        FSM fsm;
+        const auto allocations = allocationCount();
+        for (auto _ : state) {
+            fsm.process(CardPresented{"1234"});
+            fsm.process(TransactionDeclined{"No Funds"});
+            fsm.process(Timeout{});
+            benchmark::DoNotOptimize(fsm);
+        }
+        state.counters["allocs/cycle"] =
+            static_cast<double>(allocationCount() - allocations) / static_cast<double>(state.iterations());
+    }
+
+    template <typename FSM>
+    void registerImplementation(const std::string & name) {
+        const auto prefix = "BM_TurnstileCycle/" + name;
+        benchmark::RegisterBenchmark((prefix + "/approved").c_str(), &approvedCycle<FSM>, false);
+        benchmark::RegisterBenchmark((prefix + "/approved_read").c_str(), &approvedCycle<FSM>, true);
+        benchmark::RegisterBenchmark((prefix + "/declined").c_str(), &declinedCycle<FSM>);
+    }
+
+    const bool REGISTERED = [] {
+        registerImplementation<with_enums::FSM>("with_enums");
+        registerImplementation<with_state_pattern::FSM>("with_state_pattern");
+        registerImplementation<with_transition_table::FSM>("with_transition_table");
+        registerImplementation<old_fsm_state_transitions::FSM>("old_state_transitions");
+        registerImplementation<old_fsm_external_transitions::FSM>("old_external_transitions");
+        registerImplementation<fsm_state_transitions::FSM>("state_transitions");
+        registerImplementation<fsm_external_transitions::FSM>("external_transitions");
+        return true;
+    }();
+} // namespace
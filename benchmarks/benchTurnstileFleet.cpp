@@ -0,0 +1,99 @@
+#include "FSMStateTransitions.h"
+#include "TurnstileFleet.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr std::size_t GATES = 8000;
+
+    struct GateEvent {
+        std::size_t gateId;
+        AnyEvent event;
+    };
+
+    // mostly no-op traffic for random gates, seeded so that both engines see the same stream
+    const std::vector<GateEvent> & randomGateEvents() {
+        static const auto events = [] {
+            std::mt19937 rng{42};
+            std::uniform_int_distribution<std::size_t> gate(0, GATES - 1);
+            std::discrete_distribution<int> kind({1, 1, 2, 3, 3});
+            std::vector<GateEvent> result(1 << 16);
+            for (auto & e : result) {
+                e.gateId = gate(rng);
+                switch (kind(rng)) {
+                case 0:
+                    e.event = CardPresented{"1234"};
+                    break;
+                case 1:
+                    e.event = TransactionDeclined{"Insufficient Funds"};
+                    break;
+                case 2:
+                    e.event = TransactionSuccess{5, 25};
+                    break;
+                case 3:
+                    e.event = PersonPassed{};
+                    break;
+                default:
+                    e.event = Timeout{};
+                    break;
+                }
+            }
+            return result;
+        }();
+        return events;
+    }
+} // namespace
+
+static void BM_VectorOfFSMs(benchmark::State & state) {
+    // FSMs refer to themselves, so they are heap allocated to keep their addresses stable
+    std::vector<std::unique_ptr<fsm_state_transitions::FSM>> gates;
+    for (std::size_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<fsm_state_transitions::FSM>());
+    }
+    const auto & events = randomGateEvents();
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const auto & e = events[next++ & (events.size() - 1)];
+        gates[e.gateId]->process(e.event);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VectorOfFSMs);
+
+static void BM_FleetOfFSMs(benchmark::State & state) {
+    fsm_fleet::Fleet fleet{GATES};
+    const auto & events = randomGateEvents();
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const auto & e = events[next++ & (events.size() - 1)];
+        fleet.process(e.gateId, e.event);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FleetOfFSMs);
+
+static void BM_VectorOfFSMsBroadcastTimeout(benchmark::State & state) {
+    std::vector<std::unique_ptr<fsm_state_transitions::FSM>> gates;
+    for (std::size_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<fsm_state_transitions::FSM>());
+    }
+    for (auto _ : state) {
+        for (auto & gate : gates) {
+            gate->process(Timeout{});
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * GATES);
+}
+BENCHMARK(BM_VectorOfFSMsBroadcastTimeout);
+
+static void BM_FleetOfFSMsBroadcastTimeout(benchmark::State & state) {
+    fsm_fleet::Fleet fleet{GATES};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fleet.processAll(Timeout{}));
+    }
+    state.SetItemsProcessed(state.iterations() * GATES);
+}
+BENCHMARK(BM_FleetOfFSMsBroadcastTimeout);
@@ -0,0 +1,48 @@
+#include "AllocationCounter.h"
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+#include "FSMWithEnums.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+
+namespace {
+    constexpr std::size_t GATES = 1000000;
+
+    // a million gates, each holding a card in PaymentProcessing; what a gate costs in bytes and heap blocks
+    template <typename FSM>
+    void millionGates(benchmark::State & state) {
+        std::size_t allocations = 0;
+        for (auto _ : state) {
+            const auto before = allocationCount();
+            auto gates = std::make_unique<FSM[]>(GATES);
+            for (std::size_t gateId = 0; gateId < GATES; ++gateId) {
+                gates[gateId].process(CardPresented{"4000123412341234"});
+            }
+            allocations += allocationCount() - before;
+            benchmark::DoNotOptimize(gates.get());
+            state.PauseTiming();
+            gates.reset();
+            state.ResumeTiming();
+        }
+        state.counters["bytes/gate"] = static_cast<double>(sizeof(FSM));
+        // the event's own card number is counted, as it would be when arriving from the network
+        state.counters["allocs/gate"] =
+            static_cast<double>(allocations) / static_cast<double>(state.iterations() * GATES);
+        state.counters["MB"] = static_cast<double>(sizeof(FSM) * GATES) / (1 << 20);
+    }
+
+    template <typename FSM>
+    void registerImplementation(const std::string & name) {
+        benchmark::RegisterBenchmark(("BM_MillionGates/" + name).c_str(), &millionGates<FSM>)
+            ->Unit(benchmark::kMillisecond);
+    }
+
+    const bool REGISTERED = [] {
+        registerImplementation<with_enums::FSM>("with_enums");
+        registerImplementation<fsm_state_transitions::FSM>("state_transitions");
+        registerImplementation<fsm_external_transitions::FSM>("external_transitions");
+        return true;
+    }();
+} // namespace
@@ -0,0 +1,7 @@
+#include "FSMExternalTransitions.h"
+#include "ParityGate.h"
+
+// Fails when the engine with an external transition table is more than 5% slower than with_enums; see ParityGate.h.
+int main(int argc, char ** argv) {
+    return parity::gate<fsm_external_transitions::FSM>(argc, argv, "external_transitions");
+}
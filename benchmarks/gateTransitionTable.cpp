@@ -0,0 +1,7 @@
+#include "FSMWithTransitionTable.h"
+#include "ParityGate.h"
+
+// Fails when the transition table is more than 5% slower than with_enums; see ParityGate.h.
+int main(int argc, char ** argv) {
+    return parity::gate<with_transition_table::FSM>(argc, argv, "with_transition_table");
+}
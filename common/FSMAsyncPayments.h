@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GatewayStub.h"
+
+#if ADC_COROUTINES
+
+#include "Executor.h"
+#include "FSM.h"
+#include "Logging.h"
+#include "States.h"
+#include "Turnstile.h"
+
+#include <cassert>
+
+namespace fsm_async_payments {
+    class FSM;
+
+    using Locked = states::TLocked<FSM>;
+    using PaymentProcessing = states::TPaymentProcessing<FSM>;
+    using PaymentFailed = states::TPaymentFailed<FSM>;
+    using PaymentSuccess = states::TPaymentSuccess<FSM>;
+    using Unlocked = states::TUnlocked<FSM>;
+
+    // The turnstile of fsm_state_transitions with a gateway that answers: the transaction PaymentProcessing initiates
+    // co_awaits the gateway and feeds its reply back as the TransactionSuccess or TransactionDeclined event, instead
+    // of these arriving from elsewhere. Events, including the timeouts of its states, are posted to a serial queue on
+    // an Executor, and the coroutine is resumed through the same queue, so it only ever runs between the FSM's other
+    // events. Its frames come from a pool of the FSM. The devices and the state may only be read while the queue is
+    // idle, and so the FSM must be when destroyed; gateway calls still unanswered then are cancelled.
+    class FSM : private adc::Resumer {
+    public:
+        FSM(GatewayStub & gateway, adc::Executor & executor, std::size_t capacity = 16)
+            : _gateway(gateway)
+            , _fsm{std::in_place_type<Locked>, std::ref(*this)}
+            , _queue(executor, _delivery, capacity) {
+        }
+
+        FSM(const FSM & other) = delete;
+        FSM & operator=(const FSM & other) = delete;
+
+        ~FSM() {
+            _gateway.cancel(*this);
+            assert(_frames.live() == 0 && "a resumption was still queued");
+        }
+
+        // any thread; returns false when the queue is full
+        template <typename Event>
+        bool process(Event event) {
+            return _queue.post(std::move(event));
+        }
+
+        eState getState() const {
+            return _fsm.getState();
+        }
+
+        [[nodiscard]] SwingDoor & getDoor() {
+            return _door;
+        }
+
+        [[nodiscard]] POSTerminal & getPOS() {
+            return _pos;
+        }
+
+        [[nodiscard]] LEDController & getLED() {
+            return _led;
+        }
+
+        adc::FramePool & framePool() {
+            return _frames;
+        }
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+            authorize(gateway, card, amount);
+        }
+
+    private:
+        // where the queue delivers the events: to the machine, and resumptions to their coroutines
+        struct Delivery {
+            template <typename Event>
+            void process(Event event) {
+                fsm._fsm.process(std::move(event));
+            }
+
+            void process(adc::Resume resume) {
+                resume.handle.resume();
+            }
+
+            FSM & fsm;
+        };
+
+        bool resume(std::coroutine_handle<> handle) override {
+            return _queue.post(adc::Resume{handle});
+        }
+
+        // A reply to an earlier gateway, which timed out, may arrive after the retry; whichever comes first is taken
+        // and the other is ignored by the state the first led to. Resumed within a turn of the queue, the reply is
+        // processed at once rather than posted behind the events already waiting.
+        adc::AsyncAction authorize(std::string_view gateway, Pan card, int amount) {
+            auto reply = co_await _gateway.authorize(*this, gateway, card, amount);
+            std::visit(
+                [this](auto & event) {
+                    _fsm.process(std::move(event));
+                },
+                reply);
+        }
+
+        GatewayStub & _gateway;
+        adc::FramePool _frames;
+
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{""};
+        LEDController _led;
+        adc::TFSMStateTransitions<Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked> _fsm;
+        Delivery _delivery{*this};
+        adc::TSerialQueue<Delivery, CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout,
+            adc::Resume>
+            _queue;
+    };
+} // namespace fsm_async_payments
+
+#endif
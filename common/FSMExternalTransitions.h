@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
 #include "FSM.h"
 #include "States.h"
 #include "Turnstile.h"
@@ -17,51 +17,75 @@ namespace fsm_external_transitions {
     using OptState = std::optional<State>;
 
     struct TransitionTable {
-        OptState operator()(Locked & state, CardPresented event) {
-            return PaymentProcessing(state._context, std::move(event.cardNumber));
+        std::optional<states::TToPaymentProcessing<FSM>> operator()(Locked & state, const CardPresented & event) {
+            if (const auto card = Pan::parse(event.cardNumber)) {
+                return adc::transitionTo<PaymentProcessing>(state._context, *card);
+            }
+            return std::nullopt;
         }
-        OptState operator()(PaymentProcessing & state, TransactionDeclined event) {
-            return PaymentFailed(state._context, std::move(event.reason));
+        states::TToPaymentFailed<FSM> operator()(PaymentProcessing & state, const TransactionDeclined & event) {
+            return adc::transitionTo<PaymentFailed>(state._context, std::string_view{event.reason});
         }
-        OptState operator()(PaymentProcessing & state, TransactionSuccess event) {
-            return PaymentSuccess(state._context, event.fare, event.balance);
+        auto operator()(PaymentProcessing & state, TransactionSuccess event) {
+            return adc::transitionTo<PaymentSuccess>(state._context, event.fare, event.balance);
         }
-        OptState operator()(PaymentProcessing & state, Timeout event) {
-            return state.tryRetry() ? OptState{} : PaymentFailed(state._context, "Network Failure");
+        std::optional<states::TToPaymentFailed<FSM>> operator()(PaymentProcessing & state, Timeout event) {
+            if (state.tryRetry()) {
+                return std::nullopt;
+            }
+            return adc::transitionTo<PaymentFailed>(state._context, "Network Failure");
         }
-        OptState operator()(PaymentFailed & state, Timeout) {
-            return Locked(state._context);
+        auto operator()(PaymentFailed & state, Timeout) {
+            return adc::transitionTo<Locked>(state._context);
         }
-        OptState operator()(PaymentSuccess & state, Timeout) {
-            return Unlocked(state._context);
+        auto operator()(PaymentSuccess & state, Timeout) {
+            return adc::transitionTo<Unlocked>(state._context);
         }
-        OptState operator()(PaymentSuccess & state, PersonPassed) {
-            return Locked(state._context);
+        auto operator()(PaymentSuccess & state, PersonPassed) {
+            return adc::transitionTo<Locked>(state._context);
         }
-        OptState operator()(Unlocked & state, PersonPassed) {
-            return Locked(state._context);
+        auto operator()(Unlocked & state, PersonPassed) {
+            return adc::transitionTo<Locked>(state._context);
         }
         template <typename State, typename Event>
         auto operator()(State & s, Event e) const {
-            return OptState{};
+            return adc::NoTransition{};
         }
     };
 
     class FSM {
     public:
-        FSM() : _fsm{TransitionTable{}, Locked{std::ref(*this)}} {
+        FSM() : _fsm{TransitionTable{}, std::in_place_type<Locked>, std::ref(*this)} {
         }
 
         template <typename Event>
-        FSM & process(Event event) {
-            _fsm.process(std::move(event));
+        FSM & process(Event && event) {
+            _fsm.process(std::forward<Event>(event));
             return *this;
         }
 
+        template <typename Events>
+        std::size_t processBatch(Events && events) {
+            return _fsm.processBatch(std::forward<Events>(events));
+        }
+
         eState getState() const {
             return _fsm.getState();
         }
 
+        void save(adc::SnapshotWriter & out) const {
+            _fsm.save(out);
+        }
+
+        // the devices are set up by the restored state
+        bool restore(adc::SnapshotReader & in) {
+            return _fsm.restore(in, std::ref(*this));
+        }
+
+        static bool check(adc::SnapshotReader & in) {
+            return decltype(_fsm)::check(in);
+        }
+
         [[nodiscard]] SwingDoor & getDoor() {
             return _door;
         }
@@ -75,9 +99,11 @@ namespace fsm_external_transitions {
         }
 
         // External Actions
-        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
-            logTransaction(gateway, cardNum, amount);
-            _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+#if RECORD_LAST_TRANSACTION
+            _lastTransaction = std::make_tuple(gateway, std::string{card.text().view()}, amount);
+#endif
         }
 
     private:
@@ -89,6 +115,7 @@ namespace fsm_external_transitions {
             TransitionTable, Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked>
             _fsm;
 
+#if RECORD_LAST_TRANSACTION
         // for testing
         std::tuple<std::string, std::string, int> _lastTransaction;
 
@@ -96,5 +123,6 @@ namespace fsm_external_transitions {
         const auto & getLastTransaction() const {
             return _lastTransaction;
         }
+#endif
     };
 } // namespace fsm_external_transitions
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
 #include "FSM.h"
 #include "States.h"
 #include "Turnstile.h"
@@ -18,19 +18,37 @@ namespace fsm_state_transitions {
 
     class FSM {
     public:
-        FSM() : _fsm{Locked{std::ref(*this)}} {
+        FSM() : _fsm{std::in_place_type<Locked>, std::ref(*this)} {
         }
 
         template <typename Event>
-        FSM & process(Event event) {
-            _fsm.process(std::move(event));
+        FSM & process(Event && event) {
+            _fsm.process(std::forward<Event>(event));
             return *this;
         }
 
+        template <typename Events>
+        std::size_t processBatch(Events && events) {
+            return _fsm.processBatch(std::forward<Events>(events));
+        }
+
         eState getState() const {
             return _fsm.getState();
         }
 
+        void save(adc::SnapshotWriter & out) const {
+            _fsm.save(out);
+        }
+
+        // the devices are set up by the restored state
+        bool restore(adc::SnapshotReader & in) {
+            return _fsm.restore(in, std::ref(*this));
+        }
+
+        static bool check(adc::SnapshotReader & in) {
+            return decltype(_fsm)::check(in);
+        }
+
         [[nodiscard]] SwingDoor & getDoor() {
             return _door;
         }
@@ -44,9 +62,11 @@ namespace fsm_state_transitions {
         }
 
         // External Actions
-        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
-            logTransaction(gateway, cardNum, amount);
-            _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+#if RECORD_LAST_TRANSACTION
+            _lastTransaction = std::make_tuple(gateway, std::string{card.text().view()}, amount);
+#endif
         }
 
     private:
@@ -56,6 +76,7 @@ namespace fsm_state_transitions {
         LEDController _led;
         adc::TFSMStateTransitions<Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked> _fsm;
 
+#if RECORD_LAST_TRANSACTION
         // for testing
         std::tuple<std::string, std::string, int> _lastTransaction;
 
@@ -63,5 +84,19 @@ namespace fsm_state_transitions {
         const auto & getLastTransaction() const {
             return _lastTransaction;
         }
+#endif
     };
+
+    // what a machine may take in a fleet of a million, on 64-bit targets; the test-only last transaction comes on top
+#if DISABLE_TIMEOUT_MANAGER
+    inline constexpr std::size_t FSM_BYTES = 144;
+#else
+    inline constexpr std::size_t FSM_BYTES = 208;
+#endif
+#if RECORD_LAST_TRANSACTION
+    inline constexpr std::size_t RECORDED_BYTES = sizeof(std::tuple<std::string, std::string, int>);
+#else
+    inline constexpr std::size_t RECORDED_BYTES = 0;
+#endif
+    static_assert(sizeof(void *) != 8 || sizeof(FSM) <= FSM_BYTES + RECORDED_BYTES, "the turnstile outgrew its budget");
 } // namespace fsm_state_transitions
\ No newline at end of file
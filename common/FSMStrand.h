@@ -0,0 +1,112 @@
+#pragma once
+
+#include "FSM.h"
+#include "Logging.h"
+#include "States.h"
+#include "Strand.h"
+#include "Turnstile.h"
+
+#include <cstdint>
+
+namespace fsm_strand {
+    class FSM;
+
+    using Locked = states::TLocked<FSM>;
+    using PaymentProcessing = states::TPaymentProcessing<FSM>;
+    using PaymentFailed = states::TPaymentFailed<FSM>;
+    using PaymentSuccess = states::TPaymentSuccess<FSM>;
+    using Unlocked = states::TUnlocked<FSM>;
+
+    // The turnstile of fsm_state_transitions, safe to drive from any number of threads: the card reader, the gateway
+    // and the timers of its states all post into one strand, which processes their events one at a time. The devices
+    // and the state may only be read while no event is under way, and so the FSM must be when destroyed.
+    //
+    // A timer may fire while another thread is inside, making the transition which cancels it; its Timeout then waits
+    // in the strand until after the transition. It is therefore posted with the generation of the timeout that fired,
+    // and dropped if that was armed before the FSM last left a state.
+    class FSM {
+    public:
+        explicit FSM(std::size_t capacity = 1024)
+            : _fsm{std::in_place_type<Locked>, std::ref(*this)}, _delivery{*this}, _strand(_delivery, capacity) {
+        }
+
+        // any thread; false if the event was dropped, finding another thread inside and the mailbox full
+        template <typename Event>
+        bool process(Event event) {
+            return _strand.post(std::move(event));
+        }
+
+        bool process(Timeout event) {
+            if (const auto generation = TimeoutManager::expiringGeneration()) {
+                return _strand.post(Expired{generation});
+            }
+            return _strand.post(event);
+        }
+
+        eState getState() const {
+            return _fsm.getState();
+        }
+
+        [[nodiscard]] SwingDoor & getDoor() {
+            return _door;
+        }
+
+        [[nodiscard]] POSTerminal & getPOS() {
+            return _pos;
+        }
+
+        [[nodiscard]] LEDController & getLED() {
+            return _led;
+        }
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+        }
+
+    private:
+        // the Timeout of a timer of the FSM's states, posted by the timer
+        struct Expired {
+            std::uint64_t generation;
+        };
+
+        // Notes, before a state is left and its timer cancelled, the first generation a timer of the next state can
+        // have. The states only ever transition by adc::transitionTo, which constructs the next state after this.
+        struct TimeoutFence : adc::NullTracer {
+            void onExit(std::size_t state) {
+                validFrom = TimeoutManager::nextGeneration();
+            }
+
+            std::uint64_t validFrom{0};
+        };
+
+        using Machine =
+            adc::TTracedFSMStateTransitions<TimeoutFence, Locked, PaymentProcessing, PaymentFailed, PaymentSuccess,
+                Unlocked>;
+
+        // where the strand delivers the events
+        struct Delivery {
+            template <typename Event>
+            void process(Event event) {
+                fsm._fsm.process(std::move(event));
+            }
+
+            void process(Expired event) {
+                if (event.generation >= fsm._fsm.tracer().validFrom) {
+                    fsm._fsm.process(Timeout{});
+                }
+            }
+
+            FSM & fsm;
+        };
+
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{""};
+        LEDController _led;
+        Machine _fsm;
+        Delivery _delivery;
+        adc::TStrand<Delivery, CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout, Expired>
+            _strand;
+    };
+} // namespace fsm_strand
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
+#include "Pan.h"
 #include "Turnstile.h"
 
 #include <array>
@@ -23,8 +24,8 @@ namespace with_enums {
         void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount);
 
         // helper functions
-        void transitionToPaymentProcessing(const std::string & gateway, std::string cardNumber);
-        void transitionToPaymentFailed(const std::string & reason);
+        void transitionToPaymentProcessing(const std::string & gateway, std::string && cardNumber);
+        void transitionToPaymentFailed(std::string_view reason);
         void transitionToLocked();
         void transitionToPaymentSuccessful(int fare, int balance);
         void transitionToUnlocked();
@@ -33,19 +34,23 @@ namespace with_enums {
 
         // Connected Devices
         SwingDoor _door;
-        POSTerminal _pos{"Touch Card"};
+        POSTerminal _pos{POSTerminal::TOUCH_CARD};
         LEDController _led;
 
         int _retryCounts{0};
         std::string _cardNumber{};
 
+#if RECORD_LAST_TRANSACTION
         // for testing
         std::tuple<std::string, std::string, int> _lastTransaction;
+#endif
 
     public:
+#if RECORD_LAST_TRANSACTION
         [[nodiscard]] const auto & getLastTransaction() const {
             return _lastTransaction;
         }
+#endif
 
         [[nodiscard]] const SwingDoor & getDoor() const {
             return _door;
@@ -61,10 +66,13 @@ namespace with_enums {
     };
 
     inline FSM & FSM::process(CardPresented event) {
-        LOGGER << "EVENT: CardPresent\n";
+        ADC_LOG(Debug, "EVENT: CardPresent");
         switch (_state) { // NOLINT(clang-diagnostic-switch-enum)
         case eState::Locked:
-            transitionToPaymentProcessing(GATEWAYS[0], std::move(event.cardNumber));
+            // a card whose number cannot be read is ignored
+            if (Pan::parse(event.cardNumber)) {
+                transitionToPaymentProcessing(GATEWAYS[0], std::move(event.cardNumber));
+            }
             break;
 
         default:
@@ -74,7 +82,7 @@ namespace with_enums {
     }
 
     inline FSM & FSM::process(TransactionDeclined event) {
-        LOGGER << "EVENT: TransactionDeclined\n";
+        ADC_LOG(Debug, "EVENT: TransactionDeclined");
         switch (_state) { // NOLINT(clang-diagnostic-switch-enum)
         case eState::PaymentProcessing:
             transitionToPaymentFailed(event.reason);
@@ -86,7 +94,7 @@ namespace with_enums {
     }
 
     inline FSM & FSM::process(TransactionSuccess event) {
-        LOGGER << "EVENT: TransactionSuccess\n";
+        ADC_LOG(Debug, "EVENT: TransactionSuccess");
         switch (_state) { // NOLINT(clang-diagnostic-switch-enum)
         case eState::PaymentProcessing:
             transitionToPaymentSuccessful(event.fare, event.balance);
@@ -98,7 +106,7 @@ namespace with_enums {
     }
 
     inline FSM & FSM::process(PersonPassed event) {
-        LOGGER << "EVENT: PersonPassed\n";
+        ADC_LOG(Debug, "EVENT: PersonPassed");
         switch (_state) { // NOLINT(clang-diagnostic-switch-enum)
         case eState::PaymentSuccess:
         case eState::Unlocked:
@@ -111,7 +119,7 @@ namespace with_enums {
     }
 
     inline FSM & FSM::process(Timeout event) {
-        LOGGER << "EVENT: Timeout\n";
+        ADC_LOG(Debug, "EVENT: Timeout");
         switch (_state) { // NOLINT(clang-diagnostic-switch-enum)
         case eState::PaymentProcessing:
             _retryCounts++;
@@ -136,22 +144,24 @@ namespace with_enums {
 
     inline void FSM::initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
         logTransaction(gateway, cardNum, amount);
+#if RECORD_LAST_TRANSACTION
         _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+#endif
     }
 
-    inline void FSM::transitionToPaymentProcessing(const std::string & gateway, std::string cardNumber) {
+    inline void FSM::transitionToPaymentProcessing(const std::string & gateway, std::string && cardNumber) {
         _retryCounts = 0;
         _cardNumber = std::move(cardNumber);
         initiateTransaction(gateway, _cardNumber, getFare());
         _door.close();
-        _pos.setRows("Processing");
+        _pos.show(POSTerminal::eMessage::Processing);
         _led.setStatus(LEDController::eStatus::OrangeCross);
         _state = eState::PaymentProcessing;
     }
 
-    inline void FSM::transitionToPaymentFailed(const std::string & reason) {
+    inline void FSM::transitionToPaymentFailed(std::string_view reason) {
         _door.close();
-        _pos.setRows("Declined", reason);
+        _pos.show(POSTerminal::eMessage::Declined, reason);
         _led.setStatus(LEDController::eStatus::FlashRedCross);
         _state = eState::PaymentFailed;
     }
@@ -159,23 +169,21 @@ namespace with_enums {
     inline void FSM::transitionToLocked() {
         _state = eState::Locked;
         _door.close();
-        _pos.setRows("Touch Card");
+        _pos.show(POSTerminal::eMessage::TouchCard);
         _led.setStatus(LEDController::eStatus::RedCross);
     }
 
     inline void FSM::transitionToPaymentSuccessful(int fare, int balance) {
         _state = eState::PaymentSuccess;
         _door.open();
-        _pos.setRows(
-            "Approved", std::string("Fare: ") + std::to_string(fare),
-            std::string("Balance: ") + std::to_string(balance));
+        _pos.show(POSTerminal::eMessage::Paid, fare, balance);
         _led.setStatus(LEDController::eStatus::GreenArrow);
     }
 
     inline void FSM::transitionToUnlocked() {
         _state = eState::Unlocked;
         _door.open();
-        _pos.setRows("Approved");
+        _pos.show(POSTerminal::eMessage::Approved);
         _led.setStatus(LEDController::eStatus::GreenArrow);
     }
 } // namespace with_enums
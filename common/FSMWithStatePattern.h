@@ -1,55 +1,25 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
+#include "Pan.h"
 #include "Turnstile.h"
 
+#include <algorithm>
 #include <array>
+#include <memory>
+#include <new>
 
 namespace with_state_pattern {
     using namespace std::chrono_literals;
 
+    class FSM;
     class BaseState;
 
-    class FSM {
-    public:
-        FSM();
-
-        template <typename Event>
-        FSM & process(Event && event);
-
-        [[nodiscard]] eState getState() const;
-
-        [[nodiscard]] SwingDoor & getDoor() {
-            return _door;
-        }
-
-        [[nodiscard]] POSTerminal & getPOS() {
-            return _pos;
-        }
-
-        [[nodiscard]] LEDController & getLED() {
-            return _led;
-        }
-
-        // External Actions
-        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount);
-
-    private:
-        // Connected Devices
-        SwingDoor _door;
-        POSTerminal _pos{""};
-        LEDController _led;
-
-        std::unique_ptr<BaseState> _state;
-
-        // for testing
-        std::tuple<std::string, std::string, int> _lastTransaction;
-
-    public:
-        [[nodiscard]] const auto & getLastTransaction() const {
-            return _lastTransaction;
-        }
+    // destroys a state in place, its storage belongs to the FSM
+    struct StateDeleter {
+        void operator()(BaseState * state) const;
     };
+    using StatePtr = std::unique_ptr<BaseState, StateDeleter>;
 
     class BaseState {
     public:
@@ -65,19 +35,19 @@ namespace with_state_pattern {
         virtual eState state() = 0;
 
         // event handlers
-        virtual std::unique_ptr<BaseState> process(CardPresented event) {
+        virtual StatePtr process(CardPresented event) {
             return nullptr;
         }
-        virtual std::unique_ptr<BaseState> process(TransactionDeclined event) {
+        virtual StatePtr process(TransactionDeclined event) {
             return nullptr;
         }
-        virtual std::unique_ptr<BaseState> process(TransactionSuccess event) {
+        virtual StatePtr process(TransactionSuccess event) {
             return nullptr;
         }
-        virtual std::unique_ptr<BaseState> process(PersonPassed event) {
+        virtual StatePtr process(PersonPassed event) {
             return nullptr;
         }
-        virtual std::unique_ptr<BaseState> process(Timeout event) {
+        virtual StatePtr process(Timeout event) {
             return nullptr;
         }
 
@@ -92,7 +62,7 @@ namespace with_state_pattern {
         eState state() override {
             return eState::Locked;
         }
-        std::unique_ptr<BaseState> process(CardPresented event) override;
+        StatePtr process(CardPresented event) override;
     };
 
     class PaymentProcessing final : public BaseState {
@@ -102,14 +72,16 @@ namespace with_state_pattern {
         eState state() override {
             return eState::PaymentProcessing;
         }
-        std::unique_ptr<BaseState> process(TransactionDeclined event) override;
-        std::unique_ptr<BaseState> process(TransactionSuccess event) override;
-        std::unique_ptr<BaseState> process(Timeout event) override;
+        StatePtr process(TransactionDeclined event) override;
+        StatePtr process(TransactionSuccess event) override;
+        StatePtr process(Timeout event) override;
 
     private:
         size_t _retryCount{0};
         std::string _cardNumber;
+#if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
+#endif
     };
 
     class PaymentFailed final : public BaseState {
@@ -120,11 +92,13 @@ namespace with_state_pattern {
             return eState::PaymentFailed;
         }
 
-        std::unique_ptr<BaseState> process(Timeout event) override;
+        StatePtr process(Timeout event) override;
 
     private:
         std::string _reason;
+#if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
+#endif
     };
 
     class PaymentSuccess final : public BaseState {
@@ -134,11 +108,13 @@ namespace with_state_pattern {
         eState state() override {
             return eState::PaymentSuccess;
         }
-        std::unique_ptr<BaseState> process(PersonPassed event) override;
-        std::unique_ptr<BaseState> process(Timeout event) override;
+        StatePtr process(PersonPassed event) override;
+        StatePtr process(Timeout event) override;
 
     private:
+#if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
+#endif
     };
 
     class Unlocked final : public BaseState {
@@ -148,19 +124,92 @@ namespace with_state_pattern {
         eState state() override {
             return eState::Unlocked;
         }
-        std::unique_ptr<BaseState> process(PersonPassed event) override;
+        StatePtr process(PersonPassed event) override;
+    };
+
+    class FSM {
+    public:
+        FSM();
+
+        template <typename Event>
+        FSM & process(Event && event);
+
+        [[nodiscard]] eState getState() const;
+
+        [[nodiscard]] SwingDoor & getDoor() {
+            return _door;
+        }
+
+        [[nodiscard]] POSTerminal & getPOS() {
+            return _pos;
+        }
+
+        [[nodiscard]] LEDController & getLED() {
+            return _led;
+        }
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount);
+
+        // constructs the state a handler transitions to in the storage the current state does not occupy
+        template <typename State, typename... Args>
+        StatePtr makeState(Args &&... args);
+
+    private:
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{""};
+        LEDController _led;
+
+        // The current state and the one being entered live side by side, as the handler creating the next state runs
+        // on the current one. Transitions flip between the two buffers and never allocate.
+        static constexpr std::size_t STATE_SIZE = std::max(
+            {sizeof(Locked), sizeof(PaymentProcessing), sizeof(PaymentFailed), sizeof(PaymentSuccess),
+             sizeof(Unlocked)});
+        static constexpr std::size_t STATE_ALIGN = std::max(
+            {alignof(Locked), alignof(PaymentProcessing), alignof(PaymentFailed), alignof(PaymentSuccess),
+             alignof(Unlocked)});
+        struct StateStorage {
+            alignas(STATE_ALIGN) unsigned char bytes[STATE_SIZE];
+        };
+
+        std::array<StateStorage, 2> _storage;
+        std::size_t _spare{0};
+        StatePtr _state;
+
+#if RECORD_LAST_TRANSACTION
+        // for testing
+        std::tuple<std::string, std::string, int> _lastTransaction;
+
+    public:
+        [[nodiscard]] const auto & getLastTransaction() const {
+            return _lastTransaction;
+        }
+#endif
     };
 
     template <typename Event>
     FSM & FSM::process(Event && event) {
-        LOGGER << "EVENT: " << type_name<std::decay_t<Event>>() << "\n";
+        ADC_LOG(Debug, "EVENT: {}", type_name<std::decay_t<Event>>());
         if (auto newState = _state->process(std::forward<Event>(event))) {
             _state = std::move(newState);
+            _spare ^= 1;
         }
         return *this;
     }
 
-    inline FSM::FSM() : _state(std::make_unique<Locked>(std::ref(*this))) {
+    inline FSM::FSM() : _state(makeState<Locked>(std::ref(*this))) {
+        _spare ^= 1;
+    }
+
+    template <typename State, typename... Args>
+    StatePtr FSM::makeState(Args &&... args) {
+        static_assert(sizeof(State) <= STATE_SIZE && alignof(State) <= STATE_ALIGN, "state does not fit the storage");
+        return StatePtr{new (_storage[_spare].bytes) State(std::forward<Args>(args)...)};
+    }
+
+    inline void StateDeleter::operator()(BaseState * state) const {
+        state->~BaseState();
     }
 
     inline eState FSM::getState() const {
@@ -169,101 +218,116 @@ namespace with_state_pattern {
 
     inline void FSM::initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
         logTransaction(gateway, cardNum, amount);
+#if RECORD_LAST_TRANSACTION
         _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+#endif
     }
 
     inline Locked::Locked(std::reference_wrapper<FSM> context) : BaseState(context) {
         auto & fsm = _context.get();
         fsm.getDoor().close();
         fsm.getLED().setStatus(LEDController::eStatus::RedCross);
-        fsm.getPOS().setRows("Touch Card");
+        fsm.getPOS().show(POSTerminal::eMessage::TouchCard);
     }
 
-    inline std::unique_ptr<BaseState> Locked::process(CardPresented event) {
-        return std::make_unique<PaymentProcessing>(_context, std::move(event.cardNumber));
+    // a card whose number cannot be read is ignored
+    inline StatePtr Locked::process(CardPresented event) {
+        if (!Pan::parse(event.cardNumber)) {
+            return nullptr;
+        }
+        return _context.get().makeState<PaymentProcessing>(_context, std::move(event.cardNumber));
     }
 
     inline PaymentProcessing::PaymentProcessing(std::reference_wrapper<FSM> context, std::string cardNumber)
         : BaseState(context)
         , _cardNumber(std::move(cardNumber))
+#if !DISABLE_TIMEOUT_MANAGER
         , _timeoutManager(
-              [&] {
-                  process(Timeout{});
+              [context] {
+                  context.get().process(Timeout{});
               },
-              2s) {
+              2s)
+#endif
+    {
         auto & fsm = _context.get();
         fsm.getDoor().close();
         fsm.getLED().setStatus(LEDController::eStatus::OrangeCross);
-        fsm.getPOS().setRows("Processing");
+        fsm.getPOS().show(POSTerminal::eMessage::Processing);
         fsm.initiateTransaction(GATEWAYS[_retryCount], _cardNumber, getFare());
     }
 
-    inline std::unique_ptr<BaseState> PaymentProcessing::process(TransactionDeclined event) {
-        return std::make_unique<PaymentFailed>(_context, std::move(event.reason));
+    inline StatePtr PaymentProcessing::process(TransactionDeclined event) {
+        return _context.get().makeState<PaymentFailed>(_context, std::move(event.reason));
     }
 
-    inline std::unique_ptr<BaseState> PaymentProcessing::process(TransactionSuccess event) {
-        return std::make_unique<PaymentSuccess>(_context, event.fare, event.balance);
+    inline StatePtr PaymentProcessing::process(TransactionSuccess event) {
+        return _context.get().makeState<PaymentSuccess>(_context, event.fare, event.balance);
     }
 
-    inline std::unique_ptr<BaseState> PaymentProcessing::process(Timeout event) {
+    inline StatePtr PaymentProcessing::process(Timeout event) {
         if (++_retryCount >= GATEWAYS.size()) {
-            return std::make_unique<PaymentFailed>(_context, "Network Failure");
+            return _context.get().makeState<PaymentFailed>(_context, "Network Failure");
         }
         _context.get().initiateTransaction(GATEWAYS[_retryCount], _cardNumber, getFare());
+#if !DISABLE_TIMEOUT_MANAGER
         _timeoutManager.restart(2s);
+#endif
         return nullptr;
     }
 
     inline PaymentFailed::PaymentFailed(std::reference_wrapper<FSM> context, std::string reason)
         : BaseState(context)
         , _reason(std::move(reason))
+#if !DISABLE_TIMEOUT_MANAGER
         , _timeoutManager(
-              [&] {
-                  process(Timeout{});
+              [context] {
+                  context.get().process(Timeout{});
               },
-              2s) {
+              2s)
+#endif
+    {
         auto & fsm = _context.get();
         fsm.getDoor().close();
         fsm.getLED().setStatus(LEDController::eStatus::FlashRedCross);
-        fsm.getPOS().setRows("Declined", _reason);
+        fsm.getPOS().show(POSTerminal::eMessage::Declined, _reason);
     }
 
-    inline std::unique_ptr<BaseState> PaymentFailed::process(Timeout event) {
-        return std::make_unique<Locked>(_context);
+    inline StatePtr PaymentFailed::process(Timeout event) {
+        return _context.get().makeState<Locked>(_context);
     }
 
     inline PaymentSuccess::PaymentSuccess(std::reference_wrapper<FSM> context, int fare, int balance)
         : BaseState(context)
+#if !DISABLE_TIMEOUT_MANAGER
         , _timeoutManager(
-              [&] {
-                  process(Timeout{});
+              [context] {
+                  context.get().process(Timeout{});
               },
-              2s) {
+              2s)
+#endif
+    {
         auto & fsm = _context.get();
         fsm.getDoor().open();
         fsm.getLED().setStatus(LEDController::eStatus::GreenArrow);
-        fsm.getPOS().setRows(
-            "Approved", std::string("Fare: ") + std::to_string(fare),
-            std::string("Balance: ") + std::to_string(balance));
+        fsm.getPOS().show(POSTerminal::eMessage::Paid, fare, balance);
     }
 
-    inline std::unique_ptr<BaseState> PaymentSuccess::process(PersonPassed event) {
-        return std::make_unique<Locked>(_context);
+    inline StatePtr PaymentSuccess::process(PersonPassed event) {
+        return _context.get().makeState<Locked>(_context);
     }
 
-    inline std::unique_ptr<BaseState> PaymentSuccess::process(Timeout event) {
-        return std::make_unique<Unlocked>(_context);
+    inline StatePtr PaymentSuccess::process(Timeout event) {
+        return _context.get().makeState<Unlocked>(_context);
     }
 
     inline Unlocked::Unlocked(std::reference_wrapper<FSM> context) : BaseState(context) {
         auto & fsm = _context.get();
         fsm.getDoor().open();
         fsm.getLED().setStatus(LEDController::eStatus::GreenArrow);
-        fsm.getPOS().setRows("Approved");
+        fsm.getPOS().show(POSTerminal::eMessage::Approved);
     }
 
-    inline std::unique_ptr<BaseState> Unlocked::process(PersonPassed event) {
-        return std::make_unique<Locked>(_context);
+    inline StatePtr Unlocked::process(PersonPassed event) {
+        return _context.get().makeState<Locked>(_context);
     }
 } // namespace with_state_pattern
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "FSMTransitionTable.h"
+#include "Logging.h"
+#include "Pan.h"
+#include "Turnstile.h"
+
+#include <string>
+
+namespace with_transition_table {
+    using adc::TRow;
+
+    // the machine of with_enums, written as a transition table
+    class FSM {
+    public:
+        template <typename Event>
+        FSM & process(Event event) {
+            ADC_LOG(Debug, "EVENT: {}", type_name<Event>());
+            _table.process(*this, event);
+            return *this;
+        }
+
+        [[nodiscard]] eState getState() const {
+            return _table.getState();
+        }
+
+        [[nodiscard]] const SwingDoor & getDoor() const {
+            return _door;
+        }
+
+        [[nodiscard]] const POSTerminal & getPOS() const {
+            return _pos;
+        }
+
+        [[nodiscard]] const LEDController & getLED() const {
+            return _led;
+        }
+
+#if RECORD_LAST_TRANSACTION
+        [[nodiscard]] const auto & getLastTransaction() const {
+            return _lastTransaction;
+        }
+#endif
+
+    private:
+        // guards and actions of the table
+        bool isReadable(const CardPresented & event) const;
+        void startPayment(CardPresented & event);
+        bool canRetry() const;
+        void retryPayment();
+        void declinePayment(const TransactionDeclined & event);
+        void failPayment();
+        void approvePayment(const TransactionSuccess & event);
+        void lock();
+        void unlock();
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount);
+
+        // clang-format off
+        using S = eState;
+        using Table = adc::TFSMTransitionTable<FSM, S::Locked,
+            //   source                event                target                action                guard
+            TRow<S::Locked,            CardPresented,       S::PaymentProcessing, &FSM::startPayment,   &FSM::isReadable>,
+            TRow<S::PaymentProcessing, TransactionDeclined, S::PaymentFailed,     &FSM::declinePayment>,
+            TRow<S::PaymentProcessing, TransactionSuccess,  S::PaymentSuccess,    &FSM::approvePayment>,
+            TRow<S::PaymentProcessing, Timeout,             S::PaymentProcessing, &FSM::retryPayment,   &FSM::canRetry>,
+            TRow<S::PaymentProcessing, Timeout,             S::PaymentFailed,     &FSM::failPayment>,
+            TRow<S::PaymentFailed,     Timeout,             S::Locked,            &FSM::lock>,
+            TRow<S::PaymentSuccess,    Timeout,             S::Unlocked,          &FSM::unlock>,
+            TRow<S::PaymentSuccess,    PersonPassed,        S::Locked,            &FSM::lock>,
+            TRow<S::Unlocked,          PersonPassed,        S::Locked,            &FSM::lock>>;
+        // clang-format on
+
+        Table _table;
+
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{POSTerminal::TOUCH_CARD};
+        LEDController _led;
+
+        int _retryCounts{0};
+        std::string _cardNumber{};
+
+#if RECORD_LAST_TRANSACTION
+        // for testing
+        std::tuple<std::string, std::string, int> _lastTransaction;
+#endif
+    };
+
+    // a card whose number cannot be read is ignored
+    inline bool FSM::isReadable(const CardPresented & event) const {
+        return Pan::parse(event.cardNumber).has_value();
+    }
+
+    inline void FSM::startPayment(CardPresented & event) {
+        _retryCounts = 0;
+        _cardNumber = std::move(event.cardNumber);
+        initiateTransaction(GATEWAYS[0], _cardNumber, getFare());
+        _door.close();
+        _pos.show(POSTerminal::eMessage::Processing);
+        _led.setStatus(LEDController::eStatus::OrangeCross);
+    }
+
+    inline bool FSM::canRetry() const {
+        return _retryCounts < 2;
+    }
+
+    inline void FSM::retryPayment() {
+        _retryCounts++;
+        initiateTransaction(GATEWAYS[_retryCounts], _cardNumber, getFare());
+    }
+
+    inline void FSM::declinePayment(const TransactionDeclined & event) {
+        _door.close();
+        _pos.show(POSTerminal::eMessage::Declined, event.reason);
+        _led.setStatus(LEDController::eStatus::FlashRedCross);
+    }
+
+    inline void FSM::failPayment() {
+        _door.close();
+        _pos.show(POSTerminal::eMessage::Declined, "Network Error");
+        _led.setStatus(LEDController::eStatus::FlashRedCross);
+    }
+
+    inline void FSM::approvePayment(const TransactionSuccess & event) {
+        _door.open();
+        _pos.show(POSTerminal::eMessage::Paid, event.fare, event.balance);
+        _led.setStatus(LEDController::eStatus::GreenArrow);
+    }
+
+    inline void FSM::lock() {
+        _door.close();
+        _pos.show(POSTerminal::eMessage::TouchCard);
+        _led.setStatus(LEDController::eStatus::RedCross);
+    }
+
+    inline void FSM::unlock() {
+        _door.open();
+        _pos.show(POSTerminal::eMessage::Approved);
+        _led.setStatus(LEDController::eStatus::GreenArrow);
+    }
+
+    inline void FSM::initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
+        logTransaction(gateway, cardNum, amount);
+#if RECORD_LAST_TRANSACTION
+        _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+#endif
+    }
+} // namespace with_transition_table
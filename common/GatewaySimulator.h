@@ -0,0 +1,175 @@
+#pragma once
+
+#include "TimingWheel.h"
+#include "Turnstile.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+// how long a gateway takes to answer
+class LatencyModel {
+public:
+    static LatencyModel fixed(std::chrono::milliseconds latency) {
+        return {eKind::Fixed, latency, latency, 0};
+    }
+
+    static LatencyModel uniform(std::chrono::milliseconds low, std::chrono::milliseconds high) {
+        return {eKind::Uniform, low, high, 0};
+    }
+
+    // long-tailed, as network latencies are: sigma is the standard deviation of the logarithm of the latency
+    static LatencyModel logNormal(std::chrono::milliseconds median, double sigma) {
+        return {eKind::LogNormal, median, median, sigma};
+    }
+
+    template <typename Rng>
+    std::chrono::milliseconds sample(Rng & rng) const {
+        switch (_kind) {
+        case eKind::Fixed:
+            return _low;
+        case eKind::Uniform:
+            return std::chrono::milliseconds{
+                std::uniform_int_distribution<std::chrono::milliseconds::rep>{_low.count(), _high.count()}(rng)};
+        case eKind::LogNormal:
+            break;
+        }
+        const auto median = static_cast<double>(_low.count());
+        const auto latency = std::lognormal_distribution<double>{std::log(median), _sigma}(rng);
+        return std::chrono::milliseconds{std::llround(latency)};
+    }
+
+private:
+    enum class eKind { Fixed, Uniform, LogNormal };
+
+    LatencyModel(eKind kind, std::chrono::milliseconds low, std::chrono::milliseconds high, double sigma)
+        : _kind(kind), _low(low), _high(high), _sigma(sigma) {
+    }
+
+    eKind _kind;
+    std::chrono::milliseconds _low;
+    std::chrono::milliseconds _high;
+    double _sigma;
+};
+
+// a window of virtual time in which a gateway loses every request made to it
+struct Outage {
+    std::chrono::milliseconds from;
+    std::chrono::milliseconds to;
+};
+
+struct GatewayProfile {
+    LatencyModel latency{LatencyModel::logNormal(std::chrono::milliseconds{150}, 0.5)};
+    double declineRate{0.02};
+    std::vector<Outage> outages;
+
+    bool down(std::chrono::milliseconds now) const {
+        for (const auto & outage : outages) {
+            if (outage.from <= now && now < outage.to) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Stands in for the gateways of GATEWAYS on a virtual clock: a request is answered after a latency drawn from its
+// gateway's profile, approved or declined at its decline rate, or lost while the gateway is down. Replies are
+// delivered as the clock runs; pending replies are kept in a pool of timers, so a steady load does not allocate.
+class GatewaySimulator {
+public:
+    struct Reply {
+        std::size_t gateId;
+        // the caller's tag of the request, handed back with its reply
+        std::uint64_t tag;
+        bool approved;
+        int amount;
+    };
+
+    struct Stats {
+        std::size_t requests{0};
+        std::size_t declined{0};
+        std::size_t lost{0};
+    };
+
+    GatewaySimulator(adc::VirtualTimerSource & clock, std::function<void(const Reply &)> deliver, std::uint64_t seed)
+        : _clock(clock), _deliver(std::move(deliver)), _rng(seed) {
+    }
+
+    GatewaySimulator(const GatewaySimulator & other) = delete;
+    GatewaySimulator & operator=(const GatewaySimulator & other) = delete;
+
+    ~GatewaySimulator() {
+        for (auto & pending : _pending) {
+            _clock.cancel(pending);
+        }
+    }
+
+    // indexed like GATEWAYS
+    GatewayProfile & profile(std::size_t gateway) {
+        return _profiles[gateway];
+    }
+
+    const Stats & stats(std::size_t gateway) const {
+        return _stats[gateway];
+    }
+
+    void request(std::size_t gateway, std::size_t gateId, std::uint64_t tag, int amount) {
+        const auto & profile = _profiles[gateway];
+        auto & stats = _stats[gateway];
+        ++stats.requests;
+        if (profile.down(_clock.now())) {
+            ++stats.lost;
+            return;
+        }
+        const bool approved = std::uniform_real_distribution<double>{}(_rng) >= profile.declineRate;
+        if (!approved) {
+            ++stats.declined;
+        }
+        auto & pending = acquire();
+        pending.reply = Reply{gateId, tag, approved, amount};
+        // at least a tick, so that no reply arrives within the transition which sent its request
+        _clock.schedule(pending, std::max(profile.latency.sample(_rng), std::chrono::milliseconds{1}));
+    }
+
+private:
+    class PendingReply final : public adc::TimerNode {
+    public:
+        explicit PendingReply(GatewaySimulator & simulator) : _simulator(simulator) {
+        }
+
+        Reply reply{};
+
+    private:
+        void expire() override {
+            const auto delivered = reply;
+            _simulator._free.push_back(this);
+            _simulator._deliver(delivered);
+        }
+
+        GatewaySimulator & _simulator;
+    };
+
+    PendingReply & acquire() {
+        if (_free.empty()) {
+            return _pending.emplace_back(*this);
+        }
+        auto * pending = _free.back();
+        _free.pop_back();
+        return *pending;
+    }
+
+    adc::VirtualTimerSource & _clock;
+    std::function<void(const Reply &)> _deliver;
+    std::mt19937_64 _rng;
+    std::array<GatewayProfile, 3> _profiles;
+    std::array<Stats, 3> _stats{};
+    std::deque<PendingReply> _pending;
+    std::vector<PendingReply *> _free;
+};
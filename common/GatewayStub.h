@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Coroutine.h"
+
+#if ADC_COROUTINES
+
+#include "Pan.h"
+#include "Turnstile.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <variant>
+
+// An in-process payment gateway for tests and benchmarks. Authorisations are awaited by coroutines and answered, in the
+// order they were made, when respond() is called; nothing runs on a thread of its own, so any number of them may be in
+// flight. Each call is kept in the frame of the coroutine awaiting it, so that the stub never allocates. Calls may be
+// made, answered and cancelled from any thread.
+class GatewayStub {
+public:
+    using Reply = std::variant<TransactionSuccess, TransactionDeclined>;
+    using Policy = Reply (*)(std::string_view gateway, const Pan & card, int amount);
+
+    // approves every card, leaving a balance of 100 after the fare
+    static Reply approve(std::string_view gateway, const Pan & card, int amount) {
+        return TransactionSuccess{amount, 100 - amount};
+    }
+
+    explicit GatewayStub(Policy policy = &approve) : _policy(policy) {
+    }
+
+    GatewayStub(const GatewayStub & other) = delete;
+    GatewayStub & operator=(const GatewayStub & other) = delete;
+
+    // co_await'ed by the caller, which is handed to its resumer once the call is answered
+    class Call {
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            _handle = handle;
+            _stub.enqueue(*this);
+        }
+
+        Reply await_resume() {
+            return std::move(_reply);
+        }
+
+    private:
+        friend class GatewayStub;
+
+        Call(GatewayStub & stub, adc::Resumer & resumer, std::string_view gateway, const Pan & card, int amount)
+            : _stub(stub), _resumer(resumer), _gateway(gateway), _card(card), _amount(amount) {
+        }
+
+        GatewayStub & _stub;
+        adc::Resumer & _resumer;
+        std::string_view _gateway;
+        Pan _card;
+        int _amount;
+        std::coroutine_handle<> _handle;
+        Reply _reply;
+        Call * _next{nullptr};
+    };
+
+    // never completes before the caller is suspended, so that a reply is never processed within the transition which
+    // made the call
+    Call authorize(adc::Resumer & resumer, std::string_view gateway, const Pan & card, int amount) {
+        return Call{*this, resumer, gateway, card, amount};
+    }
+
+    // Answers up to limit calls, oldest first, and hands their callers to their resumers; returns how many. Stops at a
+    // call whose resumer cannot take it yet, which stays unanswered.
+    std::size_t respond(std::size_t limit = SIZE_MAX) {
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::size_t answered = 0;
+        for (; _head && answered < limit; ++answered) {
+            auto & call = *_head;
+            auto * next = call._next;
+            call._reply = _policy(call._gateway, call._card, call._amount);
+            // the call lives in the caller's frame, which may be gone as soon as it is resumed
+            if (!call._resumer.resume(call._handle)) {
+                break;
+            }
+            _head = next;
+            if (!_head) {
+                _tail = nullptr;
+            }
+            --_inFlight;
+        }
+        return answered;
+    }
+
+    // Drops the unanswered calls to be resumed by resumer and destroys the coroutines awaiting them, freeing their
+    // frames; returns how many. Used by an FSM going away while its calls are in flight.
+    std::size_t cancel(adc::Resumer & resumer) {
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::size_t cancelled = 0;
+        Call * previous = nullptr;
+        for (auto * call = _head; call;) {
+            auto * next = call->_next;
+            if (&call->_resumer != &resumer) {
+                previous = call;
+            } else {
+                (previous ? previous->_next : _head) = next;
+                if (_tail == call) {
+                    _tail = previous;
+                }
+                --_inFlight;
+                ++cancelled;
+                call->_handle.destroy();
+            }
+            call = next;
+        }
+        return cancelled;
+    }
+
+    std::size_t inFlight() const {
+        std::lock_guard<std::mutex> lock{_mutex};
+        return _inFlight;
+    }
+
+private:
+    void enqueue(Call & call) {
+        std::lock_guard<std::mutex> lock{_mutex};
+        (_tail ? _tail->_next : _head) = &call;
+        _tail = &call;
+        ++_inFlight;
+    }
+
+    Policy _policy;
+    mutable std::mutex _mutex;
+    Call * _head{nullptr};
+    Call * _tail{nullptr};
+    std::size_t _inFlight{0};
+};
+
+#endif
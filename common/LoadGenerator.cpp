@@ -0,0 +1,255 @@
+#include "LoadGenerator.h"
+#include "Logging.h"
+#include "States.h"
+
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    struct Run;
+
+    // One gate of the load test, the FSM context of its states. A rider tapping while the gate is busy queues behind
+    // the one being served, and taps as soon as the gate is locked again.
+    class SimulatedGate {
+    public:
+        SimulatedGate(Run & run, std::size_t id);
+
+        template <typename Event>
+        SimulatedGate & process(Event event);
+
+        [[nodiscard]] SwingDoor & getDoor() {
+            return _door;
+        }
+
+        [[nodiscard]] POSTerminal & getPOS() {
+            return _pos;
+        }
+
+        [[nodiscard]] LEDController & getLED() {
+            return _led;
+        }
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount);
+
+        void onReply(const GatewaySimulator::Reply & reply);
+
+    private:
+        void arrive();
+        void tap();
+        void entered(eState state, bool timedOut);
+
+        Run & _run;
+        std::size_t _id;
+        std::string _card;
+        // the current tap, tagging its requests, and when it was made
+        std::uint64_t _tap{0};
+        std::chrono::milliseconds _tappedAt{0};
+        std::size_t _waiting{0};
+        TimeoutManager _arrivals;
+        std::optional<TimeoutManager> _passing;
+
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{""};
+        LEDController _led;
+        adc::TFSMStateTransitions<states::TLocked<SimulatedGate>, states::TPaymentProcessing<SimulatedGate>,
+            states::TPaymentFailed<SimulatedGate>, states::TPaymentSuccess<SimulatedGate>,
+            states::TUnlocked<SimulatedGate>>
+            _fsm;
+    };
+
+    // members are in the order they are needed: the gates schedule on the clock, and reply through the gateways
+    struct Run {
+        explicit Run(const LoadOptions & options)
+            : options(options)
+            , rng(options.seed)
+            , arrivals(options.tapsPerMinute / 60000.0)
+            , gateways(
+                  clock,
+                  [this](const GatewaySimulator::Reply & reply) {
+                      gates[reply.gateId].onReply(reply);
+                  },
+                  options.seed + 1) {
+            for (std::size_t gateway = 0; gateway < options.gateways.size(); ++gateway) {
+                gateways.profile(gateway) = options.gateways[gateway];
+            }
+        }
+
+        // the time to the next rider at a gate
+        std::chrono::milliseconds nextArrival() {
+            return std::max(1ms, std::chrono::milliseconds{std::llround(arrivals(rng))});
+        }
+
+        const LoadOptions & options;
+        LoadReport report;
+        std::vector<std::uint32_t> latencies;
+        std::mt19937_64 rng;
+        std::exponential_distribution<double> arrivals;
+        adc::VirtualTimerSource clock;
+        adc::TimerSource::Override useVirtualTime{clock};
+        GatewaySimulator gateways;
+        std::deque<SimulatedGate> gates;
+    };
+
+    SimulatedGate::SimulatedGate(Run & run, std::size_t id)
+        : _run(run)
+        , _id(id)
+        , _card(std::to_string(4000000000000000ULL + id))
+        , _arrivals(
+              [this] {
+                  arrive();
+              },
+              run.nextArrival())
+        , _fsm{std::in_place_type<states::TLocked<SimulatedGate>>, std::ref(*this)} {
+    }
+
+    template <typename Event>
+    SimulatedGate & SimulatedGate::process(Event event) {
+        const auto before = _fsm.getState();
+        _fsm.process(std::move(event));
+        ++_run.report.events;
+        const auto after = _fsm.getState();
+        if (after != before) {
+            entered(after, std::is_same_v<Event, Timeout>);
+        }
+        return *this;
+    }
+
+    void SimulatedGate::initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+        logTransaction(gateway, card.text().view(), amount);
+        const auto found = std::find(GATEWAYS.begin(), GATEWAYS.end(), gateway);
+        const auto index = static_cast<std::size_t>(found - GATEWAYS.begin());
+        if (index > 0) {
+            ++_run.report.retries;
+        }
+        _run.gateways.request(index, _id, _tap, amount);
+    }
+
+    void SimulatedGate::onReply(const GatewaySimulator::Reply & reply) {
+        if (reply.tag != _tap || _fsm.getState() != eState::PaymentProcessing) {
+            ++_run.report.lateReplies;
+            return;
+        }
+        if (reply.approved) {
+            process(TransactionSuccess{reply.amount, 100});
+        } else {
+            process(TransactionDeclined{"Declined"});
+        }
+    }
+
+    void SimulatedGate::arrive() {
+        if (_run.clock.now() >= _run.options.duration) {
+            return;
+        }
+        _arrivals.restart(_run.nextArrival());
+        if (_fsm.getState() == eState::Locked && _waiting == 0) {
+            tap();
+        } else {
+            ++_waiting;
+        }
+    }
+
+    void SimulatedGate::tap() {
+        ++_tap;
+        ++_run.report.taps;
+        _tappedAt = _run.clock.now();
+        process(CardPresented{_card});
+    }
+
+    void SimulatedGate::entered(eState state, bool timedOut) {
+        switch (state) {
+        case eState::PaymentSuccess:
+            ++_run.report.approved;
+            _run.latencies.push_back(static_cast<std::uint32_t>((_run.clock.now() - _tappedAt).count()));
+            _passing.reset();
+            _passing.emplace(
+                [this] {
+                    process(PersonPassed{});
+                },
+                _run.options.passTime);
+            break;
+        case eState::PaymentFailed:
+            ++(timedOut ? _run.report.failed : _run.report.declined);
+            break;
+        case eState::Locked:
+            if (_waiting > 0) {
+                --_waiting;
+                tap();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::chrono::milliseconds percentile(const std::vector<std::uint32_t> & sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0ms;
+        }
+        const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return std::chrono::milliseconds{sorted[rank]};
+    }
+} // namespace
+
+double LoadReport::tapsPerSecond() const {
+    return simulated.count() > 0 ? static_cast<double>(taps) * 1000.0 / static_cast<double>(simulated.count()) : 0;
+}
+
+double LoadReport::eventsPerWallSecond() const {
+    return wall.count() > 0 ? static_cast<double>(events) / wall.count() : 0;
+}
+
+LoadReport runLoad(const LoadOptions & options) {
+    const auto started = std::chrono::steady_clock::now();
+    Run run{options};
+    for (std::size_t gateId = 0; gateId < options.gates; ++gateId) {
+        run.gates.emplace_back(run, gateId);
+    }
+    run.clock.runUntil(options.duration);
+    // no rider arrives any more; what is left are the taps under way, their gateways and timeouts
+    while (run.clock.pending() > 0) {
+        run.clock.runFor(1s);
+    }
+    run.gates.clear();
+
+    auto report = run.report;
+    for (std::size_t gateway = 0; gateway < report.gateways.size(); ++gateway) {
+        report.gateways[gateway] = run.gateways.stats(gateway);
+    }
+    std::sort(run.latencies.begin(), run.latencies.end());
+    report.p50 = percentile(run.latencies, 0.5);
+    report.p90 = percentile(run.latencies, 0.9);
+    report.p99 = percentile(run.latencies, 0.99);
+    report.p999 = percentile(run.latencies, 0.999);
+    report.max = percentile(run.latencies, 1);
+    report.simulated = options.duration;
+    report.wall = std::chrono::steady_clock::now() - started;
+    return report;
+}
+
+std::ostream & operator<<(std::ostream & out, const LoadReport & report) {
+    out << "taps:          " << report.taps << " (" << std::fixed << std::setprecision(1) << report.tapsPerSecond()
+        << "/s over " << report.simulated.count() / 1000 << "s)\n";
+    out << "  approved:    " << report.approved << '\n';
+    out << "  declined:    " << report.declined << '\n';
+    out << "  failed:      " << report.failed << '\n';
+    out << "retries:       " << report.retries << '\n';
+    out << "late replies:  " << report.lateReplies << '\n';
+    out << "tap to open:   p50 " << report.p50.count() << "ms, p90 " << report.p90.count() << "ms, p99 "
+        << report.p99.count() << "ms, p99.9 " << report.p999.count() << "ms, max " << report.max.count() << "ms\n";
+    for (std::size_t gateway = 0; gateway < report.gateways.size(); ++gateway) {
+        const auto & stats = report.gateways[gateway];
+        out << GATEWAYS[gateway] << ":      " << stats.requests << " requests, " << stats.declined << " declined, "
+            << stats.lost << " lost\n";
+    }
+    out << "simulation:    " << report.events << " events in " << std::setprecision(2) << report.wall.count()
+        << "s (" << std::setprecision(0) << report.eventsPerWallSecond() << "/s)\n";
+    return out;
+}
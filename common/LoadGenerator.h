@@ -0,0 +1,57 @@
+#pragma once
+
+#include "GatewaySimulator.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// A load test of the turnstile against GatewaySimulator, run on virtual time so that it needs neither the network nor
+// the hours it simulates. Riders arrive at every gate at random, tapsPerMinute on average, queue while it is busy and
+// pass passTime after the door opened.
+struct LoadOptions {
+    std::size_t gates{1000};
+    std::chrono::milliseconds duration{std::chrono::minutes{10}};
+    double tapsPerMinute{4};
+    std::chrono::milliseconds passTime{1500};
+    std::uint64_t seed{1};
+    // indexed like GATEWAYS
+    std::array<GatewayProfile, 3> gateways{
+        GatewayProfile{LatencyModel::logNormal(std::chrono::milliseconds{120}, 0.5), 0.02, {}},
+        GatewayProfile{LatencyModel::logNormal(std::chrono::milliseconds{200}, 0.6), 0.02, {}},
+        GatewayProfile{LatencyModel::logNormal(std::chrono::milliseconds{350}, 0.7), 0.02, {}}};
+};
+
+struct LoadReport {
+    // taps, and how they ended: the door opened, the card was declined, or every gateway timed out
+    std::size_t taps{0};
+    std::size_t approved{0};
+    std::size_t declined{0};
+    std::size_t failed{0};
+    // transactions sent to another gateway after a timeout
+    std::size_t retries{0};
+    // replies arriving after their tap was over
+    std::size_t lateReplies{0};
+    std::size_t events{0};
+    std::array<GatewaySimulator::Stats, 3> gateways{};
+
+    // from the tap to the door opening, of the approved taps
+    std::chrono::milliseconds p50{0};
+    std::chrono::milliseconds p90{0};
+    std::chrono::milliseconds p99{0};
+    std::chrono::milliseconds p999{0};
+    std::chrono::milliseconds max{0};
+
+    // the virtual time the taps arrived in, and the time the run took
+    std::chrono::milliseconds simulated{0};
+    std::chrono::duration<double> wall{0};
+
+    double tapsPerSecond() const;
+    double eventsPerWallSecond() const;
+};
+
+// Riders stop arriving after options.duration; the taps under way are then run to their end.
+LoadReport runLoad(const LoadOptions & options);
+
+std::ostream & operator<<(std::ostream & out, const LoadReport & report);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Logger.h"
+#include "Pan.h"
+
+#include <string_view>
+
+// the devices are logged row by row, so that nothing is formatted on the caller's thread
+template <typename FSM>
+void logFSM(FSM & fsm) {
+    ADC_LOG(
+        Debug, "STATE: {} :: Door[{}], LED: [{}] and PosTerminal[{}, {}, {}]", to_string(fsm.getState()),
+        to_string(fsm.getDoor().getStatus()), to_string(fsm.getLED().getStatus()), fsm.getPOS().getFirstRow(),
+        fsm.getPOS().getSecondRow(), fsm.getPOS().getThirdRow());
+}
+
+inline void logTransaction(std::string_view gateway, std::string_view cardNum, int amount) {
+    ADC_LOG(Info, "ACTIONS: Initiated Transaction to [{}] with card [{}] for amount [{}]", gateway, cardNum, amount);
+}
+
+// the digits are only unpacked when the line is logged
+inline void logTransaction(std::string_view gateway, const Pan & card, int amount) {
+    ADC_LOG(
+        Info, "ACTIONS: Initiated Transaction to [{}] with card [{}] for amount [{}]", gateway, card.text().view(),
+        amount);
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
 #include "FSM.h"
 #include "States.h"
 #include "Turnstile.h"
@@ -17,8 +17,11 @@ namespace old_fsm_external_transitions {
     using OptState = std::optional<State>;
 
     struct TransitionTable {
-        OptState operator()(Locked & state, CardPresented event) {
-            return PaymentProcessing(state._context, std::move(event.cardNumber));
+        OptState operator()(Locked & state, const CardPresented & event) {
+            if (const auto card = Pan::parse(event.cardNumber)) {
+                return PaymentProcessing(state._context, *card);
+            }
+            return OptState{};
         }
         OptState operator()(PaymentProcessing & state, TransactionDeclined event) {
             return PaymentFailed(state._context, std::move(event.reason));
@@ -75,9 +78,11 @@ namespace old_fsm_external_transitions {
         }
 
         // External Actions
-        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
-            logTransaction(gateway, cardNum, amount);
-            _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+#if RECORD_LAST_TRANSACTION
+            _lastTransaction = std::make_tuple(gateway, std::string{card.text().view()}, amount);
+#endif
         }
 
     private:
@@ -89,6 +94,7 @@ namespace old_fsm_external_transitions {
             TransitionTable, Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked>
             _fsm;
 
+#if RECORD_LAST_TRANSACTION
         // for testing
         std::tuple<std::string, std::string, int> _lastTransaction;
 
@@ -96,5 +102,6 @@ namespace old_fsm_external_transitions {
         const auto & getLastTransaction() const {
             return _lastTransaction;
         }
+#endif
     };
 } // namespace old_fsm_external_transitions
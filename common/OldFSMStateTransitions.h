@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ConditionalStream.h"
+#include "Logging.h"
 #include "FSM.h"
 #include "States.h"
 #include "Turnstile.h"
@@ -44,9 +44,11 @@ namespace old_fsm_state_transitions {
         }
 
         // External Actions
-        void initiateTransaction(const std::string & gateway, const std::string & cardNum, int amount) {
-            logTransaction(gateway, cardNum, amount);
-            _lastTransaction = std::make_tuple(gateway, cardNum, amount);
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+#if RECORD_LAST_TRANSACTION
+            _lastTransaction = std::make_tuple(gateway, std::string{card.text().view()}, amount);
+#endif
         }
 
     private:
@@ -56,6 +58,7 @@ namespace old_fsm_state_transitions {
         LEDController _led;
         adc::old::TFSMStateTransitions<Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked> _fsm;
 
+#if RECORD_LAST_TRANSACTION
         // for testing
         std::tuple<std::string, std::string, int> _lastTransaction;
 
@@ -63,5 +66,6 @@ namespace old_fsm_state_transitions {
         const auto & getLastTransaction() const {
             return _lastTransaction;
         }
+#endif
     };
 } // namespace old_fsm_state_transitions
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+// A card number (primary account number) of up to 19 decimal digits, packed four bits to a digit (BCD) in a fixed
+// inline buffer, so that holding one neither allocates nor takes more than 12 bytes. Every turnstile implementation
+// ignores a card whose number does not parse.
+class Pan {
+public:
+    static constexpr std::size_t MAX_DIGITS = 19;
+
+    // the digits as text, in a fixed buffer of their own
+    class Text {
+    public:
+        std::string_view view() const {
+            return {_chars.data(), _size};
+        }
+
+    private:
+        friend class Pan;
+
+        std::array<char, MAX_DIGITS> _chars{};
+        std::uint8_t _size{0};
+    };
+
+    Pan() = default;
+
+    // Nothing unless text is 1 to 19 decimal digits. The digits are gathered in registers and stored with one write
+    // per word, which the first copy of the result can read back at once; or-ing them into the buffer a nibble at a
+    // time left that copy waiting for every byte store to retire.
+    static std::optional<Pan> parse(std::string_view text) {
+        if (text.empty() || text.size() > MAX_DIGITS) {
+            return std::nullopt;
+        }
+        std::uint64_t head = 0;
+        std::uint32_t tail = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const auto digit = static_cast<unsigned char>(text[i] - '0');
+            if (digit > 9) {
+                return std::nullopt;
+            }
+            if (i < HEAD_DIGITS) {
+                head |= std::uint64_t{digit} << (60 - 4 * i);
+            } else {
+                tail |= std::uint32_t{digit} << (28 - 4 * (i - HEAD_DIGITS));
+            }
+        }
+        tail |= static_cast<std::uint32_t>(text.size());
+        Pan pan;
+        std::memcpy(pan._packed.data(), &head, sizeof(head));
+        std::memcpy(pan._packed.data() + sizeof(head), &tail, sizeof(tail));
+        return pan;
+    }
+
+    std::size_t size() const {
+        return tail() & 0xFFU;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    char operator[](std::size_t i) const {
+        const auto nibble = i < HEAD_DIGITS ? head() >> (60 - 4 * i) : tail() >> (28 - 4 * (i - HEAD_DIGITS));
+        return static_cast<char>('0' + (nibble & 0xFU));
+    }
+
+    Text text() const {
+        Text text;
+        text._size = static_cast<std::uint8_t>(size());
+        for (std::size_t i = 0; i < text._size; ++i) {
+            text._chars[i] = (*this)[i];
+        }
+        return text;
+    }
+
+    friend bool operator==(const Pan & lhs, const Pan & rhs) {
+        return lhs._packed == rhs._packed;
+    }
+
+    friend bool operator!=(const Pan & lhs, const Pan & rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    // the first 16 digits fill a 64-bit head, the last 3 the top of a 32-bit tail whose low byte is the length
+    static constexpr std::size_t HEAD_DIGITS = 16;
+
+    std::uint64_t head() const {
+        std::uint64_t head;
+        std::memcpy(&head, _packed.data(), sizeof(head));
+        return head;
+    }
+
+    std::uint32_t tail() const {
+        std::uint32_t tail;
+        std::memcpy(&tail, _packed.data() + sizeof(std::uint64_t), sizeof(tail));
+        return tail;
+    }
+
+    // Kept as bytes, so that a Pan packs into its state with no padding, and read and written through memcpy. Twelve
+    // bytes copy as one 8 and one 4 byte move matching the writes of parse(); eleven took two overlapping moves, which
+    // could not be forwarded from them and stalled every transition into PaymentProcessing.
+    std::array<unsigned char, 12> _packed{};
+};
+static_assert(sizeof(Pan) == 12, "a PAN packs 19 digits and its length into 12 bytes");
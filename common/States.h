@@ -1,10 +1,15 @@
 #pragma once
 
+#include "FSM.h"
+#include "Pan.h"
+#include "Snapshot.h"
 #include "Turnstile.h"
 
 #include <array>
 #include <optional>
 #include <string>
+#include <string_view>
+
 namespace states {
     using namespace std::chrono_literals;
 
@@ -23,6 +28,12 @@ namespace states {
         std::variant<TLocked<FSM>, TPaymentProcessing<FSM>, TPaymentFailed<FSM>, TPaymentSuccess<FSM>, TUnlocked<FSM>>;
     template <typename FSM>
     using TOptState = std::optional<TState<FSM>>;
+    template <typename FSM>
+    using TToPaymentProcessing = adc::TTransition<TPaymentProcessing<FSM>, std::reference_wrapper<FSM>, Pan>;
+    // The reason is a view, of a literal or of the TransactionDeclined event, which handlers take by reference so that
+    // it outlives the transition; moving a std::string through the transition's tuple cost more than the rest of it.
+    template <typename FSM>
+    using TToPaymentFailed = adc::TTransition<TPaymentFailed<FSM>, std::reference_wrapper<FSM>, std::string_view>;
 
     template <typename FSM>
     class TBaseState {
@@ -31,8 +42,8 @@ namespace states {
         }
 
         template <typename EventType>
-        TOptState<FSM> process(EventType) {
-            return TOptState<FSM>{};
+        adc::NoTransition process(EventType) {
+            return adc::NoTransition{};
         };
 
     protected:
@@ -47,7 +58,7 @@ namespace states {
             auto & fsm = _context.get();
             fsm.getDoor().close();
             fsm.getLED().setStatus(LEDController::eStatus::RedCross);
-            fsm.getPOS().setRows("Touch Card");
+            fsm.getPOS().show(POSTerminal::eMessage::TouchCard);
         }
 
         eState getState() const {
@@ -55,8 +66,12 @@ namespace states {
         }
 
         using TBaseState<FSM>::process;
-        TOptState<FSM> process(CardPresented event) {
-            return TPaymentProcessing<FSM>(_context, std::move(event.cardNumber));
+        // a card whose number cannot be read is ignored
+        std::optional<TToPaymentProcessing<FSM>> process(const CardPresented & event) {
+            if (const auto card = Pan::parse(event.cardNumber)) {
+                return adc::transitionTo<TPaymentProcessing<FSM>>(_context, *card);
+            }
+            return std::nullopt;
         }
     };
 
@@ -64,22 +79,55 @@ namespace states {
     class TPaymentProcessing : public TBaseState<FSM> {
     public:
         using TBaseState<FSM>::_context;
-        explicit TPaymentProcessing(std::reference_wrapper<FSM> context, std::string cardNumber)
+        TPaymentProcessing(std::reference_wrapper<FSM> context, const Pan & card)
             : TBaseState<FSM>(context)
-            , _cardNumber(std::move(cardNumber))
+            , _card(card)
 #if !DISABLE_TIMEOUT_MANAGER
             , _timeoutManager(
-                  [&] {
-                      _context.get().process(Timeout{});
+                  [context] {
+                      context.get().process(Timeout{});
                   },
                   2s)
 #endif
         {
-            auto & fsm = _context.get();
-            fsm.getDoor().close();
-            fsm.getLED().setStatus(LEDController::eStatus::OrangeCross);
-            fsm.getPOS().setRows("Processing");
-            fsm.initiateTransaction(GATEWAYS[_retryCount], _cardNumber, getFare());
+            enter();
+            _context.get().initiateTransaction(GATEWAYS[_retryCount], _card, getFare());
+        }
+
+        // a saved session, checked before the gate is touched
+        struct Saved {
+            static std::optional<Saved> load(adc::SnapshotReader & in) {
+                const auto retryCount = in.read<std::uint8_t>();
+                const auto card = Pan::parse(in.readString());
+                if (!in.ok() || retryCount >= GATEWAYS.size() || !card) {
+                    return std::nullopt;
+                }
+                return Saved{retryCount, *card};
+            }
+
+            std::uint8_t retryCount;
+            Pan card;
+        };
+
+        // resumes waiting for the gateway of a saved session, without initiating the transaction again
+        TPaymentProcessing(const Saved & saved, std::reference_wrapper<FSM> context)
+            : TBaseState<FSM>(context)
+            , _retryCount(saved.retryCount)
+            , _card(saved.card)
+#if !DISABLE_TIMEOUT_MANAGER
+            , _timeoutManager(
+                  [context] {
+                      context.get().process(Timeout{});
+                  },
+                  2s)
+#endif
+        {
+            enter();
+        }
+
+        void save(adc::SnapshotWriter & out) const {
+            out.write(_retryCount);
+            out.write(_card.text().view());
         }
 
         eState getState() const {
@@ -90,7 +138,7 @@ namespace states {
             if (++_retryCount >= GATEWAYS.size()) {
                 return false;
             }
-            _context.get().initiateTransaction(GATEWAYS[_retryCount], _cardNumber, getFare());
+            _context.get().initiateTransaction(GATEWAYS[_retryCount], _card, getFare());
 #if !DISABLE_TIMEOUT_MANAGER
             _timeoutManager.restart(2s);
 #endif
@@ -98,21 +146,31 @@ namespace states {
         }
 
         using TBaseState<FSM>::process;
-        TOptState<FSM> process(TransactionDeclined event) {
-            return TPaymentFailed<FSM>(_context, std::move(event.reason));
+        TToPaymentFailed<FSM> process(const TransactionDeclined & event) {
+            return adc::transitionTo<TPaymentFailed<FSM>>(_context, std::string_view{event.reason});
         }
 
-        TOptState<FSM> process(TransactionSuccess event) {
-            return TPaymentSuccess<FSM>(_context, event.fare, event.balance);
+        auto process(TransactionSuccess event) {
+            return adc::transitionTo<TPaymentSuccess<FSM>>(_context, event.fare, event.balance);
         }
 
-        TOptState<FSM> process(Timeout event) {
-            return tryRetry() ? TOptState<FSM>{} : TPaymentFailed<FSM>(_context, "Network Failure");
+        std::optional<TToPaymentFailed<FSM>> process(Timeout event) {
+            if (tryRetry()) {
+                return std::nullopt;
+            }
+            return adc::transitionTo<TPaymentFailed<FSM>>(_context, "Network Failure");
         }
 
     private:
-        size_t _retryCount{0};
-        std::string _cardNumber;
+        void enter() {
+            auto & fsm = _context.get();
+            fsm.getDoor().close();
+            fsm.getLED().setStatus(LEDController::eStatus::OrangeCross);
+            fsm.getPOS().show(POSTerminal::eMessage::Processing);
+        }
+
+        std::uint8_t _retryCount{0};
+        Pan _card;
 #if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
 #endif
@@ -122,21 +180,39 @@ namespace states {
     class TPaymentFailed : public TBaseState<FSM> {
     public:
         using TBaseState<FSM>::_context;
-        TPaymentFailed(std::reference_wrapper<FSM> context, std::string reason)
+        TPaymentFailed(std::reference_wrapper<FSM> context, std::string_view reason)
             : TBaseState<FSM>(context)
-            , _reason(std::move(reason))
+            , _reason(reason)
 #if !DISABLE_TIMEOUT_MANAGER
             , _timeoutManager(
-                  [&] {
-                      _context.get().process(Timeout{});
+                  [context] {
+                      context.get().process(Timeout{});
                   },
                   2s)
 #endif
         {
-            auto & fsm = _context.get();
-            fsm.getDoor().close();
-            fsm.getLED().setStatus(LEDController::eStatus::FlashRedCross);
-            fsm.getPOS().setRows("Declined", _reason);
+            enter();
+        }
+
+        struct Saved {
+            static std::optional<Saved> load(adc::SnapshotReader & in) {
+                const auto reason = in.readString();
+                if (!in.ok()) {
+                    return std::nullopt;
+                }
+                return Saved{reason};
+            }
+
+            // points into the snapshot
+            std::string_view reason;
+        };
+
+        TPaymentFailed(const Saved & saved, std::reference_wrapper<FSM> context)
+            : TPaymentFailed(context, saved.reason) {
+        }
+
+        void save(adc::SnapshotWriter & out) const {
+            out.write(_reason.view());
         }
 
         eState getState() const {
@@ -144,12 +220,20 @@ namespace states {
         }
 
         using TBaseState<FSM>::process;
-        TOptState<FSM> process(Timeout event) {
-            return TLocked<FSM>(_context);
+        auto process(Timeout event) {
+            return adc::transitionTo<TLocked<FSM>>(_context);
         }
 
     private:
-        std::string _reason;
+        void enter() {
+            auto & fsm = _context.get();
+            fsm.getDoor().close();
+            fsm.getLED().setStatus(LEDController::eStatus::FlashRedCross);
+            fsm.getPOS().show(POSTerminal::eMessage::Declined, _reason.view());
+        }
+
+        // no longer than the display showing it
+        POSTerminal::Row _reason;
 #if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
 #endif
@@ -161,10 +245,12 @@ namespace states {
         using TBaseState<FSM>::_context;
         TPaymentSuccess(std::reference_wrapper<FSM> context, int fare, int balance)
             : TBaseState<FSM>(context)
+            , _fare(fare)
+            , _balance(balance)
 #if !DISABLE_TIMEOUT_MANAGER
             , _timeoutManager(
-                  [&] {
-                      _context.get().process(Timeout{});
+                  [context] {
+                      context.get().process(Timeout{});
                   },
                   2s)
 #endif
@@ -172,9 +258,30 @@ namespace states {
             auto & fsm = _context.get();
             fsm.getDoor().open();
             fsm.getLED().setStatus(LEDController::eStatus::GreenArrow);
-            fsm.getPOS().setRows(
-                "Approved", std::string("Fare: ") + std::to_string(fare),
-                std::string("Balance: ") + std::to_string(balance));
+            fsm.getPOS().show(POSTerminal::eMessage::Paid, _fare, _balance);
+        }
+
+        struct Saved {
+            static std::optional<Saved> load(adc::SnapshotReader & in) {
+                const auto fare = in.read<int>();
+                const auto balance = in.read<int>();
+                if (!in.ok()) {
+                    return std::nullopt;
+                }
+                return Saved{fare, balance};
+            }
+
+            int fare;
+            int balance;
+        };
+
+        TPaymentSuccess(const Saved & saved, std::reference_wrapper<FSM> context)
+            : TPaymentSuccess(context, saved.fare, saved.balance) {
+        }
+
+        void save(adc::SnapshotWriter & out) const {
+            out.write(_fare);
+            out.write(_balance);
         }
 
         eState getState() const {
@@ -182,15 +289,17 @@ namespace states {
         }
 
         using TBaseState<FSM>::process;
-        TOptState<FSM> process(PersonPassed event) {
-            return TLocked<FSM>(_context);
+        auto process(PersonPassed event) {
+            return adc::transitionTo<TLocked<FSM>>(_context);
         }
 
-        TOptState<FSM> process(Timeout event) {
-            return TUnlocked<FSM>(_context);
+        auto process(Timeout event) {
+            return adc::transitionTo<TUnlocked<FSM>>(_context);
         }
 
     private:
+        int _fare;
+        int _balance;
 #if !DISABLE_TIMEOUT_MANAGER
         TimeoutManager _timeoutManager;
 #endif
@@ -204,7 +313,7 @@ namespace states {
             auto & fsm = _context.get();
             fsm.getDoor().open();
             fsm.getLED().setStatus(LEDController::eStatus::GreenArrow);
-            fsm.getPOS().setRows("Approved");
+            fsm.getPOS().show(POSTerminal::eMessage::Approved);
         }
 
         eState getState() const {
@@ -212,8 +321,8 @@ namespace states {
         }
 
         using TBaseState<FSM>::process;
-        TOptState<FSM> process(PersonPassed event) {
-            return TLocked<FSM>(_context);
+        auto process(PersonPassed event) {
+            return adc::transitionTo<TLocked<FSM>>(_context);
         }
     };
 } // namespace states
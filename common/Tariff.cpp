@@ -0,0 +1,132 @@
+#include "Tariff.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    constexpr std::time_t SECONDS_PER_DAY = 24 * 60 * 60;
+
+    std::chrono::seconds localUtcOffset(std::time_t now) {
+        std::tm local{};
+        std::tm utc{};
+#ifdef _WIN32
+        localtime_s(&local, &now);
+        gmtime_s(&utc, &now);
+#else
+        localtime_r(&now, &local);
+        gmtime_r(&now, &utc);
+#endif
+        // the two differ by less than a day, so comparing the time of day and the day of the year is enough
+        std::time_t offset =
+            (local.tm_hour - utc.tm_hour) * 3600 + (local.tm_min - utc.tm_min) * 60 + local.tm_sec - utc.tm_sec;
+        if (local.tm_year != utc.tm_year) {
+            offset += local.tm_year > utc.tm_year ? SECONDS_PER_DAY : -SECONDS_PER_DAY;
+        } else if (local.tm_yday != utc.tm_yday) {
+            offset += local.tm_yday > utc.tm_yday ? SECONDS_PER_DAY : -SECONDS_PER_DAY;
+        }
+        return std::chrono::seconds{offset};
+    }
+} // namespace
+
+FareTable defaultFareTable() {
+    using std::chrono::hours;
+    return {{hours{0}, 3}, {hours{6}, 7}, {hours{10}, 5}, {hours{15}, 7}, {hours{18}, 5}, {hours{22}, 3}};
+}
+
+std::optional<FareTable> parseFareTable(std::istream & in) {
+    FareTable table;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields{line.substr(0, line.find('#'))};
+        int hour = 0;
+        int minute = 0;
+        char colon = 0;
+        int fare = 0;
+        if (!(fields >> hour)) {
+            if (fields.eof()) {
+                continue; // blank or comment
+            }
+            return std::nullopt;
+        }
+        std::string rest;
+        if (!(fields >> colon >> minute >> fare) || colon != ':' || fields >> rest || hour < 0 || hour > 23 ||
+            minute < 0 || minute > 59 || fare < 0) {
+            return std::nullopt;
+        }
+        const std::chrono::minutes start{hour * 60 + minute};
+        if (table.empty() ? start.count() != 0 : start <= table.back().start) {
+            return std::nullopt;
+        }
+        table.push_back(FareBand{start, fare});
+    }
+    if (table.empty()) {
+        return std::nullopt;
+    }
+    return table;
+}
+
+TariffService::TariffService(FareTable table, std::optional<std::chrono::seconds> utcOffset)
+    : _utcOffset(utcOffset), _table(std::move(table)) {
+}
+
+TariffService & TariffService::instance() {
+    static TariffService service;
+    static const bool configured = [] {
+        if (const auto * path = std::getenv("TURNSTILE_FARES")) {
+            return service.loadFile(path);
+        }
+        return false;
+    }();
+    static_cast<void>(configured);
+    return service;
+}
+
+void TariffService::setTable(FareTable table) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _table = std::move(table);
+    publish(0, 0, 0);
+}
+
+bool TariffService::loadFile(const std::string & path) {
+    std::ifstream in{path};
+    if (!in) {
+        return false;
+    }
+    auto table = parseFareTable(in);
+    if (!table) {
+        return false;
+    }
+    setTable(std::move(*table));
+    return true;
+}
+
+int TariffService::refresh(std::time_t now) const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    const auto offset = _utcOffset ? *_utcOffset : localUtcOffset(now);
+    const auto local = ((now + offset.count()) % SECONDS_PER_DAY + SECONDS_PER_DAY) % SECONDS_PER_DAY;
+    std::time_t start = 0;
+    auto next = SECONDS_PER_DAY;
+    auto fare = _table.back().fare;
+    for (auto band = _table.rbegin(); band != _table.rend(); ++band) {
+        start = std::chrono::duration_cast<std::chrono::seconds>(band->start).count();
+        if (start <= local) {
+            fare = band->fare;
+            break;
+        }
+        next = start;
+    }
+    publish(now - local + start, now - local + next, fare);
+    return fare;
+}
+
+// with _mutex held
+void TariffService::publish(std::time_t start, std::time_t end, int fare) const {
+    const auto sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _start.store(start, std::memory_order_relaxed);
+    _end.store(end, std::memory_order_relaxed);
+    _fare.store(fare, std::memory_order_relaxed);
+    _sequence.store(sequence + 2, std::memory_order_release);
+}
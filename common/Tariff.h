@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The fare charged from a local time of day until the next band starts.
+struct FareBand {
+    std::chrono::minutes start;
+    int fare;
+};
+
+// Bands sorted by start, the first starting at midnight. The default is the peak/off-peak schedule the turnstiles
+// shipped with.
+using FareTable = std::vector<FareBand>;
+
+FareTable defaultFareTable();
+
+// Parses one band per line, "HH:MM fare", ignoring blank lines and comments starting with '#'. Returns nothing if a
+// line is malformed or the bands are not sorted from midnight on.
+std::optional<FareTable> parseFareTable(std::istream & in);
+
+// Looks the fare up once per band: the current fare is cached together with the times its band starts and ends, so
+// that fare() reads the cache without locking until then. Only recomputing the band, a few times a day, takes the
+// mutex.
+class TariffService {
+public:
+    // the local time zone is read when a band is recomputed, unless utcOffset fixes it
+    explicit TariffService(FareTable table = defaultFareTable(), std::optional<std::chrono::seconds> utcOffset = {});
+
+    TariffService(const TariffService & other) = delete;
+    TariffService & operator=(const TariffService & other) = delete;
+
+    // the service used by getFare(), loading the file named by the TURNSTILE_FARES environment variable if set
+    static TariffService & instance();
+
+    int fare() const {
+        return fare(std::time(nullptr));
+    }
+
+    int fare(std::time_t now) const {
+        const auto sequence = _sequence.load(std::memory_order_acquire);
+        const auto start = _start.load(std::memory_order_relaxed);
+        const auto end = _end.load(std::memory_order_relaxed);
+        const auto fare = _fare.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence % 2 == 0 && sequence == _sequence.load(std::memory_order_relaxed) && start <= now && now < end) {
+            return fare;
+        }
+        return refresh(now);
+    }
+
+    // the table must follow the rules of parseFareTable
+    void setTable(FareTable table);
+
+    // keeps the current table and returns false if the file cannot be read or parsed
+    bool loadFile(const std::string & path);
+
+private:
+    int refresh(std::time_t now) const;
+    void publish(std::time_t start, std::time_t end, int fare) const;
+
+    const std::optional<std::chrono::seconds> _utcOffset;
+    mutable std::mutex _mutex;
+    FareTable _table;
+    // the cached band, published under a sequence number which is odd while it is being written
+    mutable std::atomic<std::uint32_t> _sequence{0};
+    mutable std::atomic<std::time_t> _start{0};
+    mutable std::atomic<std::time_t> _end{0};
+    mutable std::atomic<int> _fare{0};
+};
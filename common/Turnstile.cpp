@@ -1,6 +1,10 @@
 #include "Turnstile.h"
+#include "Tariff.h"
 
 #include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
 
 const std::array<std::string, 3> GATEWAYS = {"Gateway1", "Gateway2", "Gateway3"};
 
@@ -45,16 +49,80 @@ const char * to_string(eState e) {
 }
 
 int getFare() {
-    const auto now = std::time(nullptr);
-    const auto calTime = *std::localtime(&now);
-    const auto currentHour = calTime.tm_hour;
-    constexpr int rates[] = {3, 3, 3, 3, 3, 3, 7, 7, 7, 7, 5, 5, 5, 5, 5, 7, 7, 7, 5, 5, 5, 5, 3, 3};
-    return rates[currentHour % 24];
+    return TariffService::instance().fare();
 }
 
+namespace {
+    // A one-shot timer owning its task. Handles are ids into a registry of pending timers rather than pointers: the
+    // first of expire() and cancelTimer() to take a timer out of the registry owns it, so a handle cancelled after its
+    // timer fired, or while it is firing on the TimerService thread, is a no-op instead of a dangling pointer.
+    class OneShotTimer final : public adc::TimerNode {
+    public:
+        static void * create(std::function<void()> task, std::chrono::milliseconds duration) {
+            auto & registry = Registry::instance();
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            const auto id = ++registry.lastId;
+            const auto timer = new OneShotTimer(std::move(task), id);
+            registry.pending.emplace(id, timer);
+            // scheduled under the registry lock, so that the timer cannot expire before it is registered
+            timer->_source.schedule(*timer, duration);
+            return reinterpret_cast<void *>(static_cast<std::uintptr_t>(id));
+        }
+
+        static void cancel(void * handle) {
+            if (const auto timer = take(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(handle)))) {
+                // waits for an expire() already running on the TimerService thread, which found the timer taken
+                timer->_source.cancel(*timer);
+                delete timer;
+            }
+        }
+
+    private:
+        struct Registry {
+            static Registry & instance() {
+                static Registry registry;
+                return registry;
+            }
+
+            std::mutex mutex;
+            std::uint64_t lastId{0};
+            std::unordered_map<std::uint64_t, OneShotTimer *> pending;
+        };
+
+        OneShotTimer(std::function<void()> task, std::uint64_t id) : _task(std::move(task)), _id(id) {
+        }
+
+        static OneShotTimer * take(std::uint64_t id) {
+            auto & registry = Registry::instance();
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            const auto it = registry.pending.find(id);
+            if (it == registry.pending.end()) {
+                return nullptr;
+            }
+            const auto timer = it->second;
+            registry.pending.erase(it);
+            return timer;
+        }
+
+        void expire() override {
+            if (!take(_id)) {
+                return;
+            }
+            auto task = std::move(_task);
+            delete this;
+            task();
+        }
+
+        std::function<void()> _task;
+        const std::uint64_t _id;
+        adc::TimerSource & _source{adc::TimerSource::current()};
+    };
+} // namespace
+
 void * createTimer(std::function<void()> task, std::chrono::milliseconds duration) {
-    return nullptr;
+    return OneShotTimer::create(std::move(task), duration);
 }
 
 void cancelTimer(void * handle) {
-}
\ No newline at end of file
+    OneShotTimer::cancel(handle);
+}
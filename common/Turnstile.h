@@ -1,9 +1,22 @@
 #pragma once
 
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <functional>
-#include <sstream>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 extern const std::array<std::string, 3> GATEWAYS;
 
@@ -28,40 +41,163 @@ private:
     eStatus _status{eStatus::Closed};
 };
 
+// The terminal keeps what it was asked to show as a message id and its arguments, and renders the text only when a
+// row is read, since most screens are replaced before anyone looks at them. Rows live in fixed buffers sized to the
+// display, so neither showing nor rendering allocates; text beyond COLUMNS is cut off, as the display would.
+// Reading rows of a const terminal from several threads at once is safe, e.g. logging it while a display thread shows
+// it: the first reader renders and the others wait for it. Showing something while others read is not.
 class POSTerminal {
 public:
-    explicit POSTerminal(std::string firstRow, std::string secondRow = "", std::string thirdRow = "")
-        : _firstRow(std::move(firstRow)), _secondRow(std::move(secondRow)), _thirdRow(std::move(thirdRow)) {
+    static constexpr std::size_t COLUMNS = 20;
+
+    static constexpr std::string_view TOUCH_CARD{"Touch Card"};
+    static constexpr std::string_view PROCESSING{"Processing"};
+    static constexpr std::string_view APPROVED{"Approved"};
+    static constexpr std::string_view DECLINED{"Declined"};
+
+    // Declined takes the reason, Paid the fare and the balance
+    enum class eMessage : std::uint8_t { Rows, TouchCard, Processing, Declined, Approved, Paid };
+
+    class Row {
+    public:
+        Row() : _text{}, _size(0) {
+        }
+
+        template <typename Text, std::enable_if_t<std::is_convertible_v<const Text &, std::string_view>, int> = 0>
+        Row(const Text & text) : Row() { // NOLINT(google-explicit-constructor)
+            append(text);
+        }
+
+        // the label followed by value, e.g. "Fare: 5"
+        Row(std::string_view label, int value) : Row() {
+            append(label);
+            const auto [end, error] = std::to_chars(_text.data() + _size, _text.data() + COLUMNS, value);
+            if (error == std::errc{}) {
+                _size = static_cast<std::uint8_t>(end - _text.data());
+            }
+        }
+
+        std::string_view view() const {
+            return {_text.data(), _size};
+        }
+
+    private:
+        void append(std::string_view text) {
+            const auto size = std::min(text.size(), COLUMNS - _size);
+            std::copy_n(text.data(), size, _text.data() + _size);
+            _size = static_cast<std::uint8_t>(_size + size);
+        }
+
+        // not default member initialisers, which POSTerminal's default arguments could not use yet
+        std::array<char, COLUMNS> _text;
+        std::uint8_t _size;
+    };
+
+    explicit POSTerminal(Row firstRow, Row secondRow = {}, Row thirdRow = {}) {
+        setRows(firstRow, secondRow, thirdRow);
+    }
+
+    POSTerminal(const POSTerminal & other)
+        : _message(other._message), _numbers(other._numbers), _rows(other.rendered()) {
+    }
+
+    POSTerminal & operator=(const POSTerminal & other) {
+        _message = other._message;
+        _numbers = other._numbers;
+        _rows = other.rendered();
+        _render.store(eRender::Rendered, std::memory_order_relaxed);
+        return *this;
+    }
+
+    // free text, shown as is
+    void setRows(Row firstRow, Row secondRow = {}, Row thirdRow = {}) {
+        _message = eMessage::Rows;
+        _rows = {firstRow, secondRow, thirdRow};
+        _render.store(eRender::Rendered, std::memory_order_relaxed);
     }
 
-    void setRows(std::string firstRow, std::string secondRow = "", std::string thirdRow = "") {
-        _firstRow = std::move(firstRow);
-        _secondRow = std::move(secondRow);
-        _thirdRow = std::move(thirdRow);
+    void show(eMessage message, int first = 0, int second = 0) {
+        _message = message;
+        _numbers = {first, second};
+        _render.store(eRender::Stale, std::memory_order_relaxed);
+    }
+
+    void show(eMessage message, std::string_view text) {
+        _message = message;
+        _rows[1] = text;
+        _render.store(eRender::Stale, std::memory_order_relaxed);
+    }
+
+    eMessage getMessage() const {
+        return _message;
     }
 
     std::string getRows() const {
-        std::stringstream stm;
-        stm << _firstRow << ", " << _secondRow << ", " << _thirdRow;
-        return stm.str();
+        std::string rows;
+        rows.reserve(3 * COLUMNS + 4);
+        rows.append(getFirstRow()).append(", ").append(getSecondRow()).append(", ").append(getThirdRow());
+        return rows;
     }
 
-    const std::string & getFirstRow() const {
-        return _firstRow;
+    std::string_view getFirstRow() const {
+        return rendered()[0].view();
     }
 
-    const std::string & getSecondRow() const {
-        return _secondRow;
+    std::string_view getSecondRow() const {
+        return rendered()[1].view();
     }
 
-    const std::string & getThirdRow() const {
-        return _thirdRow;
+    std::string_view getThirdRow() const {
+        return rendered()[2].view();
     }
 
 private:
-    std::string _firstRow;
-    std::string _secondRow;
-    std::string _thirdRow;
+    enum class eRender : std::uint8_t { Stale, Rendering, Rendered };
+
+    const std::array<Row, 3> & rendered() const {
+        if (_render.load(std::memory_order_acquire) != eRender::Rendered) {
+            render();
+        }
+        return _rows;
+    }
+
+    // the reader claiming the stale rows renders them; concurrent readers wait until it is done
+    void render() const {
+        auto expected = eRender::Stale;
+        if (!_render.compare_exchange_strong(expected, eRender::Rendering, std::memory_order_acquire)) {
+            while (_render.load(std::memory_order_acquire) != eRender::Rendered) {
+                std::this_thread::yield();
+            }
+            return;
+        }
+        switch (_message) {
+        case eMessage::TouchCard:
+            _rows = {TOUCH_CARD};
+            break;
+        case eMessage::Processing:
+            _rows = {PROCESSING};
+            break;
+        case eMessage::Declined:
+            // the reason was kept in the second row
+            _rows[0] = DECLINED;
+            _rows[2] = {};
+            break;
+        case eMessage::Approved:
+            _rows = {APPROVED};
+            break;
+        case eMessage::Paid:
+            _rows = {APPROVED, Row{"Fare: ", _numbers[0]}, Row{"Balance: ", _numbers[1]}};
+            break;
+        case eMessage::Rows:
+            break;
+        }
+        _render.store(eRender::Rendered, std::memory_order_release);
+    }
+
+    eMessage _message{eMessage::Rows};
+    std::array<int, 2> _numbers{};
+    mutable std::array<Row, 3> _rows;
+    mutable std::atomic<eRender> _render{eRender::Rendered};
 };
 
 class LEDController {
@@ -96,6 +232,7 @@ struct TransactionSuccess {
 
 struct PersonPassed {};
 struct Timeout {};
+using AnyEvent = std::variant<CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout>;
 
 // states
 enum class eState { Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked };
@@ -104,6 +241,7 @@ const char * to_string(SwingDoor::eStatus e);
 const char * to_string(LEDController::eStatus e);
 const char * to_string(eState e);
 int getFare();
+// cancelling a handle whose task has run, or is running, does nothing
 void * createTimer(std::function<void()> task, std::chrono::milliseconds duration);
 void cancelTimer(void * handle);
 
@@ -126,37 +264,89 @@ constexpr std::string_view type_name() {
 #endif
 }
 
-class TimeoutManager {
+// Runs fn once duration has elapsed, unless restarted or destroyed first. The timer node and fn are embedded, so
+// arming it does not allocate; fn may therefore capture no more than a pointer, such as the reference_wrapper of its
+// FSM. fn runs wherever the timer source fires its timers.
+//
+// Every arming, by construction or restart(), takes the next generation of one process wide count. While fn runs,
+// expiringGeneration() is the generation its timeout was armed with, so that an FSM whose events queue can tell a
+// timeout of the state it has left since from one of the state it is in (see fsm_strand).
+class TimeoutManager : private adc::TimerNode {
 public:
-    TimeoutManager(std::function<void()> fn, std::chrono::milliseconds duration)
-        : _fn(std::move(fn))
-        , _timeoutHandler(createTimer(
-              [&] {
-                  _timeoutHandler = nullptr;
-                  _fn();
-              },
-              duration)) {
+    template <typename Fn>
+    TimeoutManager(Fn fn, std::chrono::milliseconds duration)
+        : _invoke(&invoke<Fn>), _source(&adc::TimerSource::current()), _generation(arm()) {
+        static_assert(sizeof(Fn) <= sizeof(_fn) && alignof(Fn) <= alignof(void *) && std::is_trivially_copyable_v<Fn>,
+            "a timeout callback captures at most a pointer");
+        new (_fn) Fn(fn);
+        _source->schedule(*this, duration);
+    }
+
+    // the pending timeout moves along with the callback
+    TimeoutManager(TimeoutManager && other) noexcept
+        : _invoke(other._invoke), _source(other._source), _generation(other._generation) {
+        std::memcpy(_fn, other._fn, sizeof(_fn));
+        _source->replace(other, *this);
+    }
+
+    TimeoutManager & operator=(TimeoutManager && other) noexcept {
+        _source->cancel(*this);
+        std::memcpy(_fn, other._fn, sizeof(_fn));
+        _invoke = other._invoke;
+        _source = other._source;
+        _generation = other._generation;
+        _source->replace(other, *this);
+        return *this;
     }
 
     void restart(std::chrono::milliseconds duration) {
-        if (_timeoutHandler) {
-            cancelTimer(_timeoutHandler);
-        }
-        _timeoutHandler = createTimer(
-            [&] {
-                _timeoutHandler = nullptr;
-                _fn();
-            },
-            duration);
+        _generation = arm();
+        _source->schedule(*this, duration);
     }
 
     ~TimeoutManager() {
-        if (_timeoutHandler) {
-            cancelTimer(_timeoutHandler);
-        }
+        _source->cancel(*this);
+    }
+
+    // the generation the next arming will take; every timeout armed before has a lower one
+    static std::uint64_t nextGeneration() {
+        return generations().load(std::memory_order_relaxed);
+    }
+
+    // of the timeout whose callback runs on this thread, 0 outside of one
+    static std::uint64_t expiringGeneration() {
+        return expiring();
     }
 
 private:
-    std::function<void()> _fn;
-    void * _timeoutHandler{nullptr};
+    template <typename Fn>
+    static void invoke(void * fn) {
+        (*std::launder(static_cast<Fn *>(fn)))();
+    }
+
+    static std::atomic<std::uint64_t> & generations() {
+        static std::atomic<std::uint64_t> next{1};
+        return next;
+    }
+
+    static std::uint64_t & expiring() {
+        static thread_local std::uint64_t generation = 0;
+        return generation;
+    }
+
+    static std::uint64_t arm() {
+        return generations().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // fn may restart the timeout, or destroy it by a transition
+    void expire() override {
+        const auto previous = std::exchange(expiring(), _generation);
+        _invoke(_fn);
+        expiring() = previous;
+    }
+
+    alignas(void *) unsigned char _fn[sizeof(void *)];
+    void (*_invoke)(void *);
+    adc::TimerSource * _source;
+    std::uint64_t _generation;
 };
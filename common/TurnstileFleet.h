@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Logging.h"
+#include "FSMFleet.h"
+#include "States.h"
+#include "Turnstile.h"
+#include "TurnstileJournal.h"
+
+#include <utility>
+#include <vector>
+
+namespace fsm_fleet {
+    class Fleet;
+
+    // The devices of one gate. States of the fleet use it as their FSM context.
+    class Gate {
+    public:
+        Gate(Fleet & fleet, std::size_t id) : _fleet(fleet), _id(id) {
+        }
+
+        template <typename Event>
+        Gate & process(Event event);
+
+        [[nodiscard]] SwingDoor & getDoor() {
+            return _door;
+        }
+
+        [[nodiscard]] POSTerminal & getPOS() {
+            return _pos;
+        }
+
+        [[nodiscard]] LEDController & getLED() {
+            return _led;
+        }
+
+        // External Actions
+        void initiateTransaction(const std::string & gateway, const Pan & card, int amount) {
+            logTransaction(gateway, card, amount);
+        }
+
+    private:
+        std::reference_wrapper<Fleet> _fleet;
+        std::size_t _id;
+
+        // Connected Devices
+        SwingDoor _door;
+        POSTerminal _pos{""};
+        LEDController _led;
+    };
+
+    using Locked = states::TLocked<Gate>;
+    using PaymentProcessing = states::TPaymentProcessing<Gate>;
+    using PaymentFailed = states::TPaymentFailed<Gate>;
+    using PaymentSuccess = states::TPaymentSuccess<Gate>;
+    using Unlocked = states::TUnlocked<Gate>;
+
+    struct TransitionTable {
+        template <typename State, typename Event>
+        auto operator()(State & state, Event event) {
+            return state.process(std::move(event));
+        }
+    };
+
+    class Fleet {
+    public:
+        explicit Fleet(std::size_t size)
+            : _gates(makeGates(*this, size))
+            , _fsm{TransitionTable{}, size, [this](std::size_t id) {
+                       return adc::transitionTo<Locked>(std::ref(_gates[id]));
+                   }} {
+        }
+
+        template <typename Event>
+        Fleet & process(std::size_t gateId, Event event) {
+            if (_journal) {
+                _journal->append(gateId, event);
+            }
+            _fsm.process(gateId, std::move(event));
+            return *this;
+        }
+
+        // from now on every event sent to a gate, including its timeouts, is appended to journal first
+        void setJournal(TurnstileJournal * journal) {
+            _journal = journal;
+        }
+
+        // Sends every event of journal to its gate as fast as it is read, and returns how many there were. The events
+        // are not appended to the fleet's own journal again. Timeouts are replayed from the journal like any other
+        // event, so the timers armed meanwhile are held by a timer source of the fleet's own; once the journal is
+        // done, those still pending are armed on the current source for their full duration, and a gate replayed
+        // into a state with a timeout carries on from there. Timers armed by other threads meanwhile are unaffected.
+        std::size_t replay(TurnstileJournalReplay & journal) {
+            const auto attached = std::exchange(_journal, nullptr);
+            _replayTimers.hold();
+            std::size_t events = 0;
+            {
+                adc::TimerSource::ThreadOverride deferred{_replayTimers};
+                events = journal.replay([this](std::size_t gateId, std::chrono::nanoseconds /*timestamp*/, auto event) {
+                    if (gateId < size()) {
+                        _fsm.process(gateId, std::move(event));
+                    }
+                });
+            }
+            _replayTimers.release();
+            _journal = attached;
+            return events;
+        }
+
+        template <typename Event>
+        std::size_t processAll(const Event & event) {
+            return _fsm.processAll(event);
+        }
+
+        eState getState(std::size_t gateId) const {
+            return _fsm.getState(gateId);
+        }
+
+        [[nodiscard]] Gate & getGate(std::size_t gateId) {
+            return _gates[gateId];
+        }
+
+        std::size_t size() const {
+            return _gates.size();
+        }
+
+    private:
+        static std::vector<Gate> makeGates(Fleet & fleet, std::size_t size) {
+            std::vector<Gate> gates;
+            gates.reserve(size);
+            for (std::size_t id = 0; id < size; ++id) {
+                gates.emplace_back(fleet, id);
+            }
+            return gates;
+        }
+
+        std::vector<Gate> _gates;
+        TurnstileJournal * _journal{nullptr};
+        // outlives the states whose timers were armed on it during replay
+        adc::DeferredTimerSource _replayTimers;
+        adc::TFSMFleet<TransitionTable, Locked, PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked> _fsm;
+    };
+
+    template <typename Event>
+    Gate & Gate::process(Event event) {
+        _fleet.get().process(_id, std::move(event));
+        return *this;
+    }
+} // namespace fsm_fleet
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Journal.h"
+#include "Turnstile.h"
+
+#include <string>
+
+// TransactionSuccess, PersonPassed and Timeout are plain values; the two events carrying text write it
+// length-prefixed.
+template <>
+struct adc::TJournalCodec<CardPresented> {
+    static void encode(SnapshotWriter & out, const CardPresented & event) {
+        out.write(event.cardNumber);
+    }
+
+    static CardPresented decode(SnapshotReader & in) {
+        return CardPresented{std::string{in.readString()}};
+    }
+};
+
+template <>
+struct adc::TJournalCodec<TransactionDeclined> {
+    static void encode(SnapshotWriter & out, const TransactionDeclined & event) {
+        out.write(event.reason);
+    }
+
+    static TransactionDeclined decode(SnapshotReader & in) {
+        return TransactionDeclined{std::string{in.readString()}};
+    }
+};
+
+// the order numbers the events on disk
+using TurnstileJournal = adc::TJournal<CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout>;
+using TurnstileJournalReplay =
+    adc::TJournalReplay<CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout>;
@@ -0,0 +1,149 @@
+#pragma once
+
+// Coroutine support needs C++20; ADC_COROUTINES is defined when it is available.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define ADC_COROUTINES 1
+
+#include <algorithm>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+
+namespace adc {
+    // Recycles the frames of the coroutines of one owner, usually an FSM. Frames of one coroutine all have the same
+    // size, so freed blocks are kept on a free list and handed out again to requests that fit; the pool only allocates
+    // while more frames are alive than ever before. Not thread safe: the coroutines of an owner run on its executor.
+    class FramePool {
+    public:
+        FramePool() = default;
+        FramePool(const FramePool & other) = delete;
+        FramePool & operator=(const FramePool & other) = delete;
+
+        // every frame must have been freed, i.e. every coroutine of the owner finished
+        ~FramePool() {
+            while (_free) {
+                auto * block = _free;
+                _free = block->next;
+                ::operator delete(block, _blockSize);
+            }
+        }
+
+        void * allocate(std::size_t size) {
+            if (_blockSize == 0) {
+                _blockSize = std::max(size, sizeof(Block));
+            }
+            if (size > _blockSize) {
+                return ::operator new(size);
+            }
+            ++_live;
+            if (auto * block = _free) {
+                _free = block->next;
+                return block;
+            }
+            return ::operator new(_blockSize);
+        }
+
+        void deallocate(void * frame, std::size_t size) {
+            if (size > _blockSize) {
+                ::operator delete(frame, size);
+                return;
+            }
+            --_live;
+            _free = new (frame) Block{_free};
+        }
+
+        // frames allocated and not yet freed
+        std::size_t live() const {
+            return _live;
+        }
+
+    private:
+        struct Block {
+            Block * next;
+        };
+
+        Block * _free{nullptr};
+        std::size_t _blockSize{0};
+        std::size_t _live{0};
+    };
+
+    // Where a coroutine suspended on an outside call is resumed once the call is answered, usually the serial queue of
+    // its FSM (see Resume), so that it only ever touches its FSM where the FSM's events are processed. resume() may be
+    // called from any thread and returns false, leaving the coroutine suspended, when it cannot take the handle yet.
+    class Resumer {
+    public:
+        virtual bool resume(std::coroutine_handle<> handle) = 0;
+
+    protected:
+        ~Resumer() = default;
+    };
+
+    // A coroutine to resume, posted as an event among those of its FSM
+    struct Resume {
+        std::coroutine_handle<> handle;
+    };
+
+    // The return type of an action which co_awaits: it starts at once, runs until its first suspension and frees
+    // itself when done; nobody waits for it. A coroutine which is a member of a class with a FramePool & framePool()
+    // takes its frame from that pool, any other from the heap. The pool's owner must outlive the coroutine.
+    class AsyncAction {
+    public:
+        struct promise_type {
+            template <typename Owner, typename... Args>
+            requires requires(Owner & owner) {
+                { owner.framePool() } -> std::same_as<FramePool &>;
+            }
+            static void * operator new(std::size_t size, Owner & owner, Args &... /*unused*/) {
+                return allocate(&owner.framePool(), size);
+            }
+
+            static void * operator new(std::size_t size) {
+                return allocate(nullptr, size);
+            }
+
+            static void operator delete(void * frame, std::size_t size) {
+                auto * block = static_cast<std::byte *>(frame) - HEADER;
+                auto * pool = *std::launder(reinterpret_cast<FramePool **>(block));
+                if (pool) {
+                    pool->deallocate(block, size + HEADER);
+                } else {
+                    ::operator delete(block, size + HEADER);
+                }
+            }
+
+            AsyncAction get_return_object() {
+                return {};
+            }
+
+            std::suspend_never initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() {
+            }
+
+            void unhandled_exception() {
+                std::terminate();
+            }
+
+        private:
+            // the frame is preceded by the pool it came from
+            static constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+            static void * allocate(FramePool * pool, std::size_t size) {
+                void * memory = pool ? pool->allocate(size + HEADER) : ::operator new(size + HEADER);
+                auto * block = static_cast<std::byte *>(memory);
+                new (block) FramePool *(pool);
+                return block + HEADER;
+            }
+        };
+    };
+} // namespace adc
+
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <variant>
+
+namespace adc {
+    // Bounded lock-free multi-producer single-consumer mailbox of std::variant<Events...>. Events are stored inline in a
+    // ring allocated once at construction, so posting never allocates. Any thread may post(); only one thread at a time
+    // may drain() the events into an FSM.
+    template <typename... Events>
+    class TEventMailbox {
+    public:
+        using EventType = std::variant<Events...>;
+
+        // capacity is rounded up to a power of two
+        explicit TEventMailbox(std::size_t capacity)
+            : _capacity(roundUp(capacity)), _mask(_capacity - 1), _cells(new Cell[_capacity]) {
+            for (std::size_t i = 0; i < _capacity; ++i) {
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        TEventMailbox(const TEventMailbox & other) = delete;
+        TEventMailbox(TEventMailbox && other) noexcept = delete;
+        TEventMailbox & operator=(const TEventMailbox & other) = delete;
+        TEventMailbox & operator=(TEventMailbox && other) noexcept = delete;
+
+        ~TEventMailbox() {
+            while (pop([](EventType &) {
+            })) {
+            }
+        }
+
+        // Returns false without blocking when the mailbox is full. An event whose construction may throw is built
+        // before a slot is claimed, so that a claimed slot is always published and the consumer never waits on it.
+        template <typename Event>
+        bool post(Event && event) {
+            if constexpr (std::is_nothrow_constructible_v<EventType, Event &&>) {
+                return emplace(std::forward<Event>(event));
+            } else {
+                return emplace(EventType(std::forward<Event>(event)));
+            }
+        }
+
+        // Processes the pending events in FIFO order (FIFO per producer) and returns how many were processed. Events
+        // posted while draining are picked up as long as fewer than limit events have been processed.
+        template <typename FSM>
+        std::size_t drain(FSM & fsm, std::size_t limit = static_cast<std::size_t>(-1)) {
+            std::size_t processed = 0;
+            while (processed < limit && pop([&](EventType & event) {
+                std::visit(
+                    [&](auto & alternative) {
+                        fsm.process(std::move(alternative));
+                    },
+                    event);
+            })) {
+                ++processed;
+            }
+            return processed;
+        }
+
+        // consumer side only
+        bool empty() const {
+            const auto & cell = _cells[_head & _mask];
+            return cell.sequence.load(std::memory_order_acquire) != _head + 1;
+        }
+
+        std::size_t capacity() const {
+            return _capacity;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            alignas(EventType) unsigned char storage[sizeof(EventType)];
+        };
+
+        static std::size_t roundUp(std::size_t capacity) {
+            std::size_t result = 2;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // constructs the event in the slot it claims, which must then be published
+        template <typename Event>
+        bool emplace(Event && event) {
+            static_assert(
+                std::is_nothrow_constructible_v<EventType, Event &&>, "the events must be nothrow move constructible");
+            auto position = _tail.load(std::memory_order_relaxed);
+            for (;;) {
+                auto & cell = _cells[position & _mask];
+                const auto sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (diff == 0) {
+                    if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        new (cell.storage) EventType(std::forward<Event>(event));
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    position = _tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        template <typename Fn>
+        bool pop(Fn && fn) {
+            auto & cell = _cells[_head & _mask];
+            if (cell.sequence.load(std::memory_order_acquire) != _head + 1) {
+                return false;
+            }
+            auto & event = *std::launder(reinterpret_cast<EventType *>(cell.storage));
+            // the slot is released even if processing throws
+            struct Release {
+                ~Release() {
+                    event.~EventType();
+                    cell.sequence.store(head + capacity, std::memory_order_release);
+                }
+                EventType & event;
+                Cell & cell;
+                std::size_t head;
+                std::size_t capacity;
+            } release{event, cell, _head++, _capacity};
+            fn(event);
+            return true;
+        }
+
+        static constexpr std::size_t CACHE_LINE = 64;
+
+        const std::size_t _capacity;
+        const std::size_t _mask;
+        std::unique_ptr<Cell[]> _cells;
+        // only touched by the consumer
+        alignas(CACHE_LINE) std::size_t _head{0};
+        // shared by the producers
+        alignas(CACHE_LINE) std::atomic<std::size_t> _tail{0};
+    };
+} // namespace adc
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "EventMailbox.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace adc::details {
+    // Chase-Lev work-stealing deque: the owning thread pushes and pops at the bottom, any thread steals from the top.
+    // The ring doubles when full; retired rings are kept until destruction since a thief may still be reading one.
+    template <typename T>
+    class TWorkStealingDeque {
+    public:
+        explicit TWorkStealingDeque(std::size_t capacity = 256) {
+            _rings.push_back(std::make_unique<Ring>(roundUp(capacity)));
+            _ring.store(_rings.back().get(), std::memory_order_relaxed);
+        }
+
+        TWorkStealingDeque(const TWorkStealingDeque & other) = delete;
+        TWorkStealingDeque & operator=(const TWorkStealingDeque & other) = delete;
+
+        // owner only
+        void push(T * item) {
+            const auto bottom = _bottom.load(std::memory_order_relaxed);
+            const auto top = _top.load(std::memory_order_acquire);
+            auto * ring = _ring.load(std::memory_order_relaxed);
+            if (bottom - top > static_cast<std::int64_t>(ring->mask)) {
+                ring = grow(*ring, top, bottom);
+            }
+            ring->at(bottom).store(item, std::memory_order_relaxed);
+            _bottom.store(bottom + 1, std::memory_order_release);
+        }
+
+        // owner only; nullptr when empty
+        T * pop() {
+            const auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+            auto * ring = _ring.load(std::memory_order_relaxed);
+            _bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto top = _top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto * item = ring->at(bottom).load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // the last item, race the thieves for it
+                if (!_top.compare_exchange_strong(
+                        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // any thread; nullptr when empty or when another thread won the race for the top item
+        T * steal() {
+            auto top = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto bottom = _bottom.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                return nullptr;
+            }
+            auto * item = _ring.load(std::memory_order_acquire)->at(top).load(std::memory_order_relaxed);
+            if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+    private:
+        struct Ring {
+            explicit Ring(std::size_t capacity) : mask(capacity - 1), items(new std::atomic<T *>[capacity]) {
+            }
+
+            std::atomic<T *> & at(std::int64_t index) {
+                return items[static_cast<std::size_t>(index) & mask];
+            }
+
+            const std::size_t mask;
+            std::unique_ptr<std::atomic<T *>[]> items;
+        };
+
+        static std::size_t roundUp(std::size_t capacity) {
+            std::size_t result = 2;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        Ring * grow(Ring & ring, std::int64_t top, std::int64_t bottom) {
+            _rings.push_back(std::make_unique<Ring>((ring.mask + 1) * 2));
+            auto * grown = _rings.back().get();
+            for (auto index = top; index < bottom; ++index) {
+                grown->at(index).store(ring.at(index).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            _ring.store(grown, std::memory_order_release);
+            return grown;
+        }
+
+        static constexpr std::size_t CACHE_LINE = 64;
+
+        alignas(CACHE_LINE) std::atomic<std::int64_t> _top{0};
+        alignas(CACHE_LINE) std::atomic<std::int64_t> _bottom{0};
+        std::atomic<Ring *> _ring{nullptr};
+        // owner only
+        std::vector<std::unique_ptr<Ring>> _rings;
+    };
+} // namespace adc::details
+
+namespace adc {
+    // A fixed pool of worker threads, each with its own work-stealing deque. Tasks submitted from a worker go to its
+    // own deque, tasks submitted from other threads to a shared injection queue; idle workers steal from the others.
+    class Executor {
+    public:
+        class Task {
+        public:
+            virtual void run() = 0;
+
+        protected:
+            ~Task() = default;
+        };
+
+        // threads == 0 uses one worker per hardware thread
+        explicit Executor(std::size_t threads = 0) {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            for (std::size_t index = 0; index < threads; ++index) {
+                _workers.push_back(std::make_unique<Worker>());
+            }
+            for (std::size_t index = 0; index < threads; ++index) {
+                _workers[index]->thread = std::thread{[this, index] {
+                    run(index);
+                }};
+            }
+        }
+
+        Executor(const Executor & other) = delete;
+        Executor & operator=(const Executor & other) = delete;
+
+        // runs the tasks already submitted before the workers exit
+        ~Executor() {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wakeup.notify_all();
+            for (auto & worker : _workers) {
+                worker->thread.join();
+            }
+        }
+
+        // the task must stay alive until it has run
+        void submit(Task & task) {
+            _outstanding.fetch_add(1);
+            auto * worker = currentWorker();
+            if (worker && worker->executor == this) {
+                worker->tasks.push(&task);
+            } else {
+                std::lock_guard<std::mutex> lock{_injectMutex};
+                _injected.push_back(&task);
+                _injectedSize.store(_injected.size(), std::memory_order_release);
+            }
+            _epoch.fetch_add(1);
+            if (_sleepers.load() > 0) {
+                { std::lock_guard<std::mutex> lock{_mutex}; }
+                _wakeup.notify_one();
+            }
+        }
+
+        // blocks until every submitted task, including those they submitted in turn, has run
+        void waitIdle() {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _idle.wait(lock, [&] {
+                return _outstanding.load() == 0;
+            });
+        }
+
+        std::size_t size() const {
+            return _workers.size();
+        }
+
+    private:
+        struct Worker {
+            details::TWorkStealingDeque<Task> tasks;
+            Executor * executor{nullptr};
+            std::thread thread;
+        };
+
+        static Worker *& currentWorker() {
+            static thread_local Worker * worker = nullptr;
+            return worker;
+        }
+
+        void run(std::size_t index) {
+            auto & self = *_workers[index];
+            self.executor = this;
+            currentWorker() = &self;
+            for (;;) {
+                const auto epoch = _epoch.load();
+                if (auto * task = next(index)) {
+                    task->run();
+                    if (_outstanding.fetch_sub(1) == 1) {
+                        { std::lock_guard<std::mutex> lock{_mutex}; }
+                        _idle.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock{_mutex};
+                if (_stopping) {
+                    return;
+                }
+                // a submit since epoch was read may have been missed by next(), so only sleep if there was none
+                ++_sleepers;
+                _wakeup.wait(lock, [&] {
+                    return _epoch.load() != epoch || _stopping;
+                });
+                --_sleepers;
+            }
+        }
+
+        Task * next(std::size_t index) {
+            if (auto * task = _workers[index]->tasks.pop()) {
+                return task;
+            }
+            if (_injectedSize.load(std::memory_order_acquire) > 0) {
+                std::lock_guard<std::mutex> lock{_injectMutex};
+                if (!_injected.empty()) {
+                    auto * task = _injected.front();
+                    _injected.pop_front();
+                    _injectedSize.store(_injected.size(), std::memory_order_release);
+                    return task;
+                }
+            }
+            for (std::size_t offset = 1; offset < _workers.size(); ++offset) {
+                if (auto * task = _workers[(index + offset) % _workers.size()]->tasks.steal()) {
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+
+        std::vector<std::unique_ptr<Worker>> _workers;
+        std::mutex _injectMutex;
+        std::deque<Task *> _injected;
+        std::atomic<std::size_t> _injectedSize{0};
+        std::atomic<std::size_t> _outstanding{0};
+        std::atomic<std::uint64_t> _epoch{0};
+        std::atomic<std::size_t> _sleepers{0};
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        std::condition_variable _idle;
+        bool _stopping{false};
+    };
+
+    // Serialises the events of one FSM on an Executor: events posted from any thread are processed one at a time, in
+    // order per producer, while the queues of different FSMs run in parallel. At most budget events are processed
+    // per turn before the queue yields its worker. The queue must be idle when destroyed, see Executor::waitIdle.
+    template <typename FSM, typename... Events>
+    class TSerialQueue final : private Executor::Task {
+    public:
+        TSerialQueue(Executor & executor, FSM & fsm, std::size_t capacity = 1024, std::size_t budget = 64)
+            : _executor(executor), _fsm(fsm), _mailbox(capacity), _budget(budget) {
+        }
+
+        TSerialQueue(const TSerialQueue & other) = delete;
+        TSerialQueue & operator=(const TSerialQueue & other) = delete;
+
+        // returns false without blocking when the queue is full
+        template <typename Event>
+        bool post(Event && event) {
+            if (!_mailbox.post(std::forward<Event>(event))) {
+                return false;
+            }
+            if (_pending.fetch_add(1) == 0) {
+                _executor.submit(*this);
+            }
+            return true;
+        }
+
+    private:
+        // Only events already counted in _pending are drained, so that it never drops below the number of events
+        // left in the mailbox and exactly one turn is scheduled while it is non-zero.
+        void run() override {
+            const auto limit = std::min(_budget, _pending.load());
+            const auto processed = _mailbox.drain(_fsm, limit);
+            if (_pending.fetch_sub(processed) != processed) {
+                _executor.submit(*this);
+            }
+        }
+
+        Executor & _executor;
+        FSM & _fsm;
+        TEventMailbox<Events...> _mailbox;
+        const std::size_t _budget;
+        std::atomic<std::size_t> _pending{0};
+    };
+} // namespace adc
@@ -1,14 +1,227 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
+namespace adc {
+    // A transition to State whose constructor arguments are carried by value. The engine destroys the current state
+    // and constructs State directly in its storage, so the target is built exactly once and never moved.
+    template <typename State, typename... Args>
+    struct TTransition {
+        using StateType = State;
+
+        explicit TTransition(std::tuple<Args...> arguments) : args(std::move(arguments)) {
+        }
+
+        template <typename... Others>
+        TTransition(TTransition<State, Others...> && other) // NOLINT(google-explicit-constructor)
+            : args(std::move(other.args)) {
+        }
+
+        std::tuple<Args...> args;
+    };
+
+    // Returned by catch-all handlers. (state, event) pairs resolving to it are known at compile time to be no-ops and
+    // are skipped by the dispatch table without calling the handler.
+    struct NoTransition {};
+
+    template <typename State, typename... Args>
+    auto transitionTo(Args &&... args) {
+        return TTransition<State, std::decay_t<Args>...>{std::make_tuple(std::forward<Args>(args)...)};
+    }
+
+    // The tracer policy of TFSMBase. Hooks receive state indices: onEvent before an event is dispatched, onExit and
+    // onEntry around a transition, onNoOp when the event caused none. The default does nothing and, being empty,
+    // takes no space in the machine.
+    struct NullTracer {
+        template <typename Event>
+        void onEvent(std::size_t state, const Event & event) {
+        }
+        void onExit(std::size_t state) {
+        }
+        void onEntry(std::size_t state) {
+        }
+        void onNoOp(std::size_t state) {
+        }
+    };
+
+    // a tracer policy forwarding every hook to each of Tracers in turn, e.g. to trace and collect metrics at once
+    template <typename... Tracers>
+    class TTracers {
+    public:
+        template <typename Event>
+        void onEvent(std::size_t state, const Event & event) {
+            std::apply(
+                [&](auto &... tracer) {
+                    (tracer.onEvent(state, event), ...);
+                },
+                _tracers);
+        }
+        void onExit(std::size_t state) {
+            std::apply(
+                [&](auto &... tracer) {
+                    (tracer.onExit(state), ...);
+                },
+                _tracers);
+        }
+        void onEntry(std::size_t state) {
+            std::apply(
+                [&](auto &... tracer) {
+                    (tracer.onEntry(state), ...);
+                },
+                _tracers);
+        }
+        void onNoOp(std::size_t state) {
+            std::apply(
+                [&](auto &... tracer) {
+                    (tracer.onNoOp(state), ...);
+                },
+                _tracers);
+        }
+
+        template <typename Tracer>
+        Tracer & get() {
+            return std::get<Tracer>(_tracers);
+        }
+
+    private:
+        std::tuple<Tracers...> _tracers;
+    };
+} // namespace adc
+
 namespace adc::details {
+    template <typename T>
+    struct is_transition : std::false_type {};
+    template <typename State, typename... Args>
+    struct is_transition<TTransition<State, Args...>> : std::true_type {};
+
+    template <typename T>
+    struct is_variant : std::false_type {};
+    template <typename... Ts>
+    struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+    template <typename T>
+    struct is_optional : std::false_type {};
+    template <typename T>
+    struct is_optional<std::optional<T>> : std::true_type {};
+
+    template <typename T, typename... Ts>
+    constexpr std::size_t indexOf() {
+        constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+        for (std::size_t i = 0; i < sizeof...(Ts); ++i) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Ts);
+    }
+
+    // true when Strategy resolves (State, Event) to a handler of State or of a class State derives from
+    template <typename Strategy, typename State, typename Event, typename = void>
+    struct has_handler : std::false_type {};
+    template <typename Strategy, typename State, typename Event>
+    struct has_handler<Strategy, State, Event,
+        std::void_t<decltype(std::declval<Strategy &>().execute(std::declval<State &>(), std::declval<Event>()))>>
+        : std::true_type {};
+
+    // true when Strategy resolves (State, Event) to a handler returning adc::NoTransition
+    template <typename Strategy, typename State, typename Event, bool = has_handler<Strategy, State, Event>::value>
+    struct is_no_op : std::false_type {};
+    template <typename Strategy, typename State, typename Event>
+    struct is_no_op<Strategy, State, Event, true>
+        : std::is_same<
+              std::decay_t<decltype(std::declval<Strategy &>().execute(std::declval<State &>(), std::declval<Event>()))>,
+              NoTransition> {};
+
+    // A state nests in a super-state by deriving from it and naming it as its Parent; super-states may nest in turn.
+    // An event a state has no handler for, or one returning adc::NoTransition, goes to its Parent; an empty
+    // std::optional handles it without a transition. Only the leaves are states of the machine: the hierarchy is
+    // resolved into its dispatch tables.
+    template <typename State, typename = void>
+    struct parent_of {
+        using type = void;
+    };
+    template <typename State>
+    struct parent_of<State, std::void_t<typename State::Parent>> {
+        using type = typename State::Parent;
+        static_assert(std::is_base_of_v<type, State> && !std::is_same_v<type, State>, "a state derives from its Parent");
+    };
+
+    // The innermost of State and the super-states it nests in with a handler for Event, or void when the event is
+    // ignored: a level returning adc::NoTransition, typically from a catch-all, lets it go to its Parent and, at the
+    // top, opts in to dropping it. An event no level has a handler for at all does not compile.
+    template <typename Strategy, typename State, typename Event, bool Ignored = false,
+        bool Handled = has_handler<Strategy, State, Event>::value && !is_no_op<Strategy, State, Event>::value>
+    struct handling_state {
+        using type = State;
+    };
+    template <typename Strategy, typename State, typename Event, bool Ignored>
+    struct handling_state<Strategy, State, Event, Ignored, false>
+        : handling_state<Strategy, typename parent_of<State>::type, Event,
+              Ignored || is_no_op<Strategy, State, Event>::value> {
+        static_assert(Ignored || is_no_op<Strategy, State, Event>::value ||
+                          !std::is_void_v<typename parent_of<State>::type>,
+            "no state handles this event; return adc::NoTransition from a catch-all handler to ignore it");
+    };
+    template <typename Strategy, typename Event, bool Ignored>
+    struct handling_state<Strategy, void, Event, Ignored, false> {
+        using type = void;
+    };
+
+    // true when State is SuperState or nests in it
+    template <typename State, typename SuperState>
+    struct nests_in : nests_in<typename parent_of<State>::type, SuperState> {};
+    template <typename State>
+    struct nests_in<State, State> : std::true_type {};
+    template <typename SuperState>
+    struct nests_in<void, SuperState> : std::false_type {};
+
+    template <typename State, typename Writer, typename = void>
+    struct has_save : std::false_type {};
+    template <typename State, typename Writer>
+    struct has_save<State, Writer, std::void_t<decltype(std::declval<const State &>().save(std::declval<Writer &>()))>>
+        : std::true_type {};
+
+    // true when State reads its payload back through a static State::Saved::load(Reader &), which decodes and
+    // validates it without side effects and returns an std::optional<State::Saved> to construct the state from
+    template <typename State, typename Reader, typename = void>
+    struct has_saved : std::false_type {};
+    template <typename State, typename Reader>
+    struct has_saved<State, Reader, std::void_t<decltype(State::Saved::load(std::declval<Reader &>()))>>
+        : std::true_type {};
+
+    // converts any handler result into the std::optional<std::variant<States...>> understood by the adc::old engines
+    template <typename Variant, typename Result>
+    std::optional<Variant> toOptVariant(Result && result) {
+        using R = std::decay_t<Result>;
+        if constexpr (std::is_same_v<R, NoTransition>) {
+            return std::optional<Variant>{};
+        } else if constexpr (is_transition<R>::value) {
+            return std::apply(
+                [](auto &&... args) {
+                    return std::optional<Variant>{
+                        std::in_place, std::in_place_type<typename R::StateType>, std::move(args)...};
+                },
+                std::move(result.args));
+        } else if constexpr (is_optional<R>::value && is_transition<typename R::value_type>::value) {
+            return result ? toOptVariant<Variant>(std::move(*result)) : std::optional<Variant>{};
+        } else {
+            return std::optional<Variant>{std::forward<Result>(result)};
+        }
+    }
+
     template <typename Transitions>
     struct TExternalTransitions {
         explicit TExternalTransitions(Transitions transitions) : _transitions(std::move(transitions)) {
         }
         template <typename State, typename Event>
-        auto execute(State & state, Event && event) {
+        auto execute(State & state, Event && event)
+            -> decltype(std::declval<Transitions &>()(state, std::forward<Event>(event))) {
             return _transitions.operator()(state, std::forward<Event>(event));
         }
 
@@ -17,29 +230,93 @@ namespace adc::details {
     };
     struct StatesHandlingTransitions {
         template <typename State, typename Event>
-        auto execute(State & state, Event && event) {
+        auto execute(State & state, Event && event) -> decltype(state.process(std::forward<Event>(event))) {
             return state.process(std::forward<Event>(event));
         }
     };
 
-    template <typename Strategy, typename... States>
-    class TFSMBase {
+    // Holds a T, as a base when T is empty so that it takes no space in the class deriving from it (the empty base
+    // optimisation); Tag tells apart several of them in one class.
+    template <typename Tag, typename T, bool = std::is_empty_v<T> && !std::is_final_v<T>>
+    class TCompressed {
+    public:
+        TCompressed() = default;
+        explicit TCompressed(T value) : _value(std::move(value)) {
+        }
+
+        T & get() {
+            return _value;
+        }
+
+        const T & get() const {
+            return _value;
+        }
+
+    private:
+        T _value;
+    };
+    template <typename Tag, typename T>
+    class TCompressed<Tag, T, true> : private T {
+    public:
+        TCompressed() = default;
+        explicit TCompressed(T value) : T(std::move(value)) {
+        }
+
+        T & get() {
+            return *this;
+        }
+
+        const T & get() const {
+            return *this;
+        }
+    };
+
+    struct StrategyTag;
+    struct TracerTag;
+
+    // The strategy and the tracer are empty for most machines, e.g. StatesHandlingTransitions and NullTracer, so they
+    // are held as compressed bases and such a machine is no larger than its std::variant of states.
+    template <typename Strategy, typename Tracer, typename... States>
+    class TFSMBase : private TCompressed<StrategyTag, Strategy>, private TCompressed<TracerTag, Tracer> {
+        using StrategyBase = TCompressed<StrategyTag, Strategy>;
+        using TracerBase = TCompressed<TracerTag, Tracer>;
+
     public:
         template <typename InitialState>
         explicit TFSMBase(Strategy strategy, InitialState && state)
-            : _strategy{std::move(strategy)}, _state{std::forward<InitialState>(state)} {
+            : StrategyBase{std::move(strategy)}, TracerBase{}, _state{std::forward<InitialState>(state)} {
+        }
+
+        template <typename InitialState, typename... Args>
+        explicit TFSMBase(Strategy strategy, std::in_place_type_t<InitialState> type, Args &&... args)
+            : StrategyBase{std::move(strategy)}, TracerBase{}, _state{type, std::forward<Args>(args)...} {
         }
 
+        // An rvalue event is handled where it is, rather than moved into a parameter first; an lvalue is only copied
+        // when a handler takes it.
         template <typename Event>
-        void process(Event event) {
-            auto optResult = std::visit(
-                [&](auto & state) {
-                    return _strategy.execute(state, std::move(event));
-                },
-                _state);
-            if (optResult) {
-                _state = std::move(optResult.value());
+        void process(Event && event) {
+            if constexpr (std::is_lvalue_reference_v<Event>) {
+                handle(_state.index() + 1, std::as_const(event));
+            } else {
+                handle(_state.index() + 1, event);
+            }
+        }
+
+        // Processes a contiguous range of events, either of one type or std::variants of several, in order and returns
+        // the number of transitions that fired. Events of a mutable range are moved into the handlers. The current state
+        // slot is only re-read after a transition.
+        template <typename Events>
+        std::size_t processBatch(Events && events) {
+            std::size_t transitions = 0;
+            auto slot = _state.index() + 1;
+            for (auto & event : events) {
+                if (handle(slot, event)) {
+                    ++transitions;
+                    slot = _state.index() + 1;
+                }
             }
+            return transitions;
         }
 
         auto getState() const {
@@ -50,36 +327,275 @@ namespace adc::details {
                 _state);
         }
 
+        // true when the current state is SuperState or one of the states nested in it
+        template <typename SuperState>
+        bool isIn() const {
+            static constexpr std::array<bool, sizeof...(States) + 1> NESTED{
+                false, nests_in<States, SuperState>::value...};
+            return NESTED[_state.index() + 1];
+        }
+
+        Tracer & tracer() {
+            return TracerBase::get();
+        }
+
+        // Writes the index of the current state, then whatever its save(out) member writes, if it has one.
+        template <typename Writer>
+        void save(Writer & out) const {
+            out.write(static_cast<std::uint8_t>(_state.index()));
+            std::visit(
+                [&](const auto & state) {
+                    if constexpr (has_save<std::decay_t<decltype(state)>, Writer>::value) {
+                        state.save(out);
+                    }
+                },
+                _state);
+        }
+
+        // Replaces the current state with the one saved, without running a transition. A state with a payload is
+        // constructed from (saved, args...) once State::Saved::load has decoded and validated it, any other state from
+        // (args...). When the record is rejected the machine is left untouched.
+        template <typename Reader, typename... Args>
+        bool restore(Reader & in, Args &&... args) {
+            const auto index = in.template read<std::uint8_t>();
+            if (!in.ok() || index >= sizeof...(States)) {
+                return false;
+            }
+            return RESTORERS<Reader, Args...>[index](*this, in, args...);
+        }
+
+        // Reads a record written by save() as restore() would, without touching any machine, so that a whole snapshot
+        // can be validated before anything is restored from it.
+        template <typename Reader>
+        static bool check(Reader & in) {
+            const auto index = in.template read<std::uint8_t>();
+            if (!in.ok() || index >= sizeof...(States)) {
+                return false;
+            }
+            return CHECKERS<Reader>[index](in);
+        }
+
     protected:
-        Strategy _strategy;
+        // Handlers may return a TTransition, an std::optional of one, or an std::optional<std::variant<States...>>.
+        // A TTransition is applied by emplace: the current state is destroyed before the target is constructed.
+        template <typename Result>
+        bool applyTransition(Result && result) {
+            using R = std::decay_t<Result>;
+            if constexpr (is_transition<R>::value) {
+                tracer().onExit(_state.index());
+                std::apply(
+                    [&](auto &&... args) {
+                        _state.template emplace<typename R::StateType>(std::move(args)...);
+                    },
+                    std::move(result.args));
+                tracer().onEntry(_state.index());
+                return true;
+            } else if constexpr (is_optional<R>::value) {
+                return result && applyTransition(std::move(*result));
+            } else if constexpr (std::is_same_v<R, NoTransition>) {
+                return false;
+            } else {
+                tracer().onExit(_state.index());
+                _state = std::forward<Result>(result);
+                tracer().onEntry(_state.index());
+                return true;
+            }
+        }
+
+        Strategy & strategy() {
+            return StrategyBase::get();
+        }
+
         std::variant<States...> _state;
+
+    private:
+        template <typename Event>
+        using THandler = bool (*)(TFSMBase &, Event &);
+
+        // Slot is the state index shifted by one; a valueless variant reports variant_npos, which wraps around to 0. A
+        // const event is copied for its handler, so not at all when it is a no-op.
+        template <typename Event>
+        bool handle(std::size_t slot, Event & event) {
+            tracer().onEvent(slot - 1, std::as_const(event));
+            if (const auto handler = lookup(slot, event)) {
+                if constexpr (std::is_const_v<Event>) {
+                    auto copy = event;
+                    if (handler(*this, copy)) {
+                        return true;
+                    }
+                } else if (handler(*this, event)) {
+                    return true;
+                }
+            }
+            tracer().onNoOp(slot - 1);
+            return false;
+        }
+
+        template <typename Event>
+        static THandler<Event> lookup(std::size_t slot, const Event & event) {
+            if constexpr (is_variant<Event>::value) {
+                return MATRIX<Event>[slot][event.index() + 1];
+            } else {
+                return HANDLERS<Event>[slot];
+            }
+        }
+
+        // the state at Index, or the super-state handling Event for it
+        template <std::size_t Index, typename Event>
+        using THandlingState =
+            typename handling_state<Strategy, std::variant_alternative_t<Index, std::variant<States...>>, Event>::type;
+
+        template <std::size_t Index, typename Event>
+        static bool dispatch(TFSMBase & fsm, Event & event) {
+            THandlingState<Index, Event> & state = *std::get_if<Index>(&fsm._state);
+            return fsm.applyTransition(fsm.strategy().execute(state, std::move(event)));
+        }
+
+        template <std::size_t Index, std::size_t EventIndex, typename Events>
+        static bool dispatchAlternative(TFSMBase & fsm, Events & events) {
+            return dispatch<Index>(fsm, *std::get_if<EventIndex>(&events));
+        }
+
+        template <std::size_t Index, typename Event>
+        static constexpr bool isNoOp() {
+            return std::is_void_v<THandlingState<Index, Event>>;
+        }
+
+        template <std::size_t Index, typename Event>
+        static constexpr THandler<Event> handlerFor() {
+            if constexpr (isNoOp<Index, Event>()) {
+                return nullptr;
+            } else {
+                return &dispatch<Index, Event>;
+            }
+        }
+
+        template <std::size_t Index, std::size_t EventIndex, typename Events>
+        static constexpr THandler<Events> alternativeHandlerFor() {
+            if constexpr (isNoOp<Index, std::variant_alternative_t<EventIndex, Events>>()) {
+                return nullptr;
+            } else {
+                return &dispatchAlternative<Index, EventIndex, Events>;
+            }
+        }
+
+        template <typename Event, std::size_t... Index>
+        static constexpr auto makeHandlers(std::index_sequence<Index...>) {
+            return std::array<THandler<Event>, sizeof...(States) + 1>{nullptr, handlerFor<Index, Event>()...};
+        }
+
+        template <typename Events, std::size_t Index, std::size_t... EventIndex>
+        static constexpr auto makeRow(std::index_sequence<EventIndex...>) {
+            return std::array<THandler<Events>, sizeof...(EventIndex) + 1>{
+                nullptr, alternativeHandlerFor<Index, EventIndex, Events>()...};
+        }
+
+        template <typename Events, std::size_t... Index>
+        static constexpr auto makeMatrix(std::index_sequence<Index...>) {
+            using EventIndices = std::make_index_sequence<std::variant_size_v<Events>>;
+            using Row = decltype(makeRow<Events, 0>(EventIndices{}));
+            return std::array<Row, sizeof...(States) + 1>{Row{}, makeRow<Events, Index>(EventIndices{})...};
+        }
+
+        template <typename Reader, typename... Args>
+        using TRestorer = bool (*)(TFSMBase &, Reader &, Args &...);
+
+        template <std::size_t Index, typename Reader, typename... Args>
+        static bool restoreAs(TFSMBase & fsm, Reader & in, Args &... args) {
+            using State = std::variant_alternative_t<Index, std::variant<States...>>;
+            if constexpr (has_saved<State, Reader>::value) {
+                auto saved = State::Saved::load(in);
+                if (!saved || !in.ok()) {
+                    return false;
+                }
+                fsm._state.template emplace<Index>(std::move(*saved), args...);
+                return true;
+            } else if constexpr (std::is_constructible_v<State, Args &...>) {
+                fsm._state.template emplace<Index>(args...);
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        template <std::size_t Index, typename Reader>
+        static bool checkAs(Reader & in) {
+            using State = std::variant_alternative_t<Index, std::variant<States...>>;
+            if constexpr (has_saved<State, Reader>::value) {
+                return State::Saved::load(in).has_value() && in.ok();
+            } else {
+                return true;
+            }
+        }
+
+        template <typename Reader, typename... Args, std::size_t... Index>
+        static constexpr auto makeRestorers(std::index_sequence<Index...>) {
+            return std::array<TRestorer<Reader, Args...>, sizeof...(States)>{&restoreAs<Index, Reader, Args...>...};
+        }
+
+        template <typename Reader, std::size_t... Index>
+        static constexpr auto makeCheckers(std::index_sequence<Index...>) {
+            return std::array<bool (*)(Reader &), sizeof...(States)>{&checkAs<Index, Reader>...};
+        }
+
+        template <typename Reader, typename... Args>
+        static constexpr auto RESTORERS = makeRestorers<Reader, Args...>(std::index_sequence_for<States...>{});
+
+        template <typename Reader>
+        static constexpr auto CHECKERS = makeCheckers<Reader>(std::index_sequence_for<States...>{});
+
+        // one column of the [state][event] dispatch matrix, shifted by one so that slot 0 is the valueless state
+        template <typename Event>
+        static constexpr auto HANDLERS = makeHandlers<Event>(std::index_sequence_for<States...>{});
+
+        // the full [state][event] matrix for an std::variant of events, shifted by one in both dimensions
+        template <typename Events>
+        static constexpr auto MATRIX = makeMatrix<Events>(std::index_sequence_for<States...>{});
     };
 } // namespace adc::details
 
 namespace adc {
-    template <typename... States>
-    class TFSMStateTransitions : public details::TFSMBase<details::StatesHandlingTransitions, States...> {
-        using BaseType = details::TFSMBase<details::StatesHandlingTransitions, States...>;
+    template <typename Tracer, typename... States>
+    class TTracedFSMStateTransitions : public details::TFSMBase<details::StatesHandlingTransitions, Tracer, States...> {
+        using BaseType = details::TFSMBase<details::StatesHandlingTransitions, Tracer, States...>;
         using StrategyType = details::StatesHandlingTransitions;
 
     public:
         template <typename InitialState>
-        explicit TFSMStateTransitions(InitialState && state) // NOLINT(bugprone-forwarding-reference-overload)
+        explicit TTracedFSMStateTransitions(InitialState && state) // NOLINT(bugprone-forwarding-reference-overload)
             : BaseType{StrategyType{}, std::forward<InitialState>(state)} {
         }
+
+        template <typename InitialState, typename... Args>
+        explicit TTracedFSMStateTransitions(std::in_place_type_t<InitialState> type, Args &&... args)
+            : BaseType{StrategyType{}, type, std::forward<Args>(args)...} {
+        }
     };
 
-    template <typename Transitions, typename... States>
-    class TFSMExternalTransitions : public details::TFSMBase<details::TExternalTransitions<Transitions>, States...> {
-        using BaseType = details::TFSMBase<details::TExternalTransitions<Transitions>, States...>;
+    template <typename Tracer, typename Transitions, typename... States>
+    class TTracedFSMExternalTransitions
+        : public details::TFSMBase<details::TExternalTransitions<Transitions>, Tracer, States...> {
+        using BaseType = details::TFSMBase<details::TExternalTransitions<Transitions>, Tracer, States...>;
         using StrategyType = details::TExternalTransitions<Transitions>;
 
     public:
         template <typename InitialState>
-        explicit TFSMExternalTransitions(Transitions transitions, InitialState && state)
+        explicit TTracedFSMExternalTransitions(Transitions transitions, InitialState && state)
             : BaseType{StrategyType{std::move(transitions)}, std::forward<InitialState>(state)} {
         }
+
+        template <typename InitialState, typename... Args>
+        explicit TTracedFSMExternalTransitions(
+            Transitions transitions, std::in_place_type_t<InitialState> type, Args &&... args)
+            : BaseType{StrategyType{std::move(transitions)}, type, std::forward<Args>(args)...} {
+        }
     };
+
+    template <typename... States>
+    using TFSMStateTransitions = TTracedFSMStateTransitions<NullTracer, States...>;
+
+    template <typename Transitions, typename... States>
+    using TFSMExternalTransitions = TTracedFSMExternalTransitions<NullTracer, Transitions, States...>;
 } // namespace adc
 
 namespace adc::old {
@@ -94,7 +610,7 @@ namespace adc::old {
         void process(Event event) {
             auto optResult = std::visit(
                 [&](auto & state) {
-                    return state.process(std::move(event));
+                    return details::toOptVariant<std::variant<States...>>(state.process(std::move(event)));
                 },
                 _state);
             if (optResult) {
@@ -126,7 +642,8 @@ namespace adc::old {
         void process(Event event) {
             auto optResult = std::visit(
                 [&](auto & state) {
-                    return _transitions.operator()(state, std::move(event));
+                    return details::toOptVariant<std::variant<States...>>(
+                        _transitions.operator()(state, std::move(event)));
                 },
                 _state);
             if (optResult) {
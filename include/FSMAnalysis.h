@@ -0,0 +1,198 @@
+#pragma once
+
+#include "FSM.h"
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace adc::details {
+    template <typename Events>
+    struct event_list;
+    template <typename... Events>
+    struct event_list<std::tuple<Events...>> {
+        using type = std::tuple<Events...>;
+    };
+    template <typename... Events>
+    struct event_list<std::variant<Events...>> {
+        using type = std::tuple<Events...>;
+    };
+
+    template <typename State, typename... States>
+    constexpr std::uint64_t stateBit() {
+        constexpr auto index = indexOf<State, States...>();
+        static_assert(index < sizeof...(States), "transition to a state which is not listed");
+        return std::uint64_t{1} << index;
+    }
+
+    template <typename Variant, typename... States>
+    struct alternatives_of;
+    template <typename... Alternatives, typename... States>
+    struct alternatives_of<std::variant<Alternatives...>, States...> {
+        static constexpr std::uint64_t value = (std::uint64_t{0} | ... | stateBit<Alternatives, States...>());
+    };
+
+    // the states a handler returning Result may transition to, as a mask indexed like States
+    template <typename Result, typename... States>
+    constexpr std::uint64_t targetsOf() {
+        using R = std::decay_t<Result>;
+        if constexpr (std::is_same_v<R, NoTransition>) {
+            return 0;
+        } else if constexpr (is_transition<R>::value) {
+            return stateBit<typename R::StateType, States...>();
+        } else if constexpr (is_optional<R>::value) {
+            return targetsOf<typename R::value_type, States...>();
+        } else {
+            return alternatives_of<R, States...>::value;
+        }
+    }
+
+    // one cell of the analysis: whether State, or a super-state of it, handles Event and where that may lead
+    struct TEdge {
+        bool handled;
+        std::uint64_t targets;
+    };
+
+    template <typename Strategy, typename State, typename Event, typename... States>
+    constexpr TEdge edgeOf() {
+        using Level = typename handling_state<Strategy, State, Event>::type;
+        if constexpr (std::is_void_v<Level>) {
+            return TEdge{false, 0};
+        } else {
+            using Result = decltype(std::declval<Strategy &>().execute(std::declval<Level &>(), std::declval<Event>()));
+            return TEdge{true, targetsOf<Result, States...>()};
+        }
+    }
+
+    template <typename Strategy, typename State, typename EventTuple, typename... States, std::size_t... E>
+    constexpr auto rowOf(std::index_sequence<E...> /*unused*/) {
+        return std::array<TEdge, sizeof...(E)>{
+            edgeOf<Strategy, State, std::tuple_element_t<E, EventTuple>, States...>()...};
+    }
+
+    template <std::size_t StateCount, std::size_t EventCount>
+    using TEdges = std::array<std::array<TEdge, EventCount>, StateCount>;
+
+    template <typename Strategy, typename EventTuple, typename... States>
+    constexpr auto edgesOf() {
+        using Indices = std::make_index_sequence<std::tuple_size_v<EventTuple>>;
+        return TEdges<sizeof...(States), std::tuple_size_v<EventTuple>>{
+            rowOf<Strategy, States, EventTuple, States...>(Indices{})...};
+    }
+
+    // every state the initial one leads to, closing over the edges until nothing is added
+    template <std::size_t StateCount, std::size_t EventCount>
+    constexpr std::uint64_t reachableFrom(std::size_t initial, const TEdges<StateCount, EventCount> & edges) {
+        std::uint64_t reached = std::uint64_t{1} << initial;
+        for (std::uint64_t previous = 0; previous != reached;) {
+            previous = reached;
+            for (std::size_t state = 0; state < StateCount; ++state) {
+                if ((reached >> state) & 1U) {
+                    for (const auto & edge : edges[state]) {
+                        reached |= edge.targets;
+                    }
+                }
+            }
+        }
+        return reached;
+    }
+
+    constexpr std::size_t bitCount(std::uint64_t mask) {
+        std::size_t count = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            ++count;
+        }
+        return count;
+    }
+
+    // counts handlers, or transitions when counting targets, of the states in mask
+    template <std::size_t StateCount, std::size_t EventCount>
+    constexpr std::size_t countEdges(const TEdges<StateCount, EventCount> & edges, std::uint64_t mask, bool targets) {
+        std::size_t count = 0;
+        for (std::size_t state = 0; state < StateCount; ++state) {
+            if ((mask >> state) & 1U) {
+                for (const auto & edge : edges[state]) {
+                    count += targets ? bitCount(edge.targets) : static_cast<std::size_t>(edge.handled);
+                }
+            }
+        }
+        return count;
+    }
+
+    template <std::uint64_t Mask, typename Indices, typename... States>
+    struct select_states;
+    template <std::uint64_t Mask, std::size_t... Index, typename... States>
+    struct select_states<Mask, std::index_sequence<Index...>, States...> {
+        using type = decltype(std::tuple_cat(
+            std::declval<std::conditional_t<((Mask >> Index) & 1U) != 0, std::tuple<States>, std::tuple<>>>()...));
+    };
+
+    template <template <typename...> class Machine, typename Leading, typename States>
+    struct rebind_states;
+    template <template <typename...> class Machine, typename... Leading, typename... States>
+    struct rebind_states<Machine, std::tuple<Leading...>, std::tuple<States...>> {
+        using type = Machine<Leading..., States...>;
+    };
+} // namespace adc::details
+
+namespace adc {
+    // Works out at compile time which of States a machine starting in InitialState can ever reach through Events, a
+    // std::tuple or std::variant of the event types it processes, and which handlers can ever run. Strategy is
+    // details::StatesHandlingTransitions for states with process members, or details::TExternalTransitions of the
+    // transition table. A handler returning an std::optional<std::variant<...>> may lead to any of its alternatives.
+    template <typename Strategy, typename InitialState, typename Events, typename... States>
+    class TFSMAnalysis {
+        static_assert(sizeof...(States) <= 64, "the analysis keeps states in a 64-bit mask");
+        static_assert(details::indexOf<InitialState, States...>() < sizeof...(States), "not a state of this machine");
+        using EventTuple = typename details::event_list<Events>::type;
+
+    public:
+        static constexpr std::size_t STATES = sizeof...(States);
+        static constexpr std::size_t EVENTS = std::tuple_size_v<EventTuple>;
+
+        // [state][event]: whether the pair has a handler, and the states it may transition to
+        static constexpr auto EDGES = details::edgesOf<Strategy, EventTuple, States...>();
+
+        static constexpr std::uint64_t REACHABLE =
+            details::reachableFrom(details::indexOf<InitialState, States...>(), EDGES);
+        static constexpr std::size_t REACHABLE_STATES = details::bitCount(REACHABLE);
+
+        // (state, event) pairs with a handler: all of them, and those of reachable states
+        static constexpr std::size_t HANDLERS = details::countEdges(EDGES, ~std::uint64_t{0}, false);
+        static constexpr std::size_t LIVE_HANDLERS = details::countEdges(EDGES, REACHABLE, false);
+        // (state, event, target) edges out of reachable states
+        static constexpr std::size_t TRANSITIONS = details::countEdges(EDGES, REACHABLE, true);
+
+        // the states which can be reached, in the order they were listed
+        using ReachableStates =
+            typename details::select_states<REACHABLE, std::index_sequence_for<States...>, States...>::type;
+
+        // the machine over the reachable states only, e.g. TPruned<TFSMExternalTransitions, TransitionTable>
+        template <template <typename...> class Machine, typename... Leading>
+        using TPruned = typename details::rebind_states<Machine, std::tuple<Leading...>, ReachableStates>::type;
+
+        // the footprint of the state storage and of the dispatch tables for Events, before and after pruning
+        static constexpr std::size_t STATE_BYTES = sizeof(std::variant<States...>);
+        static constexpr std::size_t PRUNED_STATE_BYTES = sizeof(TPruned<std::variant>);
+        static constexpr std::size_t TABLE_BYTES = (STATES + 1) * EVENTS * sizeof(void (*)());
+        static constexpr std::size_t PRUNED_TABLE_BYTES = (REACHABLE_STATES + 1) * EVENTS * sizeof(void (*)());
+
+        template <typename State>
+        static constexpr bool isReachable() {
+            constexpr auto index = details::indexOf<State, States...>();
+            static_assert(index < STATES, "not a state of this machine");
+            return ((REACHABLE >> index) & 1U) != 0;
+        }
+    };
+
+    template <typename InitialState, typename Events, typename... States>
+    using TStateTransitionsAnalysis =
+        TFSMAnalysis<details::StatesHandlingTransitions, InitialState, Events, States...>;
+
+    template <typename Transitions, typename InitialState, typename Events, typename... States>
+    using TExternalTransitionsAnalysis =
+        TFSMAnalysis<details::TExternalTransitions<Transitions>, InitialState, Events, States...>;
+} // namespace adc
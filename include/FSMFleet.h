@@ -0,0 +1,258 @@
+#pragma once
+
+#include "FSM.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <variant>
+#include <vector>
+
+namespace adc::details {
+    // Storage for the payloads of all machines that are currently in one state. The capacity is reserved up front
+    // (pages are only touched once used) so payloads never relocate, and freed slots are reused LIFO to keep the live
+    // payloads packed.
+    template <typename State>
+    class TSlab {
+    public:
+        explicit TSlab(std::size_t capacity) : _storage(new Storage[capacity]) {
+            _free.reserve(capacity);
+        }
+
+        template <typename... Args>
+        std::uint32_t emplace(Args &&... args) {
+            const auto slot = acquire();
+            try {
+                new (&_storage[slot]) State(std::forward<Args>(args)...);
+            } catch (...) {
+                _free.push_back(slot);
+                throw;
+            }
+            return slot;
+        }
+
+        void erase(std::uint32_t slot) {
+            (*this)[slot].~State();
+            _free.push_back(slot);
+        }
+
+        State & operator[](std::uint32_t slot) {
+            return *std::launder(reinterpret_cast<State *>(&_storage[slot]));
+        }
+
+        const State & operator[](std::uint32_t slot) const {
+            return *std::launder(reinterpret_cast<const State *>(&_storage[slot]));
+        }
+
+    private:
+        std::uint32_t acquire() {
+            if (_free.empty()) {
+                return _end++;
+            }
+            const auto slot = _free.back();
+            _free.pop_back();
+            return slot;
+        }
+
+        struct Storage {
+            alignas(State) unsigned char bytes[sizeof(State)];
+        };
+
+        std::unique_ptr<Storage[]> _storage;
+        std::vector<std::uint32_t> _free;
+        std::uint32_t _end{0};
+    };
+} // namespace adc::details
+
+namespace adc {
+    // N machines sharing one transition table, stored as a struct of arrays: one byte of state index per machine and
+    // the payload of each state in a per-type slab. Handlers are the same as for TFSMExternalTransitions.
+    template <typename Transitions, typename... States>
+    class TFSMFleet {
+        static_assert(sizeof...(States) < std::numeric_limits<std::uint8_t>::max(), "state index must fit in a byte");
+        using StrategyType = details::TExternalTransitions<Transitions>;
+
+    public:
+        // init(id) returns the adc::transitionTo<InitialState>(...) of each machine
+        template <typename Init>
+        TFSMFleet(Transitions transitions, std::size_t size, Init init)
+            : _strategy{std::move(transitions)}, _indices(size), _slots(size), _slabs{details::TSlab<States>(size)...} {
+            for (std::size_t id = 0; id < size; ++id) {
+                applyTransition(id, init(id));
+            }
+        }
+
+        TFSMFleet(const TFSMFleet & other) = delete;
+        TFSMFleet(TFSMFleet && other) noexcept = delete;
+        TFSMFleet & operator=(const TFSMFleet & other) = delete;
+        TFSMFleet & operator=(TFSMFleet && other) noexcept = delete;
+
+        ~TFSMFleet() {
+            for (std::size_t id = 0; id < size(); ++id) {
+                destroy(id);
+            }
+        }
+
+        template <typename Event>
+        void process(std::size_t id, Event event) {
+            if constexpr (details::is_variant<Event>::value) {
+                std::visit(
+                    [&](auto & alternative) {
+                        handle(id, alternative);
+                    },
+                    event);
+            } else {
+                handle(id, event);
+            }
+        }
+
+        // delivers a copy of event to every machine; machines for which it is a no-op only cost a byte compare
+        template <typename Event>
+        std::size_t processAll(const Event & event) {
+            std::size_t transitions = 0;
+            for (std::size_t id = 0; id < size(); ++id) {
+                if (const auto handler = HANDLERS<Event>[_indices[id]]) {
+                    auto copy = event;
+                    transitions += handler(*this, id, copy);
+                }
+            }
+            return transitions;
+        }
+
+        auto getState(std::size_t id) const {
+            static constexpr auto GETTERS = makeGetters(std::index_sequence_for<States...>{});
+            return GETTERS[_indices[id]](*this, id);
+        }
+
+        // true when the machine is in SuperState or one of the states nested in it
+        template <typename SuperState>
+        bool isIn(std::size_t id) const {
+            static constexpr std::array<bool, sizeof...(States) + 1> NESTED{
+                false, details::nests_in<States, SuperState>::value...};
+            return NESTED[_indices[id]];
+        }
+
+        std::size_t size() const {
+            return _indices.size();
+        }
+
+    private:
+        template <std::size_t Index>
+        auto & payload(std::size_t id) {
+            return std::get<Index>(_slabs)[_slots[id]];
+        }
+
+        template <std::size_t Index>
+        const auto & payload(std::size_t id) const {
+            return std::get<Index>(_slabs)[_slots[id]];
+        }
+
+        template <typename State, typename... Args>
+        void emplace(std::size_t id, Args &&... args) {
+            constexpr auto index = details::indexOf<State, States...>();
+            static_assert(index < sizeof...(States), "not a state of this fleet");
+            destroy(id);
+            _slots[id] = std::get<index>(_slabs).emplace(std::forward<Args>(args)...);
+            _indices[id] = static_cast<std::uint8_t>(index + 1);
+        }
+
+        template <typename Result>
+        bool applyTransition(std::size_t id, Result && result) {
+            using R = std::decay_t<Result>;
+            if constexpr (details::is_transition<R>::value) {
+                std::apply(
+                    [&](auto &&... args) {
+                        emplace<typename R::StateType>(id, std::move(args)...);
+                    },
+                    std::move(result.args));
+                return true;
+            } else if constexpr (details::is_optional<R>::value) {
+                return result && applyTransition(id, std::move(*result));
+            } else if constexpr (std::is_same_v<R, NoTransition>) {
+                return false;
+            } else {
+                std::visit(
+                    [&](auto & state) {
+                        emplace<std::decay_t<decltype(state)>>(id, std::move(state));
+                    },
+                    result);
+                return true;
+            }
+        }
+
+        void destroy(std::size_t id) {
+            static constexpr auto DESTRUCTORS = makeDestructors(std::index_sequence_for<States...>{});
+            if (const auto destructor = DESTRUCTORS[_indices[id]]) {
+                _indices[id] = 0;
+                destructor(*this, _slots[id]);
+            }
+        }
+
+        template <typename Event>
+        bool handle(std::size_t id, Event & event) {
+            const auto handler = HANDLERS<Event>[_indices[id]];
+            return handler && handler(*this, id, event);
+        }
+
+        template <typename Event>
+        using THandler = bool (*)(TFSMFleet &, std::size_t, Event &);
+        using TDestructor = void (*)(TFSMFleet &, std::uint32_t);
+        using TStateId = decltype(std::declval<const std::tuple_element_t<0, std::tuple<States...>> &>().getState());
+        using TGetter = TStateId (*)(const TFSMFleet &, std::size_t);
+
+        // the state at Index, or the super-state handling Event for it
+        template <std::size_t Index, typename Event>
+        using THandlingState = typename details::handling_state<StrategyType,
+            std::tuple_element_t<Index, std::tuple<States...>>, Event>::type;
+
+        template <std::size_t Index, typename Event>
+        static bool dispatch(TFSMFleet & fleet, std::size_t id, Event & event) {
+            THandlingState<Index, Event> & state = fleet.payload<Index>(id);
+            return fleet.applyTransition(id, fleet._strategy.execute(state, std::move(event)));
+        }
+
+        template <std::size_t Index, typename Event>
+        static constexpr THandler<Event> handlerFor() {
+            if constexpr (std::is_void_v<THandlingState<Index, Event>>) {
+                return nullptr;
+            } else {
+                return &dispatch<Index, Event>;
+            }
+        }
+
+        template <typename Event, std::size_t... Index>
+        static constexpr auto makeHandlers(std::index_sequence<Index...>) {
+            return std::array<THandler<Event>, sizeof...(States) + 1>{nullptr, handlerFor<Index, Event>()...};
+        }
+
+        template <std::size_t... Index>
+        static constexpr auto makeDestructors(std::index_sequence<Index...>) {
+            return std::array<TDestructor, sizeof...(States) + 1>{
+                nullptr, [](TFSMFleet & fleet, std::uint32_t slot) {
+                    std::get<Index>(fleet._slabs).erase(slot);
+                }...};
+        }
+
+        template <std::size_t... Index>
+        static constexpr auto makeGetters(std::index_sequence<Index...>) {
+            return std::array<TGetter, sizeof...(States) + 1>{
+                // a machine left without state by a throwing transition, reported like a valueless TFSMBase variant
+                [](const TFSMFleet &, std::size_t) -> TStateId {
+                    throw std::bad_variant_access{};
+                },
+                [](const TFSMFleet & fleet, std::size_t id) {
+                    return fleet.payload<Index>(id).getState();
+                }...};
+        }
+
+        // indexed by the stored state byte, which is the state index shifted by one; 0 marks a machine without state
+        template <typename Event>
+        static constexpr auto HANDLERS = makeHandlers<Event>(std::index_sequence_for<States...>{});
+
+        StrategyType _strategy;
+        std::vector<std::uint8_t> _indices;
+        std::vector<std::uint32_t> _slots;
+        std::tuple<details::TSlab<States>...> _slabs;
+    };
+} // namespace adc
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+namespace adc {
+    // One row of a TFSMTransitionTable: in state Source, Event leads to Target when Guard holds, running Action on the
+    // way. Source and Target are enumerators of the machine's state enum. Action and Guard are optional; either is a
+    // member function of the machine's context or a function taking the context first, with or without the event.
+    template <auto Source, typename Event, auto Target, auto Action = nullptr, auto Guard = nullptr>
+    struct TRow {
+        static_assert(std::is_same_v<decltype(Source), decltype(Target)>, "Source and Target are states of one enum");
+        using EventType = Event;
+        static constexpr auto SOURCE = Source;
+        static constexpr auto TARGET = Target;
+        static constexpr auto ACTION = Action;
+        static constexpr auto GUARD = Guard;
+    };
+} // namespace adc
+
+namespace adc::details {
+    // calls an action or guard of a row with the event when it takes one, and without otherwise
+    template <auto Callable, typename Context, typename Event>
+    decltype(auto) invokeRow(Context & context, Event & event) {
+        if constexpr (std::is_invocable_v<decltype(Callable), Context &, Event &>) {
+            return std::invoke(Callable, context, event);
+        } else {
+            static_assert(std::is_invocable_v<decltype(Callable), Context &>, "takes the context, then the event");
+            return std::invoke(Callable, context);
+        }
+    }
+} // namespace adc::details
+
+namespace adc {
+    // A machine written as a table of TRows, with its state kept as an enumerator rather than a variant. Everything
+    // but the state is resolved at compile time: an event folds into the comparisons of the rows it appears in, in
+    // table order, with their guards and actions inlined, which the optimizer turns into the switch one would write
+    // by hand. The first row of the current state whose guard holds is taken; an event without one is ignored.
+    // The table holds no context of its own, so that it can be a member of the context it drives.
+    template <typename Context, auto Initial, typename... Rows>
+    class TFSMTransitionTable {
+    public:
+        using StateType = decltype(Initial);
+        static_assert(std::is_enum_v<StateType>, "the states of a table are enumerators");
+        static_assert(
+            (std::is_same_v<std::decay_t<decltype(Rows::SOURCE)>, StateType> && ...), "rows of another machine");
+
+        StateType getState() const {
+            return _state;
+        }
+
+        // true when a row was taken
+        template <typename Event>
+        bool process(Context & context, Event && event) {
+            return (tryRow<Rows>(context, event) || ...);
+        }
+
+    private:
+        template <typename Row, typename Event>
+        bool tryRow(Context & context, Event & event) {
+            if constexpr (!std::is_same_v<typename Row::EventType, std::decay_t<Event>>) {
+                return false;
+            } else {
+                if (_state != Row::SOURCE) {
+                    return false;
+                }
+                if constexpr (!std::is_null_pointer_v<decltype(Row::GUARD)>) {
+                    if (!details::invokeRow<Row::GUARD>(context, event)) {
+                        return false;
+                    }
+                }
+                if constexpr (!std::is_null_pointer_v<decltype(Row::ACTION)>) {
+                    details::invokeRow<Row::ACTION>(context, event);
+                }
+                _state = Row::TARGET;
+                return true;
+            }
+        }
+
+        StateType _state{Initial};
+    };
+} // namespace adc
@@ -0,0 +1,376 @@
+#pragma once
+
+#include "FSM.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace adc {
+    // How an event is written to a journal. Plain values are copied as is, empty events take no bytes at all; events
+    // holding strings specialise it with encode(SnapshotWriter &, const Event &) and decode(SnapshotReader &).
+    template <typename Event>
+    struct TJournalCodec {
+        static_assert(std::is_trivially_copyable_v<Event>, "specialise adc::TJournalCodec for this event");
+
+        static void encode(SnapshotWriter & out, const Event & event) {
+            if constexpr (!std::is_empty_v<Event>) {
+                out.write(event);
+            }
+        }
+
+        static Event decode(SnapshotReader & in) {
+            if constexpr (std::is_empty_v<Event>) {
+                return Event{};
+            } else {
+                return in.read<Event>();
+            }
+        }
+    };
+
+    // Each event is a record: when it was sent and to which machine, the index of its type in the journal's event
+    // list and the size of the payload following the record. Native byte order.
+    struct JournalRecord {
+        std::uint64_t timestamp; // nanoseconds since the epoch of the system clock
+        std::uint32_t machine;
+        std::uint16_t size;
+        std::uint8_t type;
+        std::uint8_t reserved;
+    };
+    static_assert(sizeof(JournalRecord) == 16, "journal records are written to disk as is");
+
+    struct JournalSegmentHeader {
+        static constexpr char MAGIC[8] = {'A', 'D', 'C', 'J', 'R', 'N', '0', '1'};
+
+        char magic[8];
+        std::uint64_t index;
+    };
+    static_assert(sizeof(JournalSegmentHeader) == 16, "journal headers are written to disk as is");
+
+    struct JournalOptions {
+        // a segment is closed once it has grown past this size, and the next commit starts a new one
+        std::size_t segmentBytes{64u << 20u};
+        // how long an appended event waits for its commit at most
+        std::chrono::milliseconds commitPeriod{5};
+        // a batch this large is committed without waiting for the period
+        std::size_t batchBytes{1u << 20u};
+        // fsync every commit rather than leaving the data to the OS
+        bool durable{false};
+    };
+
+    namespace details {
+        inline std::filesystem::path journalSegment(
+            const std::filesystem::path & directory, const std::string & name, std::uint64_t index) {
+            char number[24];
+            std::snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(index));
+            return directory / (name + '-' + number + ".journal");
+        }
+
+        // the segments of the journal called name, <directory>/<name>-<index>.journal, by index
+        inline std::vector<std::pair<std::uint64_t, std::filesystem::path>> journalSegments(
+            const std::filesystem::path & directory, const std::string & name) {
+            std::vector<std::pair<std::uint64_t, std::filesystem::path>> segments;
+            std::error_code error;
+            for (const auto & entry : std::filesystem::directory_iterator{directory, error}) {
+                if (entry.path().extension() != ".journal") {
+                    continue;
+                }
+                const auto stem = entry.path().stem().string();
+                if (stem.size() <= name.size() + 1 || stem.compare(0, name.size(), name) != 0 ||
+                    stem[name.size()] != '-') {
+                    continue;
+                }
+                std::uint64_t index = 0;
+                const auto * end = stem.data() + stem.size();
+                const auto [last, result] = std::from_chars(stem.data() + name.size() + 1, end, index);
+                if (result == std::errc{} && last == end) {
+                    segments.emplace_back(index, entry.path());
+                }
+            }
+            std::sort(segments.begin(), segments.end());
+            return segments;
+        }
+    } // namespace details
+
+    // Appends events to segment files in a directory. append() only copies the encoded event into the current batch;
+    // a background thread commits the whole batch with a single write, and a single fsync if durable, every
+    // commitPeriod or as soon as the batch reaches batchBytes. A journal never appends to segments left by an earlier
+    // one, whose tail may be torn, but starts a new segment after them.
+    //
+    // Events are numbered by their position in Events, which is therefore part of the file format: new events go at
+    // the end.
+    template <typename... Events>
+    class TJournal {
+    public:
+        explicit TJournal(std::filesystem::path directory, std::string name = "journal", JournalOptions options = {})
+            : _directory(std::move(directory)), _name(std::move(name)), _options(options) {
+            std::error_code error;
+            std::filesystem::create_directories(_directory, error);
+            const auto segments = details::journalSegments(_directory, _name);
+            _index = segments.empty() ? 0 : segments.back().first + 1;
+            _ok = openSegment();
+            _thread = std::thread{[this] {
+                run();
+            }};
+        }
+
+        TJournal(const TJournal & other) = delete;
+        TJournal & operator=(const TJournal & other) = delete;
+
+        // commits what is left
+        ~TJournal() {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wakeup.notify_all();
+            _thread.join();
+            if (_file) {
+                std::fclose(_file);
+            }
+        }
+
+        // Records that machine was sent event, which may also be a std::variant of Events. Returns false if the
+        // payload does not fit in a record.
+        template <typename Event>
+        bool append(std::size_t machine, const Event & event) {
+            if constexpr (details::is_variant<Event>::value) {
+                return std::visit(
+                    [&](const auto & alternative) {
+                        return append(machine, alternative);
+                    },
+                    event);
+            } else {
+                constexpr auto type = details::indexOf<Event, Events...>();
+                static_assert(type < sizeof...(Events), "not an event of this journal");
+                const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch());
+                bool full = false;
+                {
+                    std::lock_guard<std::mutex> lock{_mutex};
+                    const auto start = _batch.size();
+                    _batch.write(JournalRecord{static_cast<std::uint64_t>(timestamp.count()),
+                        static_cast<std::uint32_t>(machine), 0, static_cast<std::uint8_t>(type), 0});
+                    TJournalCodec<Event>::encode(_batch, event);
+                    const auto size = _batch.size() - start - sizeof(JournalRecord);
+                    if (size > UINT16_MAX) {
+                        _batch.truncate(start);
+                        return false;
+                    }
+                    _batch.writeAt(start + offsetof(JournalRecord, size), static_cast<std::uint16_t>(size));
+                    ++_appended;
+                    // only the append which fills the batch wakes the committer up
+                    full = start < _options.batchBytes && _batch.size() >= _options.batchBytes;
+                }
+                if (full) {
+                    _wakeup.notify_one();
+                }
+                return true;
+            }
+        }
+
+        // Waits until everything appended so far is committed. Returns false once a write has failed.
+        bool flush() {
+            std::unique_lock<std::mutex> lock{_mutex};
+            const auto appended = _appended;
+            _flushRequested = true;
+            _wakeup.notify_one();
+            _committed.wait(lock, [&] {
+                return _commits >= appended;
+            });
+            return _ok;
+        }
+
+        bool ok() const {
+            std::lock_guard<std::mutex> lock{_mutex};
+            return _ok;
+        }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock{_mutex};
+            while (!_stopping) {
+                _wakeup.wait_for(lock, _options.commitPeriod, [&] {
+                    return _stopping || _flushRequested || _batch.size() >= _options.batchBytes;
+                });
+                commit(lock);
+            }
+            commit(lock);
+        }
+
+        // swaps the batch for the empty one, so that appends go on while the full one is written
+        void commit(std::unique_lock<std::mutex> & lock) {
+            _flushRequested = false;
+            const auto appended = _appended;
+            if (_batch.size() > 0) {
+                std::swap(_batch, _writing);
+                lock.unlock();
+                const auto written = write(_writing);
+                _writing.truncate(0);
+                lock.lock();
+                _ok = _ok && written;
+            }
+            _commits = appended;
+            _committed.notify_all();
+        }
+
+        // on the committing thread only
+        bool write(const SnapshotWriter & batch) {
+            if (_segmentBytes >= _options.segmentBytes && !openSegment()) {
+                return false;
+            }
+            if (!_file || std::fwrite(batch.bytes().data(), 1, batch.size(), _file) != batch.size() ||
+                std::fflush(_file) != 0) {
+                return false;
+            }
+            _segmentBytes += batch.size();
+            if (_options.durable) {
+#ifdef _WIN32
+                return _commit(_fileno(_file)) == 0;
+#else
+                return ::fsync(::fileno(_file)) == 0;
+#endif
+            }
+            return true;
+        }
+
+        bool openSegment() {
+            if (_file) {
+                std::fclose(_file);
+            }
+            const auto path = details::journalSegment(_directory, _name, _index);
+            _file = std::fopen(path.string().c_str(), "wb");
+            if (!_file) {
+                return false;
+            }
+            JournalSegmentHeader header{{}, _index++};
+            std::copy(std::begin(JournalSegmentHeader::MAGIC), std::end(JournalSegmentHeader::MAGIC), header.magic);
+            _segmentBytes = sizeof(header);
+            return std::fwrite(&header, sizeof(header), 1, _file) == 1;
+        }
+
+        const std::filesystem::path _directory;
+        const std::string _name;
+        const JournalOptions _options;
+
+        // the segment being written, owned by the committing thread once it runs
+        std::FILE * _file{nullptr};
+        std::uint64_t _index{0};
+        std::size_t _segmentBytes{0};
+        SnapshotWriter _writing;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wakeup;
+        std::condition_variable _committed;
+        SnapshotWriter _batch;
+        std::uint64_t _appended{0};
+        std::uint64_t _commits{0};
+        bool _flushRequested{false};
+        bool _stopping{false};
+        bool _ok{false};
+        std::thread _thread;
+    };
+
+    // Reads a journal back segment by segment, each mapped into memory and decoded straight from the mapping.
+    template <typename... Events>
+    class TJournalReplay {
+    public:
+        explicit TJournalReplay(const std::filesystem::path & directory, const std::string & name = "journal") {
+            for (auto & segment : details::journalSegments(directory, name)) {
+                _segments.push_back(std::move(segment.second));
+            }
+        }
+
+        std::size_t segments() const {
+            return _segments.size();
+        }
+
+        // Calls fn(machine, timestamp, event) for every record in the order it was appended and returns how many there
+        // were. Stops at the first record which is truncated or corrupt, such as the tail of a segment whose last
+        // commit was cut short; complete() is false then.
+        template <typename Fn>
+        std::size_t replay(Fn && fn) {
+            std::size_t count = 0;
+            _complete = false;
+            for (const auto & path : _segments) {
+                const MappedFile file{path.string()};
+                JournalSegmentHeader header{};
+                if (!file.ok() || file.size() < sizeof(header)) {
+                    return count;
+                }
+                std::memcpy(&header, file.data(), sizeof(header));
+                if (!std::equal(std::begin(JournalSegmentHeader::MAGIC), std::end(JournalSegmentHeader::MAGIC),
+                        std::begin(header.magic))) {
+                    return count;
+                }
+                const auto * next = file.data() + sizeof(header);
+                const auto * end = file.data() + file.size();
+                while (next != end) {
+                    JournalRecord record{};
+                    if (end - next < static_cast<std::ptrdiff_t>(sizeof(record))) {
+                        return count;
+                    }
+                    std::memcpy(&record, next, sizeof(record));
+                    next += sizeof(record);
+                    if (end - next < record.size) {
+                        return count;
+                    }
+                    SnapshotReader reader{next, next + record.size};
+                    if (!dispatch(record, reader, fn, std::index_sequence_for<Events...>{})) {
+                        return count;
+                    }
+                    next += record.size;
+                    ++count;
+                }
+            }
+            _complete = true;
+            return count;
+        }
+
+        bool complete() const {
+            return _complete;
+        }
+
+    private:
+        template <typename Fn, std::size_t... Is>
+        static bool dispatch(
+            const JournalRecord & record, SnapshotReader & reader, Fn & fn, std::index_sequence<Is...> /*unused*/) {
+            return ((record.type == Is && deliver<Events>(record, reader, fn)) || ...);
+        }
+
+        template <typename Event, typename Fn>
+        static bool deliver(const JournalRecord & record, SnapshotReader & reader, Fn & fn) {
+            auto event = TJournalCodec<Event>::decode(reader);
+            if (!reader.ok() || !reader.atEnd()) {
+                return false;
+            }
+            const std::chrono::nanoseconds timestamp{static_cast<std::chrono::nanoseconds::rep>(record.timestamp)};
+            fn(std::size_t{record.machine}, timestamp, std::move(event));
+            return true;
+        }
+
+        std::vector<std::filesystem::path> _segments;
+        bool _complete{false};
+    };
+} // namespace adc
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace adc {
+    enum class LogLevel : std::uint8_t { Debug, Info, Warning, Error, Off };
+} // namespace adc
+
+namespace adc::details {
+    // how an argument is kept in the log buffer: anything convertible to a string_view as its characters, everything
+    // else as the bytes of its value
+    template <typename T>
+    using TLogStored = std::conditional_t<
+        std::is_convertible_v<const T &, std::string_view>, std::string_view, std::remove_cv_t<std::decay_t<T>>>;
+
+    template <typename T>
+    std::size_t encodedSize(const T & arg) {
+        if constexpr (std::is_same_v<TLogStored<T>, std::string_view>) {
+            return sizeof(std::uint32_t) + std::string_view{arg}.size();
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "log arguments are copied as raw bytes");
+            return sizeof(T);
+        }
+    }
+
+    template <typename T>
+    void encode(std::byte *& out, const T & arg) {
+        if constexpr (std::is_same_v<TLogStored<T>, std::string_view>) {
+            const std::string_view text{arg};
+            const auto size = static_cast<std::uint32_t>(text.size());
+            std::memcpy(out, &size, sizeof(size));
+            std::memcpy(out + sizeof(size), text.data(), size);
+            out += sizeof(size) + size;
+        } else {
+            std::memcpy(out, &arg, sizeof(T));
+            out += sizeof(T);
+        }
+    }
+
+    // the string_views returned point into the buffer
+    template <typename T>
+    T decode(const std::byte *& in) {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            std::uint32_t size = 0;
+            std::memcpy(&size, in, sizeof(size));
+            const std::string_view text{reinterpret_cast<const char *>(in + sizeof(size)), size};
+            in += sizeof(size) + size;
+            return text;
+        } else {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            return value;
+        }
+    }
+
+    // prints the arguments in place of the {} of format, in order
+    template <typename... Args>
+    void formatRecord(std::ostream & out, std::string_view format, const std::byte * payload) {
+        // braced initialisation decodes left to right
+        const std::tuple<Args...> args{decode<Args>(payload)...};
+        std::apply(
+            [&](const auto &... arg) {
+                const auto next = [&](const auto & value) {
+                    const auto placeholder = std::min(format.find("{}"), format.size());
+                    out << format.substr(0, placeholder) << value;
+                    format.remove_prefix(std::min(placeholder + 2, format.size()));
+                };
+                (next(arg), ...);
+            },
+            args);
+        out << format << '\n';
+    }
+
+    // A logging call site, registered the first time it logs.
+    struct LogSite {
+        std::string_view format;
+        void (*print)(std::ostream & out, std::string_view format, const std::byte * payload);
+    };
+
+    // The records of one thread: a header followed by the raw arguments, padded to whole headers. Only the owning
+    // thread writes and only the logger thread reads, so each side publishes its position with a release store. A
+    // record which does not fit is dropped and counted rather than blocking the caller.
+    class LogRing {
+    public:
+        static constexpr std::size_t CAPACITY = 1 << 16;
+
+        struct Header {
+            std::uint64_t timestamp; // steady clock, in nanoseconds
+            std::uint32_t site;      // WRAP marks the unused end of the buffer
+            std::uint32_t size;      // of the arguments
+        };
+        static constexpr std::uint32_t WRAP = 0xFFFFFFFF;
+
+        struct Record {
+            const Header * header;
+            const std::byte * payload;
+        };
+
+        explicit LogRing(std::uint32_t thread) : _thread(thread), _bytes(new Header[CAPACITY / sizeof(Header)]) {
+        }
+
+        // owner only
+        template <typename Encode>
+        void write(std::uint32_t site, std::size_t payload, Encode && encode) {
+            const auto size = padded(payload);
+            const auto head = _head.load(std::memory_order_relaxed);
+            const auto offset = head & (CAPACITY - 1);
+            const auto skip = offset + size > CAPACITY ? CAPACITY - offset : 0;
+            if (size > CAPACITY / 2 || head + skip + size - _tail.load(std::memory_order_acquire) > CAPACITY) {
+                _dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            if (skip != 0) {
+                at(offset)->site = WRAP;
+            }
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            auto * header = at((head + skip) & (CAPACITY - 1));
+            *header = Header{
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()), site,
+                static_cast<std::uint32_t>(payload)};
+            auto * out = reinterpret_cast<std::byte *>(header + 1);
+            encode(out);
+            _head.store(head + skip + size, std::memory_order_release);
+        }
+
+        // reader only; the records stay valid until release is called with the returned position
+        std::uint64_t collect(std::vector<Record> & records) const {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            const auto head = _head.load(std::memory_order_acquire);
+            while (tail != head) {
+                const auto offset = tail & (CAPACITY - 1);
+                const auto * header = at(offset);
+                if (header->site == WRAP) {
+                    tail += CAPACITY - offset;
+                    continue;
+                }
+                records.push_back(Record{header, reinterpret_cast<const std::byte *>(header + 1)});
+                tail += padded(header->size);
+            }
+            return tail;
+        }
+
+        void release(std::uint64_t tail) {
+            _tail.store(tail, std::memory_order_release);
+        }
+
+        std::uint64_t dropped() const {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+        std::uint32_t thread() const {
+            return _thread;
+        }
+
+        // owner only, as its thread exits; the ring is retired once it has been drained
+        void finish() {
+            _finished.store(true, std::memory_order_release);
+        }
+
+        // read before collecting, so that whatever the owner wrote before it finished is collected too
+        bool finished() const {
+            return _finished.load(std::memory_order_acquire);
+        }
+
+    private:
+        static std::size_t padded(std::size_t payload) {
+            return (payload + 2 * sizeof(Header) - 1) / sizeof(Header) * sizeof(Header);
+        }
+
+        Header * at(std::uint64_t offset) const {
+            return _bytes.get() + offset / sizeof(Header);
+        }
+
+        const std::uint32_t _thread;
+        std::unique_ptr<Header[]> _bytes;
+        std::atomic<std::uint64_t> _head{0};
+        std::atomic<std::uint64_t> _tail{0};
+        std::atomic<std::uint64_t> _dropped{0};
+        std::atomic<bool> _finished{false};
+    };
+} // namespace adc::details
+
+namespace adc {
+    // Callers copy a call site id and the raw arguments into the buffer of their thread; a background thread formats
+    // them into the sink given to start. Records of different threads are written in timestamp order within each
+    // batch. The level is process-wide and starts at Off.
+    class Logger {
+    public:
+        static Logger & instance() {
+            static Logger logger;
+            return logger;
+        }
+
+        static void setLevel(LogLevel level) {
+            _level.store(level, std::memory_order_relaxed);
+        }
+
+        static LogLevel level() {
+            return _level.load(std::memory_order_relaxed);
+        }
+
+        static bool enabled(LogLevel level) {
+            return level >= _level.load(std::memory_order_relaxed);
+        }
+
+        Logger(const Logger & other) = delete;
+        Logger & operator=(const Logger & other) = delete;
+
+        ~Logger() {
+            stop();
+        }
+
+        // use ADC_LOG, which skips the call and the evaluation of the arguments when the level is disabled
+        template <typename SiteTag, std::size_t N, typename... Args>
+        void log(SiteTag, const char (&format)[N], const Args &... args) {
+            static const auto site = addSite<details::TLogStored<Args>...>(format);
+            const auto payload = (std::size_t{0} + ... + details::encodedSize(args));
+            localRing().write(site, payload, [&](std::byte *& out) {
+                (details::encode(out, args), ...);
+            });
+        }
+
+        // formats the records of all threads into sink every period until stopped
+        void start(std::ostream & sink, std::chrono::milliseconds period = std::chrono::milliseconds{10}) {
+            stop();
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _sink = &sink;
+                _stopping = false;
+            }
+            _thread = std::thread{[this, period] {
+                run(period);
+            }};
+        }
+
+        // writes the remaining records and detaches the sink
+        void stop() {
+            if (!_thread.joinable()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wakeup.notify_all();
+            _thread.join();
+            std::lock_guard<std::mutex> lock{_mutex};
+            drain();
+            _sink->flush();
+            _sink = nullptr;
+        }
+
+        // writes the records logged so far without waiting for the next period
+        void flush() {
+            std::lock_guard<std::mutex> lock{_mutex};
+            if (_sink) {
+                drain();
+                _sink->flush();
+            }
+        }
+
+        // the buffers kept, one per thread which has logged and not yet exited or not yet been drained since
+        std::size_t rings() {
+            std::lock_guard<std::mutex> lock{_mutex};
+            return _rings.size();
+        }
+
+    private:
+        Logger() = default;
+
+        template <typename... Stored>
+        std::uint32_t addSite(std::string_view format) {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _sites.push_back(details::LogSite{format, &details::formatRecord<Stored...>});
+            return static_cast<std::uint32_t>(_sites.size() - 1);
+        }
+
+        // marks the ring of its thread finished as the thread exits, so that drain() can let go of it
+        struct RingOwner {
+            ~RingOwner() {
+                ring->finish();
+            }
+
+            std::shared_ptr<details::LogRing> ring;
+        };
+
+        details::LogRing & localRing() {
+            static thread_local const RingOwner owner{addRing()};
+            return *owner.ring;
+        }
+
+        std::shared_ptr<details::LogRing> addRing() {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _rings.push_back(std::make_shared<details::LogRing>(_threads++));
+            _reported.push_back(0);
+            return _rings.back();
+        }
+
+        void run(std::chrono::milliseconds period) {
+            std::unique_lock<std::mutex> lock{_mutex};
+            while (!_wakeup.wait_for(lock, period, [&] {
+                return _stopping;
+            })) {
+                drain();
+            }
+        }
+
+        // With _mutex held. The rings of threads which had exited before their records were collected are empty
+        // afterwards and are dropped.
+        void drain() {
+            std::vector<details::LogRing::Record> records;
+            std::vector<std::uint64_t> tails;
+            std::vector<bool> finished;
+            tails.reserve(_rings.size());
+            finished.reserve(_rings.size());
+            for (const auto & ring : _rings) {
+                finished.push_back(ring->finished());
+                tails.push_back(ring->collect(records));
+            }
+            std::stable_sort(records.begin(), records.end(), [](const auto & lhs, const auto & rhs) {
+                return lhs.header->timestamp < rhs.header->timestamp;
+            });
+            for (const auto & record : records) {
+                const auto & site = _sites[record.header->site];
+                site.print(*_sink, site.format, record.payload);
+            }
+            for (std::size_t index = 0; index < _rings.size(); ++index) {
+                _rings[index]->release(tails[index]);
+                if (const auto dropped = _rings[index]->dropped(); dropped != _reported[index]) {
+                    *_sink << "logger: dropped " << dropped - _reported[index] << " records of thread "
+                           << _rings[index]->thread() << '\n';
+                    _reported[index] = dropped;
+                }
+            }
+            std::size_t kept = 0;
+            for (std::size_t index = 0; index < _rings.size(); ++index) {
+                if (!finished[index]) {
+                    _rings[kept] = std::move(_rings[index]);
+                    _reported[kept] = _reported[index];
+                    ++kept;
+                }
+            }
+            _rings.resize(kept);
+            _reported.resize(kept);
+        }
+
+        static inline std::atomic<LogLevel> _level{LogLevel::Off};
+
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        bool _stopping{false};
+        std::ostream * _sink{nullptr};
+        std::vector<details::LogSite> _sites;
+        std::vector<std::shared_ptr<details::LogRing>> _rings;
+        std::vector<std::uint64_t> _reported;
+        std::uint32_t _threads{0};
+        std::thread _thread;
+    };
+} // namespace adc
+
+// Logs format, a string literal with a {} per argument, at the given level, e.g. ADC_LOG(Info, "fare [{}]", fare).
+// When the level is disabled this is a single branch and the arguments are not evaluated.
+#define ADC_LOG(level, ...)                                                                                            \
+    do {                                                                                                               \
+        if (::adc::Logger::enabled(::adc::LogLevel::level)) {                                                          \
+            ::adc::Logger::instance().log([] {}, __VA_ARGS__);                                                         \
+        }                                                                                                              \
+    } while (false)
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace adc {
+    // A whole file mapped read-only into memory. Where mmap is not available the file is read into a buffer instead.
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string & path) {
+#ifdef _WIN32
+            std::ifstream in{path, std::ios::binary};
+            if (in) {
+                _buffer.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+                _data = _buffer.data();
+                _size = _buffer.size();
+                _ok = true;
+            }
+#else
+            const auto fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+            struct stat info {};
+            if (::fstat(fd, &info) == 0) {
+                _size = static_cast<std::size_t>(info.st_size);
+                if (_size == 0) {
+                    _ok = true;
+                } else if (auto * data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED) {
+                    _data = static_cast<const char *>(data);
+                    _ok = true;
+                }
+            }
+            ::close(fd);
+#endif
+        }
+
+        MappedFile(const MappedFile & other) = delete;
+        MappedFile & operator=(const MappedFile & other) = delete;
+
+        ~MappedFile() {
+#ifndef _WIN32
+            if (_data) {
+                ::munmap(const_cast<char *>(_data), _size);
+            }
+#endif
+        }
+
+        bool ok() const {
+            return _ok;
+        }
+
+        const char * data() const {
+            return _data;
+        }
+
+        std::size_t size() const {
+            return _size;
+        }
+
+    private:
+#ifdef _WIN32
+        std::vector<char> _buffer;
+#endif
+        const char * _data{nullptr};
+        std::size_t _size{0};
+        bool _ok{false};
+    };
+} // namespace adc
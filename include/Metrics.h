@@ -0,0 +1,370 @@
+#pragma once
+
+#include "FSM.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace adc {
+    // The metrics of one group of machines sharing a list of states, e.g. one gate, identified by its labels.
+    class MetricsSeries {
+    public:
+        MetricsSeries(std::size_t id, std::vector<std::string> states, std::string labels)
+            : _id(id), _states(std::move(states)), _labels(std::move(labels)) {
+        }
+
+        std::size_t id() const {
+            return _id;
+        }
+
+        const std::vector<std::string> & states() const {
+            return _states;
+        }
+
+        // preformatted Prometheus labels, without braces
+        const std::string & labels() const {
+            return _labels;
+        }
+
+    private:
+        const std::size_t _id;
+        const std::vector<std::string> _states;
+        const std::string _labels;
+    };
+} // namespace adc
+
+namespace adc::details {
+    // Index of each counter of a series in one flat array: entries per state, transitions per (from, to), then the
+    // dwell time histogram and the total dwell time per state.
+    struct SeriesLayout {
+        // dwell time buckets with upper bounds of 1ms, 2ms, 4ms ... 2^(BUCKETS-2)ms, and +Inf
+        static constexpr std::size_t BUCKETS = 18;
+
+        std::size_t size() const {
+            return states * (states + BUCKETS + 2);
+        }
+
+        std::size_t entries(std::size_t state) const {
+            return state;
+        }
+
+        std::size_t transitions(std::size_t from, std::size_t to) const {
+            return states + from * states + to;
+        }
+
+        std::size_t dwellBucket(std::size_t state, std::size_t bucket) const {
+            return states * (states + 1) + state * BUCKETS + bucket;
+        }
+
+        std::size_t dwellNanos(std::size_t state) const {
+            return states * (states + BUCKETS + 1) + state;
+        }
+
+        // the first bucket whose bound the dwell does not exceed, as the le of Prometheus is inclusive
+        static std::size_t bucketOf(std::chrono::nanoseconds dwell) {
+            std::chrono::nanoseconds bound = std::chrono::milliseconds{1};
+            std::size_t bucket = 0;
+            while (dwell > bound && bucket < BUCKETS - 1) {
+                bound *= 2;
+                ++bucket;
+            }
+            return bucket;
+        }
+
+        std::size_t states;
+    };
+
+    // Counters of one series written by a single thread. They are atomics only so that the exporter may read them:
+    // the owner increments with a relaxed load and store, a plain add without a locked instruction.
+    class SeriesCounters {
+    public:
+        explicit SeriesCounters(std::size_t states) : _layout{states}, _counters(_layout.size()) {
+        }
+
+        void recordTransition(std::size_t from, std::size_t to) {
+            if (from < _layout.states && to < _layout.states) {
+                bump(_counters[_layout.entries(to)]);
+                bump(_counters[_layout.transitions(from, to)]);
+            }
+        }
+
+        void recordDwell(std::size_t state, std::chrono::nanoseconds dwell) {
+            if (state < _layout.states) {
+                bump(_counters[_layout.dwellBucket(state, SeriesLayout::bucketOf(dwell))]);
+                bump(_counters[_layout.dwellNanos(state)], static_cast<std::uint64_t>(dwell.count()));
+            }
+        }
+
+        void addTo(std::vector<std::uint64_t> & totals) const {
+            for (std::size_t index = 0; index < _counters.size(); ++index) {
+                totals[index] += _counters[index].load(std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        static void bump(std::atomic<std::uint64_t> & counter, std::uint64_t by = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        }
+
+        const SeriesLayout _layout;
+        std::vector<std::atomic<std::uint64_t>> _counters;
+    };
+
+    // The counters of every series touched by one thread, indexed by series id. Only the owner adds counters, under
+    // the mutex that the exporter holds while reading.
+    class MetricsShard {
+    public:
+        SeriesCounters & countersFor(const MetricsSeries & series) {
+            if (series.id() < _counters.size() && _counters[series.id()]) {
+                return *_counters[series.id()];
+            }
+            std::lock_guard<std::mutex> lock{_mutex};
+            if (series.id() >= _counters.size()) {
+                _counters.resize(series.id() + 1);
+            }
+            _counters[series.id()] = std::make_unique<SeriesCounters>(series.states().size());
+            return *_counters[series.id()];
+        }
+
+        template <typename Fn>
+        void forEach(Fn && fn) const {
+            std::lock_guard<std::mutex> lock{_mutex};
+            for (std::size_t id = 0; id < _counters.size(); ++id) {
+                if (_counters[id]) {
+                    fn(id, *_counters[id]);
+                }
+            }
+        }
+
+    private:
+        mutable std::mutex _mutex;
+        std::vector<std::unique_ptr<SeriesCounters>> _counters;
+    };
+} // namespace adc::details
+
+namespace adc {
+    // Owns the series and the shards of all threads; shards outlive their threads so that no counts are lost.
+    class MetricsRegistry {
+    public:
+        static MetricsRegistry & instance() {
+            static MetricsRegistry registry;
+            return registry;
+        }
+
+        // labels are name/value pairs such as {"gate", "12"}, {"station", "Central"}
+        const MetricsSeries & addSeries(
+            std::vector<std::string> states, const std::vector<std::pair<std::string, std::string>> & labels) {
+            std::string formatted;
+            for (const auto & [name, value] : labels) {
+                formatted += (formatted.empty() ? "" : ",") + name + "=\"" + value + "\"";
+            }
+            std::lock_guard<std::mutex> lock{_mutex};
+            _series.push_back(std::make_unique<MetricsSeries>(_series.size(), std::move(states), std::move(formatted)));
+            return *_series.back();
+        }
+
+        details::MetricsShard & localShard() {
+            static thread_local const std::shared_ptr<details::MetricsShard> shard = addShard();
+            return *shard;
+        }
+
+        // sums the shards of all threads into the Prometheus text exposition format
+        void writePrometheus(std::ostream & out) const {
+            std::lock_guard<std::mutex> lock{_mutex};
+            std::vector<std::vector<std::uint64_t>> totals;
+            totals.reserve(_series.size());
+            for (const auto & series : _series) {
+                totals.emplace_back(layoutOf(*series).size());
+            }
+            for (const auto & shard : _shards) {
+                shard->forEach([&](std::size_t id, const details::SeriesCounters & counters) {
+                    counters.addTo(totals[id]);
+                });
+            }
+
+            out << "# HELP fsm_state_entries_total Transitions into a state.\n"
+                << "# TYPE fsm_state_entries_total counter\n";
+            forEachState([&](const MetricsSeries & series, std::size_t state, const std::string & labels) {
+                out << "fsm_state_entries_total{" << labels << "} "
+                    << totals[series.id()][layoutOf(series).entries(state)] << '\n';
+            });
+
+            out << "# HELP fsm_transitions_total Transitions between two states.\n"
+                << "# TYPE fsm_transitions_total counter\n";
+            for (const auto & series : _series) {
+                const auto & states = series->states();
+                for (std::size_t from = 0; from < states.size(); ++from) {
+                    for (std::size_t to = 0; to < states.size(); ++to) {
+                        if (const auto count = totals[series->id()][layoutOf(*series).transitions(from, to)]) {
+                            out << "fsm_transitions_total{" << prefix(*series) << "from=\"" << states[from]
+                                << "\",to=\"" << states[to] << "\"} " << count << '\n';
+                        }
+                    }
+                }
+            }
+
+            out << "# HELP fsm_state_dwell_seconds Time spent in a state before leaving it.\n"
+                << "# TYPE fsm_state_dwell_seconds histogram\n";
+            forEachState([&](const MetricsSeries & series, std::size_t state, const std::string & labels) {
+                const auto layout = layoutOf(series);
+                const auto & counters = totals[series.id()];
+                std::uint64_t cumulative = 0;
+                for (std::size_t bucket = 0; bucket < details::SeriesLayout::BUCKETS; ++bucket) {
+                    cumulative += counters[layout.dwellBucket(state, bucket)];
+                    out << "fsm_state_dwell_seconds_bucket{" << labels << ",le=\"";
+                    if (bucket + 1 < details::SeriesLayout::BUCKETS) {
+                        out << static_cast<double>(std::uint64_t{1} << bucket) / 1000;
+                    } else {
+                        out << "+Inf";
+                    }
+                    out << "\"} " << cumulative << '\n';
+                }
+                out << "fsm_state_dwell_seconds_sum{" << labels << "} "
+                    << static_cast<double>(counters[layout.dwellNanos(state)]) / 1e9 << '\n';
+                out << "fsm_state_dwell_seconds_count{" << labels << "} " << cumulative << '\n';
+            });
+        }
+
+        // writes to a temporary file renamed over path, so that a scraper never reads a partial snapshot
+        bool writePrometheus(const std::string & path) const {
+            const auto temporary = path + ".tmp";
+            {
+                std::ofstream out{temporary, std::ios::trunc};
+                writePrometheus(out);
+                if (!out.flush()) {
+                    return false;
+                }
+            }
+#ifdef _WIN32
+            std::remove(path.c_str());
+#endif
+            return std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+    private:
+        std::shared_ptr<details::MetricsShard> addShard() {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _shards.push_back(std::make_shared<details::MetricsShard>());
+            return _shards.back();
+        }
+
+        static details::SeriesLayout layoutOf(const MetricsSeries & series) {
+            return details::SeriesLayout{series.states().size()};
+        }
+
+        static std::string prefix(const MetricsSeries & series) {
+            return series.labels().empty() ? std::string{} : series.labels() + ",";
+        }
+
+        template <typename Fn>
+        void forEachState(Fn && fn) const {
+            for (const auto & series : _series) {
+                for (std::size_t state = 0; state < series->states().size(); ++state) {
+                    fn(*series, state, prefix(*series) + "state=\"" + series->states()[state] + "\"");
+                }
+            }
+        }
+
+        MetricsRegistry() = default;
+
+        mutable std::mutex _mutex;
+        std::vector<std::unique_ptr<MetricsSeries>> _series;
+        std::vector<std::shared_ptr<details::MetricsShard>> _shards;
+    };
+
+    // Tracer policy counting the transitions of a machine and how long it dwelt in each state, into the shard of the
+    // calling thread. It does nothing until attached to a series, whose states must be listed in the FSM's order.
+    class MetricsTracer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        void attach(const MetricsSeries & series) {
+            _series = &series;
+            _since = Clock::now();
+        }
+
+        template <typename Event>
+        void onEvent(std::size_t state, const Event & event) {
+        }
+
+        void onExit(std::size_t state) {
+            if (_series) {
+                const auto now = Clock::now();
+                counters().recordDwell(state, now - _since);
+                _since = now;
+                _from = state;
+            }
+        }
+
+        void onEntry(std::size_t state) {
+            if (_series) {
+                counters().recordTransition(_from, state);
+            }
+        }
+
+        void onNoOp(std::size_t state) {
+        }
+
+    private:
+        details::SeriesCounters & counters() const {
+            return MetricsRegistry::instance().localShard().countersFor(*_series);
+        }
+
+        const MetricsSeries * _series{nullptr};
+        Clock::time_point _since{};
+        std::size_t _from{0};
+    };
+
+    // Writes a snapshot of the registry to a file every period from a background thread, and once more when stopped.
+    class MetricsExporter {
+    public:
+        MetricsExporter(std::string path, std::chrono::milliseconds period)
+            : _path(std::move(path)), _period(period), _thread([this] {
+                  run();
+              }) {
+        }
+
+        MetricsExporter(const MetricsExporter & other) = delete;
+        MetricsExporter & operator=(const MetricsExporter & other) = delete;
+
+        ~MetricsExporter() {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wakeup.notify_all();
+            _thread.join();
+            MetricsRegistry::instance().writePrometheus(_path);
+        }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock{_mutex};
+            while (!_wakeup.wait_for(lock, _period, [&] {
+                return _stopping;
+            })) {
+                lock.unlock();
+                MetricsRegistry::instance().writePrometheus(_path);
+                lock.lock();
+            }
+        }
+
+        const std::string _path;
+        const std::chrono::milliseconds _period;
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        bool _stopping{false};
+        std::thread _thread;
+    };
+} // namespace adc
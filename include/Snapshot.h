@@ -0,0 +1,246 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace adc {
+    // Collects the bytes of a snapshot. States write their payload through it from a save(SnapshotWriter &) member.
+    class SnapshotWriter {
+    public:
+        template <typename T>
+        void write(const T & value) {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values are written as is");
+            static_assert(!std::is_pointer_v<T> && !std::is_array_v<T>, "write text as a std::string_view");
+            const auto * bytes = reinterpret_cast<const char *>(&value);
+            _bytes.insert(_bytes.end(), bytes, bytes + sizeof(T));
+        }
+
+        // length-prefixed, up to 64KiB
+        void write(std::string_view text) {
+            const auto size = static_cast<std::uint16_t>(std::min<std::size_t>(text.size(), UINT16_MAX));
+            write(size);
+            _bytes.insert(_bytes.end(), text.data(), text.data() + size);
+        }
+
+        void write(const std::string & text) {
+            write(std::string_view{text});
+        }
+
+        // overwrites a value written earlier, at offset bytes from the start
+        template <typename T>
+        void writeAt(std::size_t offset, const T & value) {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values are written as is");
+            std::memcpy(_bytes.data() + offset, &value, sizeof(T));
+        }
+
+        const std::vector<char> & bytes() const {
+            return _bytes;
+        }
+
+        std::size_t size() const {
+            return _bytes.size();
+        }
+
+        // drops what was written after the first size bytes, keeping the capacity for later writes
+        void truncate(std::size_t size) {
+            _bytes.resize(std::min(size, _bytes.size()));
+        }
+
+        // each machine is a record prefixed with its size, which endRecord fills in
+        void beginRecord() {
+            _record = _bytes.size();
+            write(std::uint16_t{0});
+        }
+
+        bool endRecord() {
+            const auto size = _bytes.size() - _record - sizeof(std::uint16_t);
+            if (size > UINT16_MAX) {
+                return false;
+            }
+            writeAt(_record, static_cast<std::uint16_t>(size));
+            return true;
+        }
+
+        void reserve(std::size_t size) {
+            _bytes.reserve(size);
+        }
+
+    private:
+        std::vector<char> _bytes;
+        std::size_t _record{0};
+    };
+
+    // Reads back what SnapshotWriter wrote. Reading past the end, or a state rejecting what it read, fails the reader:
+    // reads then return empty values and ok() is false.
+    class SnapshotReader {
+    public:
+        SnapshotReader(const char * begin, const char * end) : _next(begin), _end(end) {
+        }
+
+        template <typename T>
+        T read() {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values are read as is");
+            T value{};
+            if (available(sizeof(T))) {
+                std::memcpy(&value, _next, sizeof(T));
+                _next += sizeof(T);
+            }
+            return value;
+        }
+
+        // points into the snapshot, which must outlive the view
+        std::string_view readString() {
+            const auto size = read<std::uint16_t>();
+            if (!available(size)) {
+                return {};
+            }
+            const std::string_view text{_next, size};
+            _next += size;
+            return text;
+        }
+
+        void fail() {
+            _ok = false;
+        }
+
+        bool ok() const {
+            return _ok;
+        }
+
+        bool atEnd() const {
+            return _next == _end;
+        }
+
+    private:
+        bool available(std::size_t size) {
+            if (!_ok || static_cast<std::size_t>(_end - _next) < size) {
+                _ok = false;
+                return false;
+            }
+            return true;
+        }
+
+        const char * _next;
+        const char * _end;
+        bool _ok{true};
+    };
+
+    // The file layout: magic, the schema version chosen by the application and the number of machines, then one
+    // record per machine holding its state index and the payload of that state. Native byte order.
+    struct SnapshotHeader {
+        static constexpr char MAGIC[8] = {'A', 'D', 'C', 'S', 'N', 'P', '0', '1'};
+
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t count;
+    };
+    static_assert(sizeof(SnapshotHeader) == 16, "snapshot headers are written to disk as is");
+
+    // Writes count machines, save(id, writer) writing each one, usually by calling its save member. The file is
+    // written next to path and renamed over it, so that a crash never leaves a partial snapshot behind.
+    template <typename Save>
+    bool writeSnapshot(const std::string & path, std::uint32_t version, std::size_t count, Save && save) {
+        if (count > std::numeric_limits<std::uint32_t>::max()) {
+            return false;
+        }
+        SnapshotWriter out;
+        out.reserve(sizeof(SnapshotHeader) + count * 32);
+        SnapshotHeader header{{}, version, static_cast<std::uint32_t>(count)};
+        std::copy(std::begin(SnapshotHeader::MAGIC), std::end(SnapshotHeader::MAGIC), header.magic);
+        out.write(header);
+        for (std::size_t id = 0; id < count; ++id) {
+            out.beginRecord();
+            save(id, out);
+            if (!out.endRecord()) {
+                return false;
+            }
+        }
+
+        const auto temporary = path + ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            file.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()));
+            if (!file.flush()) {
+                return false;
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    // A snapshot file mapped into memory, restored machine by machine straight from the mapping.
+    class SnapshotFile {
+    public:
+        explicit SnapshotFile(const std::string & path) : _file(path) {
+            if (_file.ok() && _file.size() >= sizeof(SnapshotHeader)) {
+                std::memcpy(&_header, _file.data(), sizeof(_header));
+                _ok = std::equal(
+                    std::begin(SnapshotHeader::MAGIC), std::end(SnapshotHeader::MAGIC), std::begin(_header.magic));
+            }
+        }
+
+        bool ok() const {
+            return _ok;
+        }
+
+        std::uint32_t version() const {
+            return _header.version;
+        }
+
+        std::size_t size() const {
+            return _ok ? _header.count : 0;
+        }
+
+        // Calls check(id, reader) for every machine, usually forwarding to the static check of its type, then
+        // restore(id, reader), usually forwarding to its restore member. Nothing is restored unless every record
+        // passes the check and is read to its end, so a corrupt snapshot never leaves the machines partly restored.
+        template <typename Check, typename Restore>
+        bool restore(Check && check, Restore && restore) const {
+            return forEachRecord(check) && forEachRecord(restore);
+        }
+
+    private:
+        // stops at the first record which is truncated, rejected or not read to its end
+        template <typename Fn>
+        bool forEachRecord(Fn & fn) const {
+            if (!_ok) {
+                return false;
+            }
+            const auto * next = _file.data() + sizeof(SnapshotHeader);
+            const auto * end = _file.data() + _file.size();
+            for (std::size_t id = 0; id < size(); ++id) {
+                std::uint16_t length = 0;
+                if (end - next < static_cast<std::ptrdiff_t>(sizeof(length))) {
+                    return false;
+                }
+                std::memcpy(&length, next, sizeof(length));
+                next += sizeof(length);
+                if (end - next < length) {
+                    return false;
+                }
+                SnapshotReader reader{next, next + length};
+                if (!fn(id, reader) || !reader.ok() || !reader.atEnd()) {
+                    return false;
+                }
+                next += length;
+            }
+            return true;
+        }
+
+        MappedFile _file;
+        SnapshotHeader _header{};
+        bool _ok{false};
+    };
+} // namespace adc
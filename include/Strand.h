@@ -0,0 +1,96 @@
+#pragma once
+
+#include "EventMailbox.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <thread>
+#include <utility>
+#include <variant>
+
+namespace adc {
+    // Runs the events of one FSM one at a time, on the threads posting them rather than on an executor of its own. A
+    // post finding the strand idle processes its event at once on the calling thread, taking no lock; one finding it
+    // busy leaves the event in a lock-free mailbox, and the thread inside processes it before leaving. Events posted
+    // while processing, by the FSM's own actions or its timers firing meanwhile, therefore run after the current one.
+    // FIFO per producer. The posts of the thread inside never fail: they go to an unbounded queue of its own, which is
+    // drained before the mailbox, so that an FSM acting on itself cannot be refused by a mailbox others have filled.
+    template <typename FSM, typename... Events>
+    class TStrand {
+    public:
+        explicit TStrand(FSM & fsm, std::size_t capacity = 1024) : _fsm(fsm), _mailbox(capacity) {
+        }
+
+        TStrand(const TStrand & other) = delete;
+        TStrand & operator=(const TStrand & other) = delete;
+
+        // returns false without blocking when another thread is inside and the mailbox is full
+        template <typename Event>
+        bool post(Event && event) {
+            const auto self = std::this_thread::get_id();
+            if (_inside.load(std::memory_order_relaxed) == self) {
+                _reentrant.emplace_back(std::forward<Event>(event));
+                _pending.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            std::size_t idle = 0;
+            if (_pending.compare_exchange_strong(idle, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                _inside.store(self, std::memory_order_relaxed);
+                _fsm.process(std::forward<Event>(event));
+                leave();
+                return true;
+            }
+            if (!_mailbox.post(std::forward<Event>(event))) {
+                return false;
+            }
+            // the thread inside may have left since, in which case the events it did not see are this one's to run
+            if (_pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                _inside.store(self, std::memory_order_relaxed);
+                processNext();
+                leave();
+            }
+            return true;
+        }
+
+    private:
+        // _pending counts the events posted and not yet processed, including the one being processed; the thread
+        // taking it from zero is the one inside until it drops back to zero. _inside only ever holds the id of the
+        // thread reading it while that thread is inside, so it needs no ordering of its own.
+        void leave() {
+            for (;;) {
+                _inside.store(std::thread::id{}, std::memory_order_relaxed);
+                if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return;
+                }
+                _inside.store(std::this_thread::get_id(), std::memory_order_relaxed);
+                processNext();
+            }
+        }
+
+        // the thread's own posts first; an event is counted only once it is in the mailbox, but the producer of an
+        // earlier cell may still be filling it
+        void processNext() {
+            if (!_reentrant.empty()) {
+                auto event = std::move(_reentrant.front());
+                _reentrant.pop_front();
+                std::visit(
+                    [&](auto & alternative) {
+                        _fsm.process(std::move(alternative));
+                    },
+                    event);
+                return;
+            }
+            while (_mailbox.drain(_fsm, 1) == 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        FSM & _fsm;
+        TEventMailbox<Events...> _mailbox;
+        std::atomic<std::size_t> _pending{0};
+        std::atomic<std::thread::id> _inside{};
+        // only touched by the thread inside
+        std::deque<std::variant<Events...>> _reentrant;
+    };
+} // namespace adc
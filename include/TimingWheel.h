@@ -0,0 +1,550 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace adc {
+    class TimerNode;
+    class TimingWheel;
+    class TimerSource;
+
+    namespace details {
+        // circular doubly linked list; a link pointing at itself is unlinked, a head pointing at itself is empty
+        struct TimerLink {
+            TimerLink() = default;
+            TimerLink(const TimerLink & other) = delete;
+            TimerLink & operator=(const TimerLink & other) = delete;
+
+            bool linked() const {
+                return next != this;
+            }
+
+            void unlink() {
+                prev->next = next;
+                next->prev = prev;
+                prev = next = this;
+            }
+
+            void pushBack(TimerLink & link) {
+                link.prev = prev;
+                link.next = this;
+                prev->next = &link;
+                prev = &link;
+            }
+
+            void replaceWith(TimerLink & link) {
+                link.prev = prev;
+                link.next = next;
+                prev->next = &link;
+                next->prev = &link;
+                prev = next = this;
+            }
+
+            TimerLink * prev{this};
+            TimerLink * next{this};
+        };
+    } // namespace details
+
+    // A timer embedded in its owner, so scheduling never allocates. The owner must cancel it before destruction;
+    // expire() runs on the thread driving the TimerSource it was scheduled on.
+    class TimerNode : private details::TimerLink {
+    public:
+        TimerNode() = default;
+
+        bool pending() const {
+            return linked();
+        }
+
+    protected:
+        ~TimerNode() = default;
+
+        virtual void expire() = 0;
+
+    private:
+        friend class TimingWheel;
+        friend class TimerSource;
+
+        static constexpr std::uint16_t EXPIRED = 0xFFFF;
+
+        std::uint64_t _deadline{0};
+        std::uint16_t _slot{EXPIRED};
+    };
+
+    // Hierarchical timing wheel counting in abstract ticks: LEVELS wheels of SLOTS slots each, where a slot of level L
+    // spans SLOTS^L ticks. Schedule and cancel are O(1); timers in the upper levels cascade down as time reaches their
+    // slot. Not thread safe, see TimerService.
+    class TimingWheel {
+    public:
+        static constexpr unsigned BITS = 6;
+        static constexpr unsigned LEVELS = 6;
+        static constexpr unsigned SLOTS = 1u << BITS;
+
+        TimingWheel() = default;
+        TimingWheel(const TimingWheel & other) = delete;
+        TimingWheel & operator=(const TimingWheel & other) = delete;
+
+        std::uint64_t now() const {
+            return _now;
+        }
+
+        std::size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        // deadlines that are not in the future expire on the next tick; a pending node is rescheduled
+        void schedule(TimerNode & node, std::uint64_t deadline) {
+            cancel(node);
+            node._deadline = deadline > _now ? deadline : _now + 1;
+            insert(node);
+            ++_size;
+        }
+
+        void cancel(TimerNode & node) {
+            if (!node.linked()) {
+                return;
+            }
+            if (node._slot != TimerNode::EXPIRED) {
+                --_size;
+                unlink(node);
+            } else {
+                node.unlink();
+            }
+        }
+
+        // hands a pending node over to another one, which takes its place and deadline
+        void replace(TimerNode & from, TimerNode & to) {
+            cancel(to);
+            if (from.linked()) {
+                to._deadline = from._deadline;
+                to._slot = from._slot;
+                from.replaceWith(to);
+                from._slot = TimerNode::EXPIRED;
+            }
+        }
+
+        // Advances the wheel to tick `to` and appends the timers that expired, in deadline order, to expired. Ticks
+        // without work are skipped.
+        void advance(std::uint64_t to, details::TimerLink & expired) {
+            while (_now < to) {
+                const auto next = nextTick();
+                if (!next || *next > to) {
+                    _now = to;
+                    return;
+                }
+                _now = *next - 1;
+                step(expired);
+            }
+        }
+
+        // removes the first timer from a list filled by advance(), if any
+        static TimerNode * takeFirst(details::TimerLink & expired) {
+            if (!expired.linked()) {
+                return nullptr;
+            }
+            auto & node = static_cast<TimerNode &>(*expired.next);
+            node.unlink();
+            return &node;
+        }
+
+        // the earliest tick at which timers expire or cascade, if any timer is pending
+        std::optional<std::uint64_t> nextTick() const {
+            std::optional<std::uint64_t> result;
+            for (unsigned level = 0; level < LEVELS; ++level) {
+                if (!_occupied[level]) {
+                    continue;
+                }
+                const auto shift = level * BITS;
+                const auto index = digit(_now, level);
+                const auto base = _now >> (shift + BITS) << (shift + BITS);
+                const auto later = index + 1 < SLOTS ? _occupied[level] >> (index + 1) << (index + 1) : 0;
+                // only far timers clamped into the top level can sit at or behind its current slot
+                const auto tick = later ? base + (std::uint64_t{lowestBit(later)} << shift)
+                                        : base + (std::uint64_t{SLOTS + lowestBit(_occupied[level])} << shift);
+                if (!result || tick < *result) {
+                    result = tick;
+                }
+            }
+            return result;
+        }
+
+    private:
+        static unsigned lowestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+            unsigned index = 0;
+            while (!(bits & 1)) {
+                bits >>= 1;
+                ++index;
+            }
+            return index;
+#endif
+        }
+
+        static unsigned digit(std::uint64_t tick, unsigned level) {
+            return static_cast<unsigned>((tick >> (level * BITS)) & (SLOTS - 1));
+        }
+
+        // a node lives in the level of the highest digit in which its deadline differs from now
+        void insert(TimerNode & node) {
+            unsigned level = 0;
+            while (level + 1 < LEVELS && (node._deadline >> ((level + 1) * BITS)) != (_now >> ((level + 1) * BITS))) {
+                ++level;
+            }
+            const auto slot = digit(node._deadline, level);
+            node._slot = static_cast<std::uint16_t>(level * SLOTS + slot);
+            _slots[node._slot].pushBack(node);
+            _occupied[level] |= std::uint64_t{1} << slot;
+        }
+
+        void unlink(TimerNode & node) {
+            auto & head = _slots[node._slot];
+            node.unlink();
+            if (!head.linked()) {
+                _occupied[node._slot / SLOTS] &= ~(std::uint64_t{1} << (node._slot % SLOTS));
+            }
+            node._slot = TimerNode::EXPIRED;
+        }
+
+        // far timers clamped into the top level may land in the slot being cascaded, so the slot is emptied first
+        void cascade(unsigned level) {
+            auto & head = _slots[level * SLOTS + digit(_now, level)];
+            details::TimerLink cascading;
+            while (head.linked()) {
+                auto & node = static_cast<TimerNode &>(*head.next);
+                unlink(node);
+                cascading.pushBack(node);
+            }
+            while (cascading.linked()) {
+                auto & node = static_cast<TimerNode &>(*cascading.next);
+                node.unlink();
+                insert(node);
+            }
+        }
+
+        void step(details::TimerLink & expired) {
+            ++_now;
+            unsigned levels = 1;
+            while (levels < LEVELS && digit(_now, levels - 1) == 0) {
+                ++levels;
+            }
+            for (auto level = levels - 1; level > 0; --level) {
+                cascade(level);
+            }
+            auto & head = _slots[digit(_now, 0)];
+            while (head.linked()) {
+                auto & node = static_cast<TimerNode &>(*head.next);
+                unlink(node);
+                expired.pushBack(node);
+                --_size;
+            }
+        }
+
+        std::uint64_t _now{0};
+        std::size_t _size{0};
+        std::array<std::uint64_t, LEVELS> _occupied{};
+        std::array<details::TimerLink, LEVELS * SLOTS> _slots;
+    };
+
+    // Where timers are scheduled. TimeoutManager binds to the current source when it is created, which is the process
+    // wide TimerService unless overridden, e.g. by a VirtualTimerSource for simulations, or for one thread only.
+    class TimerSource {
+    public:
+        virtual void schedule(TimerNode & node, std::chrono::milliseconds duration) = 0;
+        virtual void cancel(TimerNode & node) = 0;
+        virtual void replace(TimerNode & from, TimerNode & to) = 0;
+
+        static TimerSource & current();
+
+        // makes source the current one of every thread for its lifetime
+        class Override {
+        public:
+            explicit Override(TimerSource & source) : _previous(slot().exchange(&source)) {
+            }
+            Override(const Override & other) = delete;
+            Override & operator=(const Override & other) = delete;
+            ~Override() {
+                slot().store(_previous);
+            }
+
+        private:
+            TimerSource * _previous;
+        };
+
+        // makes source the current one of the calling thread for its lifetime, ahead of any Override
+        class ThreadOverride {
+        public:
+            explicit ThreadOverride(TimerSource & source) : _previous(std::exchange(threadSlot(), &source)) {
+            }
+            ThreadOverride(const ThreadOverride & other) = delete;
+            ThreadOverride & operator=(const ThreadOverride & other) = delete;
+            ~ThreadOverride() {
+                threadSlot() = _previous;
+            }
+
+        private:
+            TimerSource * _previous;
+        };
+
+    protected:
+        ~TimerSource() = default;
+
+        static void expire(TimerNode & node) {
+            node.expire();
+        }
+
+    private:
+        static std::atomic<TimerSource *> & slot() {
+            static std::atomic<TimerSource *> source{nullptr};
+            return source;
+        }
+
+        static TimerSource *& threadSlot() {
+            static thread_local TimerSource * source = nullptr;
+            return source;
+        }
+    };
+
+    // Drives a TimingWheel from the steady clock on one background thread, started on the first schedule. Expiries
+    // run on that thread without the lock held, so they may schedule or cancel timers, including their own.
+    class TimerService final : public TimerSource {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit TimerService(std::chrono::milliseconds tick = std::chrono::milliseconds{1})
+            : _tick(tick), _start(Clock::now()) {
+        }
+
+        TimerService(const TimerService & other) = delete;
+        TimerService & operator=(const TimerService & other) = delete;
+
+        ~TimerService() {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wakeup.notify_all();
+            if (_driver.joinable()) {
+                _driver.join();
+            }
+        }
+
+        static TimerService & instance() {
+            static TimerService service;
+            return service;
+        }
+
+        void schedule(TimerNode & node, std::chrono::milliseconds duration) override {
+            std::lock_guard<std::mutex> lock{_mutex};
+            const auto deadline = toTicks(Clock::now() - _start + duration);
+            const auto earliest = _wheel.nextTick();
+            _wheel.schedule(node, deadline);
+            if (!_driver.joinable()) {
+                _driver = std::thread{[this] {
+                    run();
+                }};
+            } else if (!earliest || deadline < *earliest) {
+                _wakeup.notify_all();
+            }
+        }
+
+        // once cancel returns the node's expire() is not running, unless it is called from within that expire()
+        void cancel(TimerNode & node) override {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _wheel.cancel(node);
+            if (_running == &node && std::this_thread::get_id() != _driver.get_id()) {
+                _finished.wait(lock, [&] {
+                    return _running != &node;
+                });
+            }
+        }
+
+        void replace(TimerNode & from, TimerNode & to) override {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _wheel.replace(from, to);
+        }
+
+        std::size_t pending() const {
+            std::lock_guard<std::mutex> lock{_mutex};
+            return _wheel.size();
+        }
+
+    private:
+        std::uint64_t toTicks(Clock::duration elapsed) const {
+            const auto ticks = elapsed / _tick;
+            return ticks > 0 ? static_cast<std::uint64_t>(ticks) : 0;
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock{_mutex};
+            while (!_stopping) {
+                const auto next = _wheel.nextTick();
+                if (!next) {
+                    _wakeup.wait(lock);
+                    continue;
+                }
+                const auto now = toTicks(Clock::now() - _start);
+                if (now < *next) {
+                    _wakeup.wait_until(lock, _start + _tick * static_cast<std::int64_t>(*next));
+                    continue;
+                }
+                _wheel.advance(now, _expired);
+                while (const auto node = TimingWheel::takeFirst(_expired)) {
+                    _running = node;
+                    lock.unlock();
+                    expire(*node);
+                    lock.lock();
+                    _running = nullptr;
+                    _finished.notify_all();
+                }
+            }
+        }
+
+        const std::chrono::milliseconds _tick;
+        const Clock::time_point _start;
+        mutable std::mutex _mutex;
+        std::condition_variable _wakeup;
+        std::condition_variable _finished;
+        TimingWheel _wheel;
+        details::TimerLink _expired;
+        TimerNode * _running{nullptr};
+        bool _stopping{false};
+        std::thread _driver;
+    };
+
+    // Deterministic virtual time for simulations: nothing happens until run*() is called, which jumps straight from one
+    // deadline to the next and fires the expiries on the calling thread.
+    class VirtualTimerSource final : public TimerSource {
+    public:
+        VirtualTimerSource() = default;
+        VirtualTimerSource(const VirtualTimerSource & other) = delete;
+        VirtualTimerSource & operator=(const VirtualTimerSource & other) = delete;
+
+        std::chrono::milliseconds now() const {
+            return std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(_wheel.now())};
+        }
+
+        void schedule(TimerNode & node, std::chrono::milliseconds duration) override {
+            const auto ticks = duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0;
+            _wheel.schedule(node, _wheel.now() + ticks);
+        }
+
+        void cancel(TimerNode & node) override {
+            _wheel.cancel(node);
+        }
+
+        void replace(TimerNode & from, TimerNode & to) override {
+            _wheel.replace(from, to);
+        }
+
+        std::size_t pending() const {
+            return _wheel.size();
+        }
+
+        // advances virtual time by duration and returns the number of timers that fired
+        std::size_t runFor(std::chrono::milliseconds duration) {
+            return runUntil(now() + duration);
+        }
+
+        std::size_t runUntil(std::chrono::milliseconds deadline) {
+            const auto to = static_cast<std::uint64_t>(deadline.count());
+            std::size_t fired = 0;
+            while (_wheel.now() < to) {
+                // one deadline at a time, so that timers scheduled by an expiry fire in order
+                const auto next = _wheel.nextTick();
+                _wheel.advance(next && *next < to ? *next : to, _expired);
+                while (const auto node = TimingWheel::takeFirst(_expired)) {
+                    expire(*node);
+                    ++fired;
+                }
+            }
+            return fired;
+        }
+
+    private:
+        TimingWheel _wheel;
+        details::TimerLink _expired;
+    };
+
+    // Keeps the timers scheduled on it while holding, then on release() arms each of them for its full duration on
+    // the source current at that point, and forwards to that source from then on. Timers can so be armed while a past
+    // is replayed without any of them firing before it is done. Not thread safe while holding.
+    class DeferredTimerSource final : public TimerSource {
+    public:
+        DeferredTimerSource() = default;
+        DeferredTimerSource(const DeferredTimerSource & other) = delete;
+        DeferredTimerSource & operator=(const DeferredTimerSource & other) = delete;
+
+        void schedule(TimerNode & node, std::chrono::milliseconds duration) override {
+            if (!_holding) {
+                _target->schedule(node, duration);
+                return;
+            }
+            // armed on the target by an earlier release
+            if (_target) {
+                _target->cancel(node);
+            }
+            _held[&node] = duration;
+        }
+
+        void cancel(TimerNode & node) override {
+            if (_held.erase(&node) == 0 && _target) {
+                _target->cancel(node);
+            }
+        }
+
+        void replace(TimerNode & from, TimerNode & to) override {
+            if (const auto held = _held.find(&from); held != _held.end()) {
+                const auto duration = held->second;
+                _held.erase(held);
+                _held.emplace(&to, duration);
+            } else if (_target) {
+                _target->replace(from, to);
+            }
+        }
+
+        void hold() {
+            _holding = true;
+        }
+
+        // must not be called while this is the current source
+        void release() {
+            _target = &TimerSource::current();
+            _holding = false;
+            for (const auto & [node, duration] : _held) {
+                _target->schedule(*node, duration);
+            }
+            _held.clear();
+        }
+
+        // timers held until release()
+        std::size_t held() const {
+            return _held.size();
+        }
+
+    private:
+        std::unordered_map<TimerNode *, std::chrono::milliseconds> _held;
+        TimerSource * _target{nullptr};
+        bool _holding{true};
+    };
+
+    inline TimerSource & TimerSource::current() {
+        if (const auto source = threadSlot()) {
+            return *source;
+        }
+        const auto source = slot().load();
+        return source ? *source : TimerService::instance();
+    }
+} // namespace adc
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "FSM.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace adc {
+    // A transition or a no-op recorded by RingTracer. States are the indices into the FSM's list of states, events are
+    // ids handed out per event type by the trace registry.
+    struct TraceRecord {
+        static constexpr std::uint8_t NO_TRANSITION = 0xFF;
+
+        std::uint64_t timestamp; // steady clock, in nanoseconds
+        std::uint32_t fsmId;
+        std::uint8_t from;
+        std::uint8_t to; // NO_TRANSITION when the event was ignored
+        std::uint16_t event;
+    };
+    static_assert(sizeof(TraceRecord) == 16, "trace records are written to disk as is");
+} // namespace adc
+
+namespace adc::details {
+    template <typename T>
+    std::string_view typeName() {
+#if defined(_MSC_VER)
+        const std::string_view name = __FUNCSIG__;
+        const auto begin = name.find("typeName<") + 9;
+        const auto end = name.rfind(">(void)");
+#else
+        const std::string_view name = __PRETTY_FUNCTION__;
+        const auto begin = name.find("T = ") + 4;
+        const auto end = name.find_first_of(";]", begin);
+#endif
+        return name.substr(begin, end - begin);
+    }
+
+    // The records of one thread. Only the owning thread writes, so pushing is a store and a release increment; the
+    // oldest records are overwritten once the ring is full.
+    class TraceRing {
+    public:
+        static constexpr std::size_t CAPACITY = 1 << 14;
+
+        explicit TraceRing(std::uint32_t thread) : _thread(thread), _records(new TraceRecord[CAPACITY]) {
+        }
+
+        void push(const TraceRecord & record) {
+            const auto head = _head.load(std::memory_order_relaxed);
+            _records[head & (CAPACITY - 1)] = record;
+            _head.store(head + 1, std::memory_order_release);
+        }
+
+        // oldest first; records written while copying may be torn, so snapshot while the owner is quiescent
+        std::vector<TraceRecord> snapshot() const {
+            const auto head = _head.load(std::memory_order_acquire);
+            const auto count = std::min<std::uint64_t>(head, CAPACITY);
+            std::vector<TraceRecord> result;
+            result.reserve(count);
+            for (auto index = head - count; index < head; ++index) {
+                result.push_back(_records[index & (CAPACITY - 1)]);
+            }
+            return result;
+        }
+
+        std::uint32_t thread() const {
+            return _thread;
+        }
+
+    private:
+        const std::uint32_t _thread;
+        std::unique_ptr<TraceRecord[]> _records;
+        std::atomic<std::uint64_t> _head{0};
+    };
+
+    // Owns the rings of all threads, which outlive their threads until dumped, and the names of the event ids. The
+    // mutex is only taken once per thread and once per event type.
+    class TraceRegistry {
+    public:
+        static TraceRegistry & instance() {
+            static TraceRegistry registry;
+            return registry;
+        }
+
+        template <typename Event>
+        static std::uint16_t eventId() {
+            static const auto id = instance().addEvent(typeName<Event>());
+            return id;
+        }
+
+        static TraceRing & localRing() {
+            static thread_local const std::shared_ptr<TraceRing> ring = instance().addRing();
+            return *ring;
+        }
+
+        std::uint32_t nextFsmId() {
+            return _fsmIds.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // binary, in native byte order: magic, the event names, then the records of every ring
+        void dump(std::ostream & out) const {
+            std::lock_guard<std::mutex> lock{_mutex};
+            out.write(MAGIC, sizeof(MAGIC));
+            write(out, static_cast<std::uint32_t>(_events.size()));
+            for (const auto & name : _events) {
+                write(out, static_cast<std::uint16_t>(name.size()));
+                out.write(name.data(), static_cast<std::streamsize>(name.size()));
+            }
+            write(out, static_cast<std::uint32_t>(_rings.size()));
+            for (const auto & ring : _rings) {
+                const auto records = ring->snapshot();
+                write(out, ring->thread());
+                write(out, static_cast<std::uint32_t>(records.size()));
+                out.write(
+                    reinterpret_cast<const char *>(records.data()),
+                    static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+            }
+        }
+
+        static constexpr char MAGIC[8] = {'A', 'D', 'C', 'T', 'R', 'C', '0', '1'};
+
+    private:
+        template <typename T>
+        static void write(std::ostream & out, T value) {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        std::uint16_t addEvent(std::string_view name) {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _events.emplace_back(name);
+            return static_cast<std::uint16_t>(_events.size() - 1);
+        }
+
+        std::shared_ptr<TraceRing> addRing() {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _rings.push_back(std::make_shared<TraceRing>(static_cast<std::uint32_t>(_rings.size())));
+            return _rings.back();
+        }
+
+        mutable std::mutex _mutex;
+        std::vector<std::string> _events;
+        std::vector<std::shared_ptr<TraceRing>> _rings;
+        std::atomic<std::uint32_t> _fsmIds{0};
+    };
+} // namespace adc::details
+
+namespace adc {
+    // Tracer policy writing a TraceRecord per transition and per ignored event into the ring of the calling thread.
+    // Each machine gets a process-wide id, which can be replaced by a meaningful one such as the gate number.
+    class RingTracer {
+    public:
+        RingTracer() : _id(details::TraceRegistry::instance().nextFsmId()) {
+        }
+
+        std::uint32_t id() const {
+            return _id;
+        }
+
+        void setId(std::uint32_t id) {
+            _id = id;
+        }
+
+        template <typename Event>
+        void onEvent(std::size_t state, const Event & event) {
+            _event = eventId(event);
+        }
+
+        void onExit(std::size_t state) {
+            _from = static_cast<std::uint8_t>(state);
+        }
+
+        void onEntry(std::size_t state) {
+            write(_from, static_cast<std::uint8_t>(state));
+        }
+
+        void onNoOp(std::size_t state) {
+            write(static_cast<std::uint8_t>(state), TraceRecord::NO_TRANSITION);
+        }
+
+    private:
+        template <typename Event>
+        static std::uint16_t eventId(const Event & event) {
+            if constexpr (details::is_variant<Event>::value) {
+                return std::visit(
+                    [](const auto & alternative) {
+                        return eventId(alternative);
+                    },
+                    event);
+            } else {
+                return details::TraceRegistry::eventId<Event>();
+            }
+        }
+
+        void write(std::uint8_t from, std::uint8_t to) const {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            details::TraceRegistry::localRing().push(TraceRecord{
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()), _id,
+                from, to, _event});
+        }
+
+        std::uint32_t _id;
+        std::uint16_t _event{0};
+        std::uint8_t _from{0};
+    };
+
+    // writes the rings of all threads; see TraceRing::snapshot
+    inline void dumpTrace(std::ostream & out) {
+        details::TraceRegistry::instance().dump(out);
+    }
+
+    // Prints the records of a dump one per line, merged across threads in timestamp order. States are printed by
+    // index unless stateNames names them. Returns false if the input is not a complete trace.
+    inline bool decodeTrace(std::istream & in, std::ostream & out, const std::vector<std::string> & stateNames = {}) {
+        const auto read = [&](auto & value) {
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+        };
+        const auto & expected = details::TraceRegistry::MAGIC;
+        char magic[sizeof(expected)];
+        if (!in.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(expected))) {
+            return false;
+        }
+        std::uint32_t count = 0;
+        if (!read(count)) {
+            return false;
+        }
+        std::vector<std::string> events(count);
+        for (auto & name : events) {
+            std::uint16_t size = 0;
+            if (!read(size)) {
+                return false;
+            }
+            name.resize(size);
+            if (!in.read(name.data(), size)) {
+                return false;
+            }
+        }
+        if (!read(count)) {
+            return false;
+        }
+        std::vector<std::pair<std::uint32_t, TraceRecord>> records;
+        for (std::uint32_t ring = 0; ring < count; ++ring) {
+            std::uint32_t thread = 0;
+            std::uint32_t size = 0;
+            if (!read(thread) || !read(size)) {
+                return false;
+            }
+            for (std::uint32_t i = 0; i < size; ++i) {
+                TraceRecord record{};
+                if (!read(record)) {
+                    return false;
+                }
+                records.emplace_back(thread, record);
+            }
+        }
+        std::stable_sort(records.begin(), records.end(), [](const auto & lhs, const auto & rhs) {
+            return lhs.second.timestamp < rhs.second.timestamp;
+        });
+
+        const auto state = [&](std::uint8_t index) {
+            return index < stateNames.size() ? stateNames[index] : std::to_string(index);
+        };
+        for (const auto & [thread, record] : records) {
+            out << record.timestamp << " thread " << thread << " fsm " << record.fsmId << ": ";
+            const auto & event = record.event < events.size() ? events[record.event] : std::to_string(record.event);
+            if (record.to == TraceRecord::NO_TRANSITION) {
+                out << state(record.from) << " ignored " << event << '\n';
+            } else {
+                out << state(record.from) << " -> " << state(record.to) << " on " << event << '\n';
+            }
+        }
+        return true;
+    }
+} // namespace adc
@@ -0,0 +1,126 @@
+#include "EventMailbox.h"
+#include "FSMExternalTransitions.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using Mailbox = adc::TEventMailbox<CardPresented, TransactionDeclined, TransactionSuccess, PersonPassed, Timeout>;
+
+TEST(EventMailbox, TestDrainInOrder) {
+    fsm_external_transitions::FSM fsm;
+    Mailbox mailbox{8};
+    EXPECT_TRUE(mailbox.empty());
+    EXPECT_TRUE(mailbox.post(CardPresented{"1111"}));
+    EXPECT_TRUE(mailbox.post(TransactionSuccess{5, 25}));
+    EXPECT_TRUE(mailbox.post(PersonPassed{}));
+    EXPECT_FALSE(mailbox.empty());
+
+    EXPECT_EQ(3u, mailbox.drain(fsm));
+    EXPECT_TRUE(mailbox.empty());
+    EXPECT_EQ(eState::Locked, fsm.getState());
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+}
+
+TEST(EventMailbox, TestFullMailboxRejects) {
+    fsm_external_transitions::FSM fsm;
+    Mailbox mailbox{4};
+    EXPECT_EQ(4u, mailbox.capacity());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(mailbox.post(Timeout{}));
+    }
+    EXPECT_FALSE(mailbox.post(Timeout{}));
+
+    EXPECT_EQ(2u, mailbox.drain(fsm, 2));
+    EXPECT_TRUE(mailbox.post(CardPresented{"1111"}));
+    EXPECT_EQ(3u, mailbox.drain(fsm));
+    EXPECT_EQ(eState::PaymentProcessing, fsm.getState());
+}
+
+namespace {
+    struct Counter {
+        void process(Timeout) {
+            ++timeouts;
+        }
+        void process(PersonPassed) {
+            ++passed;
+        }
+        template <typename Event>
+        void process(Event) {
+        }
+
+        std::size_t timeouts{0};
+        std::size_t passed{0};
+    };
+} // namespace
+
+TEST(EventMailbox, TestMultipleProducers) {
+    constexpr std::size_t PRODUCERS = 4;
+    constexpr std::size_t EVENTS = 10000;
+    Mailbox mailbox{64};
+    Counter counter;
+
+    std::vector<std::thread> producers;
+    for (std::size_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (std::size_t i = 0; i < EVENTS; ++i) {
+                while (!(p % 2 ? mailbox.post(Timeout{}) : mailbox.post(PersonPassed{}))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::size_t processed = 0;
+    while (processed < PRODUCERS * EVENTS) {
+        processed += mailbox.drain(counter);
+    }
+    for (auto & producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(PRODUCERS * EVENTS / 2, counter.timeouts);
+    EXPECT_EQ(PRODUCERS * EVENTS / 2, counter.passed);
+    EXPECT_TRUE(mailbox.empty());
+}
+
+namespace {
+    // copying throws after the given number of copies
+    struct Fragile {
+        Fragile() = default;
+        Fragile(Fragile &&) noexcept = default;
+        Fragile(const Fragile & other) : copies(other.copies + 1) {
+            if (copies > 1) {
+                throw std::runtime_error("copy");
+            }
+        }
+
+        int copies{0};
+    };
+
+    struct FragileCounter {
+        void process(Fragile event) {
+            copies.push_back(event.copies);
+        }
+        void process(Timeout) {
+            ++timeouts;
+        }
+
+        std::vector<int> copies;
+        std::size_t timeouts{0};
+    };
+} // namespace
+
+TEST(EventMailbox, TestThrowingEventClaimsNoSlot) {
+    adc::TEventMailbox<Fragile, Timeout> mailbox{4};
+    FragileCounter counter;
+    const Fragile original;
+    EXPECT_TRUE(mailbox.post(original));
+    const Fragile copy{original};
+    EXPECT_THROW(mailbox.post(copy), std::runtime_error);
+    EXPECT_TRUE(mailbox.post(Timeout{}));
+
+    EXPECT_EQ(2u, mailbox.drain(counter));
+    EXPECT_EQ(std::vector<int>{1}, counter.copies);
+    EXPECT_EQ(1u, counter.timeouts);
+    EXPECT_TRUE(mailbox.empty());
+}
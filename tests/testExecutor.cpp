@@ -0,0 +1,161 @@
+#include "Executor.h"
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Sequence {
+        std::size_t producer;
+        std::size_t value;
+    };
+
+    // records the order in which a machine saw the events of each producer
+    class Recording {
+    public:
+        explicit Recording(std::reference_wrapper<std::vector<std::vector<std::size_t>>> log) : _log(log) {
+        }
+
+        auto process(Sequence event) {
+            _log.get()[event.producer].push_back(event.value);
+            return adc::transitionTo<Recording>(_log);
+        }
+
+        int getState() const {
+            return 0;
+        }
+
+    private:
+        std::reference_wrapper<std::vector<std::vector<std::size_t>>> _log;
+    };
+
+    using RecordingFSM = adc::TFSMStateTransitions<Recording>;
+    using RecordingQueue = adc::TSerialQueue<RecordingFSM, Sequence>;
+} // namespace
+
+TEST(WorkStealingDeque, TestOwnerIsLifoThiefIsFifo) {
+    adc::details::TWorkStealingDeque<int> deque{2};
+    int items[5] = {0, 1, 2, 3, 4};
+    for (auto & item : items) {
+        deque.push(&item);
+    }
+    EXPECT_EQ(&items[0], deque.steal());
+    EXPECT_EQ(&items[4], deque.pop());
+    EXPECT_EQ(&items[1], deque.steal());
+    EXPECT_EQ(&items[3], deque.pop());
+    EXPECT_EQ(&items[2], deque.pop());
+    EXPECT_EQ(nullptr, deque.pop());
+    EXPECT_EQ(nullptr, deque.steal());
+}
+
+TEST(WorkStealingDeque, TestEveryItemIsTakenOnce) {
+    constexpr std::size_t ITEMS = 100000;
+    constexpr std::size_t THIEVES = 3;
+    adc::details::TWorkStealingDeque<std::size_t> deque;
+    std::vector<std::size_t> items(ITEMS);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (std::size_t i = 0; i < THIEVES; ++i) {
+        thieves.emplace_back([&] {
+            while (!done) {
+                if (auto * item = deque.steal()) {
+                    ++taken[*item];
+                }
+            }
+        });
+    }
+    for (std::size_t i = 0; i < ITEMS; ++i) {
+        items[i] = i;
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            if (auto * item = deque.pop()) {
+                ++taken[*item];
+            }
+        }
+    }
+    while (auto * item = deque.pop()) {
+        ++taken[*item];
+    }
+    done = true;
+    for (auto & thief : thieves) {
+        thief.join();
+    }
+    for (std::size_t i = 0; i < ITEMS; ++i) {
+        EXPECT_EQ(1, taken[i]) << i;
+    }
+}
+
+TEST(Executor, TestPerMachineOrder) {
+    constexpr std::size_t MACHINES = 64;
+    constexpr std::size_t PRODUCERS = 3;
+    constexpr std::size_t EVENTS = 2000;
+    adc::Executor executor{4};
+
+    std::vector<std::vector<std::vector<std::size_t>>> logs(
+        MACHINES, std::vector<std::vector<std::size_t>>(PRODUCERS));
+    std::vector<std::unique_ptr<RecordingFSM>> machines;
+    std::vector<std::unique_ptr<RecordingQueue>> queues;
+    for (auto & log : logs) {
+        machines.push_back(std::make_unique<RecordingFSM>(Recording{std::ref(log)}));
+        queues.push_back(std::make_unique<RecordingQueue>(executor, *machines.back(), 16));
+    }
+
+    std::vector<std::thread> producers;
+    for (std::size_t producer = 0; producer < PRODUCERS; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (std::size_t value = 0; value < EVENTS; ++value) {
+                // skewed: machine 0 gets half of the events
+                auto & queue = *queues[value % 2 ? 0 : (value / 2) % MACHINES];
+                while (!queue.post(Sequence{producer, value})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto & producer : producers) {
+        producer.join();
+    }
+    executor.waitIdle();
+
+    std::size_t total = 0;
+    for (auto & log : logs) {
+        for (auto & values : log) {
+            EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+            total += values.size();
+        }
+    }
+    EXPECT_EQ(PRODUCERS * EVENTS, total);
+}
+
+TEST(Executor, TestTurnstiles) {
+    constexpr std::size_t GATES = 100;
+    using Queue = adc::TSerialQueue<fsm_external_transitions::FSM, CardPresented, TransactionSuccess, PersonPassed>;
+    adc::Executor executor{3};
+    std::vector<std::unique_ptr<fsm_external_transitions::FSM>> gates;
+    std::vector<std::unique_ptr<Queue>> queues;
+    for (std::size_t id = 0; id < GATES; ++id) {
+        gates.push_back(std::make_unique<fsm_external_transitions::FSM>());
+        queues.push_back(std::make_unique<Queue>(executor, *gates.back()));
+    }
+    for (auto & queue : queues) {
+        EXPECT_TRUE(queue->post(CardPresented{"1111"}));
+        EXPECT_TRUE(queue->post(TransactionSuccess{5, 25}));
+    }
+    executor.waitIdle();
+    for (auto & gate : gates) {
+        EXPECT_EQ(eState::PaymentSuccess, gate->getState());
+    }
+    for (auto & queue : queues) {
+        EXPECT_TRUE(queue->post(PersonPassed{}));
+    }
+    executor.waitIdle();
+    for (auto & gate : gates) {
+        EXPECT_EQ(eState::Locked, gate->getState());
+        EXPECT_EQ(gate->getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+    }
+}
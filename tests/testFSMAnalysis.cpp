@@ -0,0 +1,152 @@
+#include "FSMAnalysis.h"
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+
+#include <array>
+#include <gtest/gtest.h>
+
+namespace {
+    struct Start {};
+    struct Stop {};
+    struct Service {};
+
+    class Running;
+    class Servicing;
+
+    class Idle {
+    public:
+        int getState() const {
+            return 0;
+        }
+
+        auto process(Start) {
+            return adc::transitionTo<Running>();
+        }
+
+        auto process(Service) {
+            return adc::transitionTo<Servicing>();
+        }
+
+        template <typename Event>
+        adc::NoTransition process(Event) {
+            return {};
+        }
+    };
+
+    class Running {
+    public:
+        int getState() const {
+            return 1;
+        }
+
+        auto process(Stop) {
+            return adc::transitionTo<Idle>();
+        }
+
+        template <typename Event>
+        adc::NoTransition process(Event) {
+            return {};
+        }
+    };
+
+    // only entered through Service
+    class Servicing {
+    public:
+        int getState() const {
+            return 2;
+        }
+
+        auto process(Stop) {
+            return adc::transitionTo<Idle>();
+        }
+
+        template <typename Event>
+        adc::NoTransition process(Event) {
+            return {};
+        }
+
+    private:
+        std::array<char, 256> _log{};
+    };
+
+    // nothing leads here
+    class Retired {
+    public:
+        int getState() const {
+            return 3;
+        }
+
+        template <typename Event>
+        adc::NoTransition process(Event) {
+            return {};
+        }
+
+    private:
+        std::array<char, 512> _history{};
+    };
+
+    // a machine which is never sent Service
+    using Analysis = adc::TStateTransitionsAnalysis<Idle, std::tuple<Start, Stop>, Idle, Running, Servicing, Retired>;
+} // namespace
+
+TEST(FSMAnalysis, TestUnreachableStatesArePruned) {
+    static_assert(Analysis::STATES == 4);
+    static_assert(Analysis::EVENTS == 2);
+    static_assert(Analysis::REACHABLE_STATES == 2);
+    static_assert(Analysis::isReachable<Running>());
+    static_assert(!Analysis::isReachable<Servicing>());
+    static_assert(!Analysis::isReachable<Retired>());
+    static_assert(std::is_same_v<Analysis::ReachableStates, std::tuple<Idle, Running>>);
+    static_assert(
+        std::is_same_v<Analysis::TPruned<adc::TFSMStateTransitions>, adc::TFSMStateTransitions<Idle, Running>>);
+
+    // Start and Stop in Idle, Running and Servicing; Retired handles nothing
+    EXPECT_EQ(3U, Analysis::HANDLERS);
+    EXPECT_EQ(2U, Analysis::LIVE_HANDLERS);
+    EXPECT_EQ(2U, Analysis::TRANSITIONS);
+    EXPECT_LT(Analysis::PRUNED_STATE_BYTES, Analysis::STATE_BYTES);
+    EXPECT_EQ(Analysis::PRUNED_TABLE_BYTES * 5, Analysis::TABLE_BYTES * 3);
+
+    Analysis::TPruned<adc::TFSMStateTransitions> fsm{Idle{}};
+    fsm.process(Start{});
+    EXPECT_EQ(1, fsm.getState());
+    fsm.process(Stop{});
+    EXPECT_EQ(0, fsm.getState());
+}
+
+TEST(FSMAnalysis, TestEventsDecideReachability) {
+    using WithService =
+        adc::TStateTransitionsAnalysis<Idle, std::variant<Start, Stop, Service>, Idle, Running, Servicing, Retired>;
+    static_assert(WithService::REACHABLE_STATES == 3);
+    static_assert(WithService::isReachable<Servicing>());
+    static_assert(!WithService::isReachable<Retired>());
+    EXPECT_EQ(4U, WithService::TRANSITIONS);
+}
+
+TEST(FSMAnalysis, TestTurnstileStateTransitions) {
+    using namespace fsm_state_transitions;
+    using TurnstileAnalysis = adc::TStateTransitionsAnalysis<Locked, AnyEvent, Locked, PaymentProcessing,
+        PaymentFailed, PaymentSuccess, Unlocked>;
+    static_assert(TurnstileAnalysis::REACHABLE_STATES == 5);
+    // of the 25 (state, event) pairs
+    EXPECT_EQ(8U, TurnstileAnalysis::HANDLERS);
+    EXPECT_EQ(8U, TurnstileAnalysis::LIVE_HANDLERS);
+    EXPECT_EQ(8U, TurnstileAnalysis::TRANSITIONS);
+    EXPECT_FALSE(TurnstileAnalysis::EDGES[0][1].handled);
+    EXPECT_TRUE(TurnstileAnalysis::EDGES[0][0].handled);
+}
+
+TEST(FSMAnalysis, TestTurnstileExternalTransitions) {
+    using namespace fsm_external_transitions;
+    using TurnstileAnalysis = adc::TExternalTransitionsAnalysis<TransitionTable, Locked, AnyEvent, Locked,
+        PaymentProcessing, PaymentFailed, PaymentSuccess, Unlocked>;
+    static_assert(TurnstileAnalysis::REACHABLE_STATES == 5);
+    EXPECT_EQ(8U, TurnstileAnalysis::LIVE_HANDLERS);
+    EXPECT_EQ(8U, TurnstileAnalysis::TRANSITIONS);
+
+    // from Locked, only CardPresented leads anywhere: to PaymentProcessing
+    for (std::size_t event = 1; event < TurnstileAnalysis::EVENTS; ++event) {
+        EXPECT_EQ(0U, TurnstileAnalysis::EDGES[0][event].targets);
+    }
+    EXPECT_EQ(1U << 1, TurnstileAnalysis::EDGES[0][0].targets);
+}
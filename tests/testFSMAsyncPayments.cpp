@@ -0,0 +1,134 @@
+#include "FSMAsyncPayments.h"
+
+#if ADC_COROUTINES
+
+#include <deque>
+#include <gtest/gtest.h>
+#include <optional>
+
+using namespace std::chrono_literals;
+using FSM = fsm_async_payments::FSM;
+
+// The virtual clock is not thread safe and the states of several gates arm timers on it, so executors get one worker.
+namespace {
+    GatewayStub::Reply decline(std::string_view gateway, const Pan & card, int amount) {
+        return TransactionDeclined{"No Funds"};
+    }
+} // namespace
+
+TEST(FSMAsyncPayments, TestApprovedByGateway) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    GatewayStub gateway;
+    adc::Executor executor{1};
+
+    FSM fsm{gateway, executor};
+    EXPECT_TRUE(fsm.process(CardPresented{"4000123412341234"}));
+    executor.waitIdle();
+    EXPECT_EQ(eState::PaymentProcessing, fsm.getState());
+    EXPECT_EQ(1U, gateway.inFlight());
+    EXPECT_EQ(1U, fsm.framePool().live());
+
+    // the answer resumes the coroutine through the FSM's queue
+    EXPECT_EQ(1U, gateway.respond());
+    executor.waitIdle();
+    EXPECT_EQ(eState::PaymentSuccess, fsm.getState());
+    EXPECT_EQ("Fare: " + std::to_string(getFare()), fsm.getPOS().getSecondRow());
+    EXPECT_EQ(0U, fsm.framePool().live());
+}
+
+TEST(FSMAsyncPayments, TestDeclinedByGateway) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    GatewayStub gateway{&decline};
+    adc::Executor executor{1};
+
+    FSM fsm{gateway, executor};
+    EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    executor.waitIdle();
+    gateway.respond();
+    executor.waitIdle();
+    EXPECT_EQ(eState::PaymentFailed, fsm.getState());
+    EXPECT_EQ("No Funds", fsm.getPOS().getSecondRow());
+}
+
+TEST(FSMAsyncPayments, TestLateReplyAfterRetry) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    GatewayStub gateway;
+    adc::Executor executor{1};
+
+    FSM fsm{gateway, executor};
+    EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    executor.waitIdle();
+    clock.runFor(2s);
+    executor.waitIdle();
+    EXPECT_EQ(2U, gateway.inFlight());
+    EXPECT_EQ(2U, fsm.framePool().live());
+
+    // the first gateway answers late, and the second gateway's answer finds the payment done
+    EXPECT_EQ(2U, gateway.respond());
+    executor.waitIdle();
+    EXPECT_EQ(eState::PaymentSuccess, fsm.getState());
+    EXPECT_EQ(0U, fsm.framePool().live());
+}
+
+TEST(FSMAsyncPayments, TestUnansweredCallsCancelledWithFSM) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    GatewayStub gateway;
+    adc::Executor executor{1};
+
+    std::optional<FSM> fsm{std::in_place, gateway, executor};
+    FSM other{gateway, executor};
+    EXPECT_TRUE(fsm->process(CardPresented{"1111"}));
+    EXPECT_TRUE(other.process(CardPresented{"2222"}));
+    executor.waitIdle();
+    clock.runFor(2s);
+    executor.waitIdle();
+    EXPECT_EQ(4U, gateway.inFlight());
+
+    // the frames awaiting the gateway go back to the pool before it is destroyed, leaving the other gate's calls
+    fsm.reset();
+    EXPECT_EQ(2U, gateway.inFlight());
+    EXPECT_EQ(2U, gateway.respond());
+    executor.waitIdle();
+    EXPECT_EQ(eState::PaymentSuccess, other.getState());
+    EXPECT_EQ(0U, other.framePool().live());
+}
+
+TEST(FSMAsyncPayments, TestThousandsInFlight) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    GatewayStub gateway;
+    adc::Executor executor{1};
+
+    std::deque<FSM> gates;
+    for (int gateId = 0; gateId < 5000; ++gateId) {
+        EXPECT_TRUE(gates.emplace_back(gateway, executor).process(CardPresented{std::to_string(gateId)}));
+    }
+    executor.waitIdle();
+    EXPECT_EQ(5000U, gateway.inFlight());
+
+    EXPECT_EQ(5000U, gateway.respond());
+    executor.waitIdle();
+    for (auto & fsm : gates) {
+        EXPECT_EQ(eState::PaymentSuccess, fsm.getState());
+        EXPECT_TRUE(fsm.process(PersonPassed{}));
+    }
+    executor.waitIdle();
+
+    // the frames of the first payments are reused by the next ones
+    for (auto & fsm : gates) {
+        EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    }
+    executor.waitIdle();
+    for (auto & fsm : gates) {
+        EXPECT_EQ(1U, fsm.framePool().live());
+    }
+    gateway.respond();
+    executor.waitIdle();
+    EXPECT_EQ(0U, gateway.inFlight());
+}
+
+#endif
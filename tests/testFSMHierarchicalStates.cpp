@@ -0,0 +1,208 @@
+#include "FSM.h"
+#include "FSMFleet.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+    enum class eGate { Idle, Armed, Jammed, Maintenance };
+
+    struct Coin {};
+    struct Push {};
+    struct Fault {};
+    struct Repaired {};
+    struct Reset {};
+    struct Tick {};
+
+    class Idle;
+    class Armed;
+    class Jammed;
+    class Maintenance;
+
+    // Powered
+    // |- InService: Idle, Armed
+    // `- OutOfService: Jammed, Maintenance
+    class Powered {
+    public:
+        auto process(Reset) {
+            return adc::transitionTo<Idle>();
+        }
+
+        // the root opts in to ignoring whatever no state handles
+        template <typename Event>
+        adc::NoTransition process(Event) {
+            return {};
+        }
+    };
+
+    class InService : public Powered {
+    public:
+        using Parent = Powered;
+
+        auto process(Fault) {
+            return adc::transitionTo<Jammed>();
+        }
+
+        auto process(Tick) {
+            return adc::transitionTo<Idle>();
+        }
+    };
+
+    class OutOfService : public Powered {
+    public:
+        using Parent = Powered;
+
+        auto process(Repaired) {
+            return adc::transitionTo<Idle>();
+        }
+    };
+
+    class Idle : public InService {
+    public:
+        using Parent = InService;
+
+        eGate getState() const {
+            return eGate::Idle;
+        }
+
+        auto process(Coin) {
+            return adc::transitionTo<Armed>();
+        }
+    };
+
+    class Armed : public InService {
+    public:
+        using Parent = InService;
+
+        eGate getState() const {
+            return eGate::Armed;
+        }
+
+        auto process(Push) {
+            return adc::transitionTo<Idle>();
+        }
+
+        // handled here, so that the shared timeout of InService does not apply
+        std::optional<adc::TTransition<Idle>> process(Tick) {
+            return std::nullopt;
+        }
+    };
+
+    class Jammed : public OutOfService {
+    public:
+        using Parent = OutOfService;
+
+        eGate getState() const {
+            return eGate::Jammed;
+        }
+
+        auto process(Push) {
+            return adc::transitionTo<Maintenance>();
+        }
+    };
+
+    // handles nothing itself
+    class Maintenance : public OutOfService {
+    public:
+        using Parent = OutOfService;
+
+        eGate getState() const {
+            return eGate::Maintenance;
+        }
+    };
+
+    using FSM = adc::TFSMStateTransitions<Idle, Armed, Jammed, Maintenance>;
+
+    template <typename State, typename Event>
+    using HandledBy =
+        typename adc::details::handling_state<adc::details::StatesHandlingTransitions, State, Event>::type;
+
+    static_assert(std::is_same_v<HandledBy<Armed, Push>, Armed>);
+    static_assert(std::is_same_v<HandledBy<Armed, Tick>, Armed>);
+    static_assert(std::is_same_v<HandledBy<Idle, Tick>, InService>);
+    static_assert(std::is_same_v<HandledBy<Maintenance, Reset>, Powered>);
+    // no level but the root's catch-all has a handler for Coin, which opts in to ignoring it
+    static_assert(!adc::details::has_handler<adc::details::StatesHandlingTransitions, OutOfService, Coin>::value);
+    static_assert(std::is_void_v<HandledBy<Jammed, Coin>>);
+
+    struct TransitionTable {
+        template <typename State, typename Event>
+        auto operator()(State & state, Event event) -> decltype(state.process(event)) {
+            return state.process(event);
+        }
+    };
+} // namespace
+
+TEST(FSMHierarchicalStates, TestLeafHandlesItsOwnEvents) {
+    FSM fsm{Idle{}};
+    fsm.process(Coin{});
+    EXPECT_EQ(eGate::Armed, fsm.getState());
+    fsm.process(Push{});
+    EXPECT_EQ(eGate::Idle, fsm.getState());
+}
+
+TEST(FSMHierarchicalStates, TestEventsBubbleToParent) {
+    FSM fsm{Idle{}};
+    fsm.process(Fault{});
+    EXPECT_EQ(eGate::Jammed, fsm.getState());
+
+    FSM armed{Armed{}};
+    armed.process(Fault{});
+    EXPECT_EQ(eGate::Jammed, armed.getState());
+    armed.process(Repaired{});
+    EXPECT_EQ(eGate::Idle, armed.getState());
+}
+
+TEST(FSMHierarchicalStates, TestEventsBubbleToGrandparent) {
+    FSM fsm{Jammed{}};
+    fsm.process(Push{});
+    EXPECT_EQ(eGate::Maintenance, fsm.getState());
+    fsm.process(Reset{});
+    EXPECT_EQ(eGate::Idle, fsm.getState());
+    fsm.process(Coin{});
+    fsm.process(Reset{});
+    EXPECT_EQ(eGate::Idle, fsm.getState());
+}
+
+TEST(FSMHierarchicalStates, TestLeafOverridesParent) {
+    FSM fsm{Armed{}};
+    fsm.process(Tick{});
+    EXPECT_EQ(eGate::Armed, fsm.getState());
+}
+
+TEST(FSMHierarchicalStates, TestUnhandledEventsAreNoOps) {
+    FSM fsm{Jammed{}};
+    fsm.process(Coin{});
+    fsm.process(Tick{});
+    EXPECT_EQ(eGate::Jammed, fsm.getState());
+}
+
+TEST(FSMHierarchicalStates, TestIsIn) {
+    FSM fsm{Idle{}};
+    EXPECT_TRUE(fsm.isIn<Idle>());
+    EXPECT_TRUE(fsm.isIn<InService>());
+    EXPECT_TRUE(fsm.isIn<Powered>());
+    EXPECT_FALSE(fsm.isIn<OutOfService>());
+
+    fsm.process(Fault{});
+    EXPECT_FALSE(fsm.isIn<InService>());
+    EXPECT_TRUE(fsm.isIn<OutOfService>());
+    EXPECT_TRUE(fsm.isIn<Powered>());
+}
+
+TEST(FSMHierarchicalStates, TestFleet) {
+    adc::TFSMFleet<TransitionTable, Idle, Armed, Jammed, Maintenance> fleet{
+        TransitionTable{}, 2, [](std::size_t id) {
+            return adc::transitionTo<Idle>();
+        }};
+    fleet.process(0, Coin{});
+    fleet.process(1, Fault{});
+    EXPECT_EQ(eGate::Armed, fleet.getState(0));
+    EXPECT_EQ(eGate::Jammed, fleet.getState(1));
+    EXPECT_TRUE(fleet.isIn<InService>(0));
+    EXPECT_TRUE(fleet.isIn<OutOfService>(1));
+
+    EXPECT_EQ(0U, fleet.processAll(Tick{}));
+    EXPECT_EQ(eGate::Armed, fleet.getState(0));
+    EXPECT_EQ(2U, fleet.processAll(Reset{}));
+    EXPECT_EQ(eGate::Idle, fleet.getState(1));
+}
@@ -0,0 +1,152 @@
+#include "FSM.h"
+#include "FSMFleet.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+    struct Counters {
+        int constructions{0};
+        int moves{0};
+    };
+
+    struct Next {};
+    struct Back {};
+
+    class Second;
+
+    class First {
+    public:
+        explicit First(Counters & counters) : _counters(counters) {
+            ++_counters.get().constructions;
+        }
+        First(First && other) noexcept : _counters(other._counters) {
+            ++_counters.get().moves;
+        }
+        First & operator=(First && other) noexcept {
+            _counters = other._counters;
+            ++_counters.get().moves;
+            return *this;
+        }
+
+        int getState() const {
+            return 1;
+        }
+
+        auto process(Next) {
+            return adc::transitionTo<Second>(std::ref(_counters.get()));
+        }
+
+        template <typename Event>
+        std::optional<std::variant<First, Second>> process(Event);
+
+    private:
+        std::reference_wrapper<Counters> _counters;
+    };
+
+    class Second {
+    public:
+        explicit Second(Counters & counters) : _counters(counters) {
+            ++_counters.get().constructions;
+        }
+        Second(Second && other) noexcept : _counters(other._counters) {
+            ++_counters.get().moves;
+        }
+        Second & operator=(Second && other) noexcept {
+            _counters = other._counters;
+            ++_counters.get().moves;
+            return *this;
+        }
+
+        int getState() const {
+            return 2;
+        }
+
+        // legacy handler building the whole target state
+        std::optional<std::variant<First, Second>> process(Back) {
+            return First{_counters.get()};
+        }
+
+        template <typename Event>
+        std::optional<std::variant<First, Second>> process(Event) {
+            return std::nullopt;
+        }
+
+    private:
+        std::reference_wrapper<Counters> _counters;
+    };
+
+    template <typename Event>
+    std::optional<std::variant<First, Second>> First::process(Event) {
+        return std::nullopt;
+    }
+} // namespace
+
+TEST(FSMInPlaceTransitions, TestTransitionIsEmplaced) {
+    Counters counters;
+    adc::TFSMStateTransitions<First, Second> fsm{std::in_place_type<First>, counters};
+    EXPECT_EQ(1, counters.constructions);
+    EXPECT_EQ(0, counters.moves);
+
+    fsm.process(Next{});
+    EXPECT_EQ(2, fsm.getState());
+    EXPECT_EQ(2, counters.constructions);
+    EXPECT_EQ(0, counters.moves);
+}
+
+TEST(FSMInPlaceTransitions, TestOptionalHandlersStillWork) {
+    Counters counters;
+    adc::TFSMStateTransitions<First, Second> fsm{std::in_place_type<First>, counters};
+    fsm.process(Next{});
+    fsm.process(Back{});
+    EXPECT_EQ(1, fsm.getState());
+    EXPECT_EQ(3, counters.constructions);
+    EXPECT_GE(counters.moves, 1);
+
+    const auto moves = counters.moves;
+    fsm.process(Back{});
+    EXPECT_EQ(1, fsm.getState());
+    EXPECT_EQ(moves, counters.moves);
+}
+
+namespace {
+    struct Fail {};
+
+    class Broken {
+    public:
+        Broken() {
+            throw std::runtime_error("cannot enter");
+        }
+
+        int getState() const {
+            return 3;
+        }
+    };
+
+    class Working {
+    public:
+        int getState() const {
+            return 4;
+        }
+    };
+
+    struct ThrowingTransitions {
+        auto operator()(Working &, Fail) {
+            return adc::transitionTo<Broken>();
+        }
+
+        template <typename State, typename Event>
+        adc::NoTransition operator()(State &, Event) {
+            return {};
+        }
+    };
+} // namespace
+
+TEST(FSMInPlaceTransitions, TestThrowingTransitionLeavesFleetMachineWithoutState) {
+    adc::TFSMFleet<ThrowingTransitions, Working, Broken> fleet{ThrowingTransitions{}, 2, [](std::size_t) {
+                                                                   return adc::transitionTo<Working>();
+                                                               }};
+    EXPECT_THROW(fleet.process(0, Fail{}), std::runtime_error);
+    EXPECT_THROW(fleet.getState(0), std::bad_variant_access);
+    EXPECT_EQ(4, fleet.getState(1));
+}
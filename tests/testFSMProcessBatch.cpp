@@ -0,0 +1,46 @@
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+template <typename FSM>
+class FSMProcessBatch : public ::testing::Test {};
+
+using Implementations = ::testing::Types<fsm_state_transitions::FSM, fsm_external_transitions::FSM>;
+TYPED_TEST_SUITE(FSMProcessBatch, Implementations);
+
+TYPED_TEST(FSMProcessBatch, TestMixedEvents) {
+    TypeParam fsm;
+    std::vector<AnyEvent> events{CardPresented{"1111"}, Timeout{}, TransactionSuccess{5, 25}, Timeout{}, PersonPassed{}};
+
+    // the retry on Timeout stays in PaymentProcessing and does not count
+    EXPECT_EQ(4u, fsm.processBatch(events));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway2", "1111", getFare()));
+}
+
+TYPED_TEST(FSMProcessBatch, TestNoOpEvents) {
+    TypeParam fsm;
+    const std::vector<AnyEvent> events{Timeout{}, PersonPassed{}, TransactionDeclined{"Insufficient Funds"}};
+
+    EXPECT_EQ(0u, fsm.processBatch(events));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+}
+
+TYPED_TEST(FSMProcessBatch, TestSingleEventType) {
+    TypeParam fsm;
+    fsm.process(CardPresented{"1111"});
+    const std::array<Timeout, 4> timeouts{};
+
+    EXPECT_EQ(2u, fsm.processBatch(timeouts));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+}
+
+TYPED_TEST(FSMProcessBatch, TestProcessVariant) {
+    TypeParam fsm;
+    fsm.process(AnyEvent{CardPresented{"1111"}}).process(AnyEvent{TransactionDeclined{"Insufficient Funds"}});
+
+    EXPECT_EQ(eState::PaymentFailed, fsm.getState());
+    EXPECT_EQ("Insufficient Funds", fsm.getPOS().getSecondRow());
+}
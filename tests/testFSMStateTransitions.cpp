@@ -1,5 +1,5 @@
-#include "ConditionalStream.h"
 #include "FSMStateTransitions.h"
+#include "Logging.h"
 
 #include <gtest/gtest.h>
 using FSM = fsm_state_transitions::FSM;
@@ -21,7 +21,7 @@ TEST(FSMStateTransitions, TestInitialState) {
 
 TEST(FSMStateTransitions, TestPaymentProcessing) {
     FSM fsm;
-    fsm.process(CardPresented{"A"});
+    fsm.process(CardPresented{"1111"});
     logFSM(fsm);
 
     // state transition
@@ -35,12 +35,21 @@ TEST(FSMStateTransitions, TestPaymentProcessing) {
     EXPECT_EQ("", fsm.getPOS().getThirdRow());
 
     // Actions
-    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "A", getFare()));
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+}
+
+TEST(FSMStateTransitions, TestUnreadableCardIsIgnored) {
+    FSM fsm;
+    for (const auto * card : {"", "4000 1234", "400A", "12345678901234567890"}) {
+        fsm.process(CardPresented{card});
+        EXPECT_EQ(eState::Locked, fsm.getState()) << card;
+    }
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
 }
 
 TEST(FSMStateTransitions, TestPaymentFailed) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionDeclined{"Insufficient Funds"});
+    fsm.process(CardPresented{"1111"}).process(TransactionDeclined{"Insufficient Funds"});
     logFSM(fsm);
 
     // state transition
@@ -54,12 +63,12 @@ TEST(FSMStateTransitions, TestPaymentFailed) {
     EXPECT_EQ("", fsm.getPOS().getThirdRow());
 
     // Actions
-    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "A", getFare()));
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
 }
 
 TEST(FSMStateTransitions, TestTimeoutOnPaymentProcessing) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(Timeout{});
+    fsm.process(CardPresented{"1111"}).process(Timeout{});
     logFSM(fsm);
 
     // state transition
@@ -73,12 +82,12 @@ TEST(FSMStateTransitions, TestTimeoutOnPaymentProcessing) {
     EXPECT_EQ("", fsm.getPOS().getThirdRow());
 
     // Actions
-    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway2", "A", getFare()));
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway2", "1111", getFare()));
 }
 
 TEST(FSMStateTransitions, TestLockedFromPaymentFailed) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionDeclined{"Insufficient Funds"}).process(Timeout{});
+    fsm.process(CardPresented{"1111"}).process(TransactionDeclined{"Insufficient Funds"}).process(Timeout{});
     logFSM(fsm);
 
     // state transition
@@ -94,7 +103,7 @@ TEST(FSMStateTransitions, TestLockedFromPaymentFailed) {
 
 TEST(FSMStateTransitions, TestPaymentSuccessful) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionSuccess{5, 25});
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{5, 25});
     logFSM(fsm);
 
     // state transition
@@ -110,7 +119,7 @@ TEST(FSMStateTransitions, TestPaymentSuccessful) {
 
 TEST(FSMStateTransitions, TestUnlocked) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionSuccess{5, 25}).process(Timeout{});
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{5, 25}).process(Timeout{});
     logFSM(fsm);
 
     // state transition
@@ -126,7 +135,7 @@ TEST(FSMStateTransitions, TestUnlocked) {
 
 TEST(FSMStateTransitions, TestLockedFromUnlocked) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionSuccess{}).process(Timeout{}).process(PersonPassed{});
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{}).process(Timeout{}).process(PersonPassed{});
     logFSM(fsm);
 
     // state transition
@@ -142,7 +151,7 @@ TEST(FSMStateTransitions, TestLockedFromUnlocked) {
 
 TEST(FSMStateTransitions, TestLockedFromPaymentSuccessful) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(TransactionSuccess{}).process(PersonPassed{});
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{}).process(PersonPassed{});
     logFSM(fsm);
 
     // state transition
@@ -158,8 +167,8 @@ TEST(FSMStateTransitions, TestLockedFromPaymentSuccessful) {
 
 TEST(FSMStateTransitions, TestBug) {
     FSM fsm;
-    fsm.process(CardPresented{"A"}).process(Timeout{}).process(Timeout{}).process(Timeout{}).process(Timeout{});
+    fsm.process(CardPresented{"1111"}).process(Timeout{}).process(Timeout{}).process(Timeout{}).process(Timeout{});
     EXPECT_EQ(eState::Locked, fsm.getState());
-    fsm.process(CardPresented{"A"}).process(Timeout{});
+    fsm.process(CardPresented{"1111"}).process(Timeout{});
     EXPECT_EQ(eState::PaymentProcessing, fsm.getState());
 }
@@ -0,0 +1,216 @@
+#include "FSMWithTransitionTable.h"
+
+#include <gtest/gtest.h>
+
+using with_transition_table::FSM;
+
+TEST(FSMWithTransitionTable, TestInitialState) {
+    FSM fsm;
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::Locked, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::RedCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestPaymentProcessing) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(fsm.getState(), eState::PaymentProcessing);
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::OrangeCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Processing", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+
+    // Actions
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+}
+
+TEST(FSMWithTransitionTable, TestUnreadableCardIsIgnored) {
+    FSM fsm;
+    for (const auto * card : {"", "4000 1234", "400A", "12345678901234567890"}) {
+        fsm.process(CardPresented{card});
+        EXPECT_EQ(eState::Locked, fsm.getState()) << card;
+    }
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
+}
+
+TEST(FSMWithTransitionTable, TestPaymentFailed) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionDeclined{"Insufficient Funds"});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(fsm.getState(), eState::PaymentFailed);
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::FlashRedCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Declined", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("Insufficient Funds", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+
+    // Actions
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+}
+
+TEST(FSMWithTransitionTable, TestTimeoutOnPaymentProcessing) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(Timeout{});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(fsm.getState(), eState::PaymentProcessing);
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::OrangeCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Processing", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+
+    // Actions
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway2", "1111", getFare()));
+}
+
+TEST(FSMWithTransitionTable, TestLockedFromPaymentFailed) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionDeclined{"Insufficient Funds"}).process(Timeout{});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::Locked, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::RedCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestPaymentSuccessful) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{5, 25});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::PaymentSuccess, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Open, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::GreenArrow, fsm.getLED().getStatus());
+    EXPECT_EQ("Approved", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("Fare: 5", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("Balance: 25", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestUnlocked) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{5, 25}).process(Timeout{});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::Unlocked, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Open, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::GreenArrow, fsm.getLED().getStatus());
+    EXPECT_EQ("Approved", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestLockedFromUnlocked) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{}).process(Timeout{}).process(PersonPassed{});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::Locked, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::RedCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestLockedFromPaymentSuccessful) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(TransactionSuccess{}).process(PersonPassed{});
+    logFSM(fsm);
+
+    // state transition
+    EXPECT_EQ(eState::Locked, fsm.getState());
+
+    // Device States
+    EXPECT_EQ(SwingDoor::eStatus::Closed, fsm.getDoor().getStatus());
+    EXPECT_EQ(LEDController::eStatus::RedCross, fsm.getLED().getStatus());
+    EXPECT_EQ("Touch Card", fsm.getPOS().getFirstRow());
+    EXPECT_EQ("", fsm.getPOS().getSecondRow());
+    EXPECT_EQ("", fsm.getPOS().getThirdRow());
+}
+
+TEST(FSMWithTransitionTable, TestBug) {
+    FSM fsm;
+    fsm.process(CardPresented{"1111"}).process(Timeout{}).process(Timeout{}).process(Timeout{}).process(Timeout{});
+    EXPECT_EQ(eState::Locked, fsm.getState());
+    fsm.process(CardPresented{"1111"}).process(Timeout{});
+    EXPECT_EQ(eState::PaymentProcessing, fsm.getState());
+}
+namespace {
+    enum class eLight { Off, On, Broken };
+
+    struct Toggle {};
+    struct Surge {
+        int volts;
+    };
+
+    struct Lamp {
+        int switches{0};
+        int maxVolts{240};
+    };
+
+    void countSwitch(Lamp & lamp) {
+        ++lamp.switches;
+    }
+
+    bool overloads(Lamp & lamp, const Surge & surge) {
+        return surge.volts > lamp.maxVolts;
+    }
+
+    using LampTable = adc::TFSMTransitionTable<Lamp, eLight::Off,
+        adc::TRow<eLight::Off, Toggle, eLight::On, &countSwitch>,
+        adc::TRow<eLight::On, Toggle, eLight::Off, &countSwitch>,
+        adc::TRow<eLight::On, Surge, eLight::Broken, nullptr, &overloads>>;
+} // namespace
+
+TEST(FSMWithTransitionTable, TestFreeFunctionsAndGuards) {
+    Lamp lamp;
+    LampTable table;
+    EXPECT_TRUE(table.process(lamp, Toggle{}));
+    EXPECT_EQ(eLight::On, table.getState());
+    EXPECT_FALSE(table.process(lamp, Surge{230}));
+    EXPECT_EQ(eLight::On, table.getState());
+    EXPECT_TRUE(table.process(lamp, Surge{400}));
+    EXPECT_EQ(eLight::Broken, table.getState());
+    // neither a row for the state nor for the event
+    EXPECT_FALSE(table.process(lamp, Toggle{}));
+    EXPECT_FALSE(table.process(lamp, 42));
+    EXPECT_EQ(eLight::Broken, table.getState());
+    EXPECT_EQ(1, lamp.switches);
+}
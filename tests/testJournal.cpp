@@ -0,0 +1,178 @@
+#include "TurnstileFleet.h"
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct Entry {
+        std::size_t gateId;
+        AnyEvent event;
+    };
+
+    // an empty directory of its own for every test
+    std::filesystem::path journalDirectory() {
+        const auto * test = ::testing::UnitTest::GetInstance()->current_test_info();
+        auto directory = std::filesystem::temp_directory_path() / (std::string{"fsm_journal_"} + test->name());
+        std::filesystem::remove_all(directory);
+        return directory;
+    }
+
+    std::vector<Entry> readBack(TurnstileJournalReplay & journal) {
+        std::vector<Entry> entries;
+        std::chrono::nanoseconds previous{0};
+        journal.replay([&](std::size_t gateId, std::chrono::nanoseconds timestamp, auto event) {
+            EXPECT_LE(previous, timestamp);
+            previous = timestamp;
+            entries.push_back(Entry{gateId, std::move(event)});
+        });
+        return entries;
+    }
+} // namespace
+
+TEST(Journal, TestEveryEventRoundTrips) {
+    const auto directory = journalDirectory();
+    {
+        TurnstileJournal journal{directory};
+        EXPECT_TRUE(journal.append(0, CardPresented{"4000123412341234"}));
+        EXPECT_TRUE(journal.append(1, TransactionDeclined{"Insufficient Funds"}));
+        EXPECT_TRUE(journal.append(2, TransactionSuccess{5, 25}));
+        EXPECT_TRUE(journal.append(3, PersonPassed{}));
+        EXPECT_TRUE(journal.append(100000, AnyEvent{Timeout{}}));
+        EXPECT_TRUE(journal.flush());
+    }
+
+    TurnstileJournalReplay journal{directory};
+    const auto entries = readBack(journal);
+    EXPECT_TRUE(journal.complete());
+    ASSERT_EQ(5U, entries.size());
+    EXPECT_EQ(0U, entries[0].gateId);
+    EXPECT_EQ("4000123412341234", std::get<CardPresented>(entries[0].event).cardNumber);
+    EXPECT_EQ("Insufficient Funds", std::get<TransactionDeclined>(entries[1].event).reason);
+    EXPECT_EQ(5, std::get<TransactionSuccess>(entries[2].event).fare);
+    EXPECT_EQ(25, std::get<TransactionSuccess>(entries[2].event).balance);
+    EXPECT_TRUE(std::holds_alternative<PersonPassed>(entries[3].event));
+    EXPECT_EQ(100000U, entries[4].gateId);
+    EXPECT_TRUE(std::holds_alternative<Timeout>(entries[4].event));
+}
+
+TEST(Journal, TestSegmentsRotate) {
+    const auto directory = journalDirectory();
+    adc::JournalOptions options;
+    options.segmentBytes = 64;
+    for (int run = 0; run < 2; ++run) {
+        // a second journal in the same directory carries on after the segments of the first
+        TurnstileJournal journal{directory, "journal", options};
+        for (std::size_t gateId = 0; gateId < 10; ++gateId) {
+            journal.append(gateId, TransactionSuccess{static_cast<int>(gateId), run});
+            EXPECT_TRUE(journal.flush());
+        }
+    }
+
+    TurnstileJournalReplay journal{directory};
+    EXPECT_LT(2U, journal.segments());
+    const auto entries = readBack(journal);
+    EXPECT_TRUE(journal.complete());
+    ASSERT_EQ(20U, entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        EXPECT_EQ(i % 10, entries[i].gateId);
+        EXPECT_EQ(static_cast<int>(i / 10), std::get<TransactionSuccess>(entries[i].event).balance);
+    }
+}
+
+TEST(Journal, TestReplayStopsAtTornTail) {
+    const auto directory = journalDirectory();
+    {
+        TurnstileJournal journal{directory};
+        journal.append(0, CardPresented{"1234"});
+        journal.append(0, TransactionDeclined{"No Funds"});
+    }
+    const auto segment = std::filesystem::directory_iterator{directory}->path();
+    std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 3);
+
+    TurnstileJournalReplay journal{directory};
+    const auto entries = readBack(journal);
+    EXPECT_FALSE(journal.complete());
+    ASSERT_EQ(1U, entries.size());
+    EXPECT_EQ("1234", std::get<CardPresented>(entries[0].event).cardNumber);
+}
+
+TEST(Journal, TestReplayRebuildsFleet) {
+    const auto directory = journalDirectory();
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    fsm_fleet::Fleet recorded{4};
+    TurnstileJournal journal{directory};
+    recorded.setJournal(&journal);
+    recorded.process(0, CardPresented{"1111"});
+    recorded.process(1, CardPresented{"2222"}).process(1, TransactionDeclined{"No Funds"});
+    recorded.process(2, CardPresented{"3333"}).process(2, TransactionSuccess{5, 25});
+    recorded.process(3, CardPresented{"4444"}).process(3, TransactionSuccess{5, 25}).process(3, PersonPassed{});
+    // the gates waiting on a timer time out, gate 0 onto its next gateway; timeouts are journaled like any other event
+    clock.runFor(2s);
+    recorded.process(2, CardPresented{"5555"});
+    recorded.setJournal(nullptr);
+    ASSERT_TRUE(journal.flush());
+
+    // the replayed fleet's timers are held until the journal is done, so every transition comes from the journal
+    fsm_fleet::Fleet replayed{4};
+    const std::filesystem::path copyDirectory{directory.string() + "_copy"};
+    std::filesystem::remove_all(copyDirectory);
+    TurnstileJournal copy{copyDirectory};
+    replayed.setJournal(&copy);
+    const auto pending = clock.pending();
+    TurnstileJournalReplay replay{directory};
+    EXPECT_EQ(12U, replayed.replay(replay));
+    EXPECT_TRUE(replay.complete());
+    // the timers still pending were armed on the live clock once the journal was done
+    EXPECT_EQ(2 * pending, clock.pending());
+    // replayed events are not journaled again
+    replayed.setJournal(nullptr);
+    ASSERT_TRUE(copy.flush());
+    TurnstileJournalReplay copied{copyDirectory};
+    EXPECT_TRUE(readBack(copied).empty());
+    for (std::size_t gateId = 0; gateId < replayed.size(); ++gateId) {
+        EXPECT_EQ(recorded.getState(gateId), replayed.getState(gateId));
+        EXPECT_EQ(recorded.getGate(gateId).getPOS().getRows(), replayed.getGate(gateId).getPOS().getRows());
+        EXPECT_EQ(recorded.getGate(gateId).getDoor().getStatus(), replayed.getGate(gateId).getDoor().getStatus());
+    }
+
+    // and both fleets time out alike
+    clock.runFor(10s);
+    for (std::size_t gateId = 0; gateId < replayed.size(); ++gateId) {
+        EXPECT_EQ(recorded.getState(gateId), replayed.getState(gateId));
+    }
+}
+
+TEST(Journal, TestReplayedGatesTimeOutLive) {
+    const auto directory = journalDirectory();
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    {
+        fsm_fleet::Fleet recorded{2};
+        TurnstileJournal journal{directory};
+        recorded.setJournal(&journal);
+        recorded.process(0, CardPresented{"1111"}).process(0, TransactionDeclined{"No Funds"});
+        recorded.process(1, CardPresented{"2222"});
+        recorded.setJournal(nullptr);
+        ASSERT_TRUE(journal.flush());
+    }
+    ASSERT_EQ(0U, clock.pending());
+
+    fsm_fleet::Fleet replayed{2};
+    TurnstileJournalReplay replay{directory};
+    EXPECT_EQ(3U, replayed.replay(replay));
+    EXPECT_EQ(eState::PaymentFailed, replayed.getState(0));
+    EXPECT_EQ(eState::PaymentProcessing, replayed.getState(1));
+    EXPECT_EQ(2U, clock.pending());
+
+    // the declined gate locks again, the other goes on to its next gateway and, with no reply, fails in the end
+    EXPECT_EQ(2U, clock.runFor(2s));
+    EXPECT_EQ(eState::Locked, replayed.getState(0));
+    EXPECT_EQ(eState::PaymentProcessing, replayed.getState(1));
+    clock.runFor(10s);
+    EXPECT_EQ(eState::Locked, replayed.getState(1));
+}
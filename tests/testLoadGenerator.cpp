@@ -0,0 +1,71 @@
+#include "LoadGenerator.h"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+    LoadOptions smallRun() {
+        LoadOptions options;
+        options.gates = 50;
+        options.duration = 2min;
+        for (auto & profile : options.gateways) {
+            profile.latency = LatencyModel::fixed(100ms);
+            profile.declineRate = 0;
+        }
+        return options;
+    }
+} // namespace
+
+TEST(LoadGenerator, TestSameSeedSameRun) {
+    auto options = smallRun();
+    options.gateways[0].latency = LatencyModel::logNormal(120ms, 0.8);
+    options.gateways[0].declineRate = 0.1;
+    const auto first = runLoad(options);
+    const auto second = runLoad(options);
+    EXPECT_LT(300U, first.taps);
+    EXPECT_EQ(first.taps, second.taps);
+    EXPECT_EQ(first.approved, second.approved);
+    EXPECT_EQ(first.declined, second.declined);
+    EXPECT_EQ(first.p99, second.p99);
+    EXPECT_EQ(first.events, second.events);
+    EXPECT_EQ(first.taps, first.approved + first.declined + first.failed);
+}
+
+TEST(LoadGenerator, TestFixedLatency) {
+    const auto report = runLoad(smallRun());
+    EXPECT_EQ(report.taps, report.approved);
+    EXPECT_EQ(0U, report.retries);
+    EXPECT_EQ(100ms, report.p50);
+    EXPECT_EQ(100ms, report.max);
+    EXPECT_EQ(report.taps, report.gateways[0].requests);
+}
+
+TEST(LoadGenerator, TestOutageRetriesOnNextGateway) {
+    auto options = smallRun();
+    options.gateways[0].outages.push_back(Outage{0ms, 1h});
+    const auto report = runLoad(options);
+    EXPECT_EQ(report.taps, report.approved);
+    EXPECT_EQ(report.taps, report.retries);
+    EXPECT_EQ(report.taps, report.gateways[0].lost);
+    EXPECT_EQ(report.taps, report.gateways[1].requests);
+    // the timeout of the first gateway, then the second one's latency
+    EXPECT_EQ(2100ms, report.p50);
+}
+
+TEST(LoadGenerator, TestDeclinesAndNetworkFailures) {
+    auto options = smallRun();
+    options.gateways[0].declineRate = 1;
+    auto report = runLoad(options);
+    EXPECT_EQ(report.taps, report.declined);
+    EXPECT_EQ(0U, report.approved);
+
+    options = smallRun();
+    for (auto & profile : options.gateways) {
+        profile.outages.push_back(Outage{0ms, 1h});
+    }
+    report = runLoad(options);
+    EXPECT_EQ(report.taps, report.failed);
+    EXPECT_EQ(2 * report.taps, report.retries);
+    EXPECT_EQ(0ms, report.max);
+}
@@ -0,0 +1,124 @@
+#include "Logger.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // the level and the sink are process-wide, so every test restores them
+    class LoggerTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            adc::Logger::setLevel(adc::LogLevel::Info);
+            adc::Logger::instance().start(_sink);
+        }
+
+        void TearDown() override {
+            adc::Logger::instance().stop();
+            adc::Logger::setLevel(adc::LogLevel::Off);
+        }
+
+        std::string output() {
+            adc::Logger::instance().flush();
+            return _sink.str();
+        }
+
+        std::stringstream _sink;
+    };
+
+    int evaluated = 0;
+
+    int countEvaluation() {
+        return ++evaluated;
+    }
+} // namespace
+
+TEST_F(LoggerTest, TestFormatsArguments) {
+    const std::string gateway = "VISA";
+    ADC_LOG(Info, "to [{}] with card [{}] for amount [{}]", gateway, "1234", 25);
+    ADC_LOG(Error, "no arguments");
+    ADC_LOG(Warning, "{}{} ok", 'x', true);
+    EXPECT_EQ("to [VISA] with card [1234] for amount [25]\nno arguments\nx1 ok\n", output());
+}
+
+TEST_F(LoggerTest, TestDisabledLevelSkipsArguments) {
+    evaluated = 0;
+    ADC_LOG(Debug, "skipped {}", countEvaluation());
+    EXPECT_EQ(0, evaluated);
+    ADC_LOG(Info, "logged {}", countEvaluation());
+    EXPECT_EQ(1, evaluated);
+
+    adc::Logger::setLevel(adc::LogLevel::Off);
+    ADC_LOG(Error, "skipped {}", countEvaluation());
+    EXPECT_EQ(1, evaluated);
+    EXPECT_EQ("logged 1\n", output());
+}
+
+TEST_F(LoggerTest, TestThreadsAreMergedInOrder) {
+    constexpr int RECORDS = 1000;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 2; ++thread) {
+        threads.emplace_back([thread] {
+            for (int i = 0; i < RECORDS; ++i) {
+                ADC_LOG(Info, "thread {} record {}", thread, i);
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    std::stringstream lines{output()};
+    std::vector<int> next(2);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const auto thread = line[7] - '0';
+        EXPECT_EQ("thread " + std::to_string(thread) + " record " + std::to_string(next[thread]++), line);
+    }
+    EXPECT_EQ(std::vector<int>({RECORDS, RECORDS}), next);
+}
+
+TEST_F(LoggerTest, TestFullBufferDropsRecords) {
+    adc::Logger::instance().stop();
+    adc::Logger::instance().start(_sink, std::chrono::hours{1});
+    const std::string payload(1000, '.');
+    for (int i = 0; i < 100; ++i) {
+        ADC_LOG(Info, "{}", payload);
+    }
+    // 64 records fit in the buffer, fewer when it wraps
+    std::stringstream lines{output()};
+    int written = 0;
+    std::string line;
+    while (std::getline(lines, line) && line == payload) {
+        ++written;
+    }
+    EXPECT_LE(written, 64);
+    const auto dropped = "logger: dropped " + std::to_string(100 - written) + " records of thread";
+    EXPECT_EQ(dropped, line.substr(0, line.rfind(' ')));
+    ADC_LOG(Info, "{}", "after");
+    EXPECT_NE(std::string::npos, output().find("\nafter\n"));
+}
+
+TEST_F(LoggerTest, TestRingsOfExitedThreadsAreRetired) {
+    // drained by flush only
+    adc::Logger::instance().stop();
+    adc::Logger::instance().start(_sink, std::chrono::hours{1});
+    ADC_LOG(Info, "{}", "before");
+    output();
+    const auto rings = adc::Logger::instance().rings();
+    for (int thread = 0; thread < 8; ++thread) {
+        std::thread{[thread] {
+            ADC_LOG(Info, "exited {}", thread);
+        }}.join();
+    }
+    EXPECT_EQ(rings + 8, adc::Logger::instance().rings());
+
+    // their records are written before their buffers go
+    const auto text = output();
+    for (int thread = 0; thread < 8; ++thread) {
+        EXPECT_NE(std::string::npos, text.find("exited " + std::to_string(thread) + "\n")) << thread;
+    }
+    EXPECT_EQ(rings, adc::Logger::instance().rings());
+}
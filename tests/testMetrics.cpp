@@ -0,0 +1,127 @@
+#include "Metrics.h"
+#include "Tracer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+namespace {
+    struct Go {};
+
+    class Red;
+    class Green;
+
+    class Red {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Green>();
+        }
+        int getState() const {
+            return 0;
+        }
+    };
+
+    class Green {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Red>();
+        }
+        int getState() const {
+            return 1;
+        }
+    };
+
+    using FSM = adc::TTracedFSMStateTransitions<adc::MetricsTracer, Red, Green>;
+
+    std::string prometheus() {
+        std::stringstream out;
+        adc::MetricsRegistry::instance().writePrometheus(out);
+        return out.str();
+    }
+} // namespace
+
+TEST(Metrics, TestShardsAreSummed) {
+    const auto & series = adc::MetricsRegistry::instance().addSeries(
+        {"Red", "Green"}, {{"gate", "shards"}, {"station", "Central"}});
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&] {
+            FSM fsm{Red{}};
+            fsm.tracer().attach(series);
+            for (int step = 0; step < 3; ++step) {
+                fsm.process(Go{});
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    const auto text = prometheus();
+    EXPECT_NE(std::string::npos, text.find("fsm_state_entries_total{gate=\"shards\",station=\"Central\",state=\"Green\"} 4\n"))
+        << text;
+    EXPECT_NE(std::string::npos, text.find("fsm_state_entries_total{gate=\"shards\",station=\"Central\",state=\"Red\"} 2\n"));
+    EXPECT_NE(
+        std::string::npos,
+        text.find("fsm_transitions_total{gate=\"shards\",station=\"Central\",from=\"Red\",to=\"Green\"} 4\n"));
+    EXPECT_NE(
+        std::string::npos,
+        text.find("fsm_state_dwell_seconds_count{gate=\"shards\",station=\"Central\",state=\"Red\"} 4\n"));
+    EXPECT_NE(
+        std::string::npos,
+        text.find("fsm_state_dwell_seconds_bucket{gate=\"shards\",station=\"Central\",state=\"Green\",le=\"+Inf\"} 2\n"));
+}
+
+TEST(Metrics, TestDwellOnABoundIsInItsBucket) {
+    using namespace std::chrono_literals;
+    using adc::details::SeriesLayout;
+    EXPECT_EQ(0u, SeriesLayout::bucketOf(0ns));
+    EXPECT_EQ(0u, SeriesLayout::bucketOf(1ms));
+    EXPECT_EQ(1u, SeriesLayout::bucketOf(1ms + 1ns));
+    EXPECT_EQ(1u, SeriesLayout::bucketOf(2ms));
+    EXPECT_EQ(2u, SeriesLayout::bucketOf(3ms));
+    EXPECT_EQ(2u, SeriesLayout::bucketOf(4ms));
+    EXPECT_EQ(3u, SeriesLayout::bucketOf(4ms + 1ns));
+    // the last bound before +Inf
+    const std::chrono::milliseconds last{1 << (SeriesLayout::BUCKETS - 2)};
+    EXPECT_EQ(SeriesLayout::BUCKETS - 2, SeriesLayout::bucketOf(last));
+    EXPECT_EQ(SeriesLayout::BUCKETS - 1, SeriesLayout::bucketOf(last + 1ns));
+    EXPECT_EQ(SeriesLayout::BUCKETS - 1, SeriesLayout::bucketOf(1h));
+}
+
+TEST(Metrics, TestDetachedTracerCountsNothing) {
+    const auto & series = adc::MetricsRegistry::instance().addSeries({"Red", "Green"}, {{"gate", "detached"}});
+    FSM fsm{Red{}};
+    fsm.process(Go{});
+    EXPECT_NE(std::string::npos, prometheus().find("fsm_state_entries_total{gate=\"detached\",state=\"Green\"} 0\n"));
+    fsm.tracer().attach(series);
+    fsm.process(Go{});
+    EXPECT_NE(std::string::npos, prometheus().find("fsm_state_entries_total{gate=\"detached\",state=\"Red\"} 1\n"));
+}
+
+TEST(Metrics, TestCombinedWithRingTracer) {
+    const auto & series = adc::MetricsRegistry::instance().addSeries({"Red", "Green"}, {{"gate", "combined"}});
+    adc::TTracedFSMStateTransitions<adc::TTracers<adc::RingTracer, adc::MetricsTracer>, Red, Green> fsm{Red{}};
+    fsm.tracer().get<adc::MetricsTracer>().attach(series);
+    fsm.process(Go{});
+    EXPECT_NE(std::string::npos, prometheus().find("fsm_state_entries_total{gate=\"combined\",state=\"Green\"} 1\n"));
+}
+
+TEST(Metrics, TestExporterWritesFile) {
+    const auto path = (std::filesystem::temp_directory_path() / "fsm_metrics_test.prom").string();
+    const auto & series = adc::MetricsRegistry::instance().addSeries({"Red", "Green"}, {{"gate", "exported"}});
+    {
+        adc::MetricsExporter exporter{path, std::chrono::milliseconds{5}};
+        FSM fsm{Red{}};
+        fsm.tracer().attach(series);
+        fsm.process(Go{});
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    std::ifstream in{path};
+    std::stringstream text;
+    text << in.rdbuf();
+    EXPECT_NE(std::string::npos, text.str().find("fsm_state_entries_total{gate=\"exported\",state=\"Green\"} 1\n"));
+    std::filesystem::remove(path);
+}
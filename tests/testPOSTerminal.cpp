@@ -0,0 +1,69 @@
+#include "Turnstile.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(POSTerminal, TestRows) {
+    POSTerminal pos{POSTerminal::DECLINED, std::string{"No Funds"}};
+    EXPECT_EQ("Declined", pos.getFirstRow());
+    EXPECT_EQ("No Funds", pos.getSecondRow());
+    EXPECT_EQ("", pos.getThirdRow());
+    EXPECT_EQ("Declined, No Funds, ", pos.getRows());
+
+    pos.setRows("Touch Card");
+    EXPECT_EQ("Touch Card, , ", pos.getRows());
+}
+
+TEST(POSTerminal, TestNumbers) {
+    POSTerminal pos{POSTerminal::APPROVED, {"Fare: ", 5}, {"Balance: ", -1234567}};
+    EXPECT_EQ("Fare: 5", pos.getSecondRow());
+    EXPECT_EQ("Balance: -1234567", pos.getThirdRow());
+}
+
+TEST(POSTerminal, TestTextIsCutToTheDisplay) {
+    POSTerminal pos{"Transaction declined by the gateway", {"Balance of the card: ", 25}};
+    EXPECT_EQ("Transaction declined", pos.getFirstRow());
+    // a number which does not fit is left out entirely
+    EXPECT_EQ("Balance of the card:", pos.getSecondRow());
+}
+
+TEST(POSTerminal, TestMessagesAreRenderedWhenRead) {
+    POSTerminal pos{""};
+    pos.show(POSTerminal::eMessage::Paid, 5, 25);
+    EXPECT_EQ(POSTerminal::eMessage::Paid, pos.getMessage());
+    EXPECT_EQ("Approved, Fare: 5, Balance: 25", pos.getRows());
+
+    pos.show(POSTerminal::eMessage::Declined, std::string{"No Funds"});
+    EXPECT_EQ("Declined, No Funds, ", pos.getRows());
+
+    pos.show(POSTerminal::eMessage::TouchCard);
+    EXPECT_EQ("Touch Card", pos.getFirstRow());
+    EXPECT_EQ("", pos.getSecondRow());
+
+    pos.setRows("Out of Order");
+    EXPECT_EQ(POSTerminal::eMessage::Rows, pos.getMessage());
+    EXPECT_EQ("Out of Order, , ", pos.getRows());
+}
+
+TEST(POSTerminal, TestConcurrentReadersOfAConstTerminal) {
+    for (int round = 0; round < 100; ++round) {
+        POSTerminal pos{""};
+        pos.show(POSTerminal::eMessage::Paid, 5, 25);
+        const POSTerminal & display = pos;
+        std::vector<std::string> rows(4);
+        std::vector<std::thread> readers;
+        for (auto & row : rows) {
+            readers.emplace_back([&] {
+                row = display.getRows();
+            });
+        }
+        for (auto & reader : readers) {
+            reader.join();
+        }
+        for (const auto & row : rows) {
+            EXPECT_EQ("Approved, Fare: 5, Balance: 25", row);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include "Pan.h"
+
+#include <gtest/gtest.h>
+
+TEST(Pan, TestParse) {
+    const auto pan = Pan::parse("4000123412341234");
+    ASSERT_TRUE(pan);
+    EXPECT_EQ(16U, pan->size());
+    EXPECT_EQ('4', (*pan)[0]);
+    EXPECT_EQ('1', (*pan)[4]);
+    EXPECT_EQ("4000123412341234", pan->text().view());
+
+    // the digits past the sixteenth share a word with the length
+    const auto longest = Pan::parse("1234567890123456789");
+    ASSERT_TRUE(longest);
+    EXPECT_EQ(19U, longest->size());
+    EXPECT_EQ('6', (*longest)[15]);
+    EXPECT_EQ('7', (*longest)[16]);
+    EXPECT_EQ('9', (*longest)[18]);
+}
+
+TEST(Pan, TestRoundTrip) {
+    for (const std::string_view text : {"0", "7", "1111", "0123456789012345", "9999999999999999999"}) {
+        const auto pan = Pan::parse(text);
+        ASSERT_TRUE(pan) << text;
+        EXPECT_EQ(text, pan->text().view());
+        EXPECT_EQ(pan, Pan::parse(pan->text().view()));
+    }
+    EXPECT_NE(Pan::parse("12"), Pan::parse("120"));
+    EXPECT_TRUE(Pan{}.empty());
+}
+
+TEST(Pan, TestRejectsInvalid) {
+    EXPECT_FALSE(Pan::parse(""));
+    EXPECT_FALSE(Pan::parse("12345678901234567890"));
+    EXPECT_FALSE(Pan::parse("4000 1234"));
+    EXPECT_FALSE(Pan::parse("400a"));
+    EXPECT_FALSE(Pan::parse("A"));
+    EXPECT_FALSE(Pan::parse("4000ABCD"));
+    EXPECT_FALSE(Pan::parse("G"));
+}
+
+TEST(Pan, TestSize) {
+    EXPECT_EQ(12U, sizeof(Pan));
+    EXPECT_EQ(1U, alignof(Pan));
+}
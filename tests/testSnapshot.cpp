@@ -0,0 +1,164 @@
+#include "FSMExternalTransitions.h"
+#include "FSMStateTransitions.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr std::uint32_t VERSION = 1;
+
+    std::string snapshotPath() {
+        return (std::filesystem::temp_directory_path() / "fsm_snapshot_test.bin").string();
+    }
+
+    // one machine per state, the one in PaymentProcessing on its second gateway
+    template <typename FSM>
+    std::vector<std::unique_ptr<FSM>> gatesInEveryState() {
+        std::vector<std::unique_ptr<FSM>> gates;
+        for (int i = 0; i < 5; ++i) {
+            gates.push_back(std::make_unique<FSM>());
+        }
+        gates[1]->process(CardPresented{"1111"}).process(Timeout{});
+        gates[2]->process(CardPresented{"2222"}).process(TransactionDeclined{"No Funds"});
+        gates[3]->process(CardPresented{"3333"}).process(TransactionSuccess{5, 25});
+        gates[4]->process(CardPresented{"4444"}).process(TransactionSuccess{5, 25}).process(Timeout{});
+        return gates;
+    }
+
+    template <typename FSM>
+    bool save(const std::vector<std::unique_ptr<FSM>> & gates) {
+        const auto saveGate = [&](std::size_t id, adc::SnapshotWriter & out) {
+            gates[id]->save(out);
+        };
+        return adc::writeSnapshot(snapshotPath(), VERSION, gates.size(), saveGate);
+    }
+
+    template <typename FSM>
+    bool restore(const adc::SnapshotFile & file, std::vector<std::unique_ptr<FSM>> & gates) {
+        return file.restore(
+            [](std::size_t id, adc::SnapshotReader & in) {
+                return FSM::check(in);
+            },
+            [&](std::size_t id, adc::SnapshotReader & in) {
+                return gates[id]->restore(in);
+            });
+    }
+
+    template <typename FSM>
+    void testRoundTrip() {
+        adc::VirtualTimerSource clock;
+        adc::TimerSource::Override useVirtualTime{clock};
+        ASSERT_TRUE(save(gatesInEveryState<FSM>()));
+
+        const adc::SnapshotFile file{snapshotPath()};
+        ASSERT_TRUE(file.ok());
+        EXPECT_EQ(VERSION, file.version());
+        ASSERT_EQ(5u, file.size());
+        std::vector<std::unique_ptr<FSM>> gates;
+        for (std::size_t i = 0; i < file.size(); ++i) {
+            gates.push_back(std::make_unique<FSM>());
+        }
+        ASSERT_TRUE(restore(file, gates));
+
+        EXPECT_EQ(eState::Locked, gates[0]->getState());
+        EXPECT_EQ(eState::PaymentProcessing, gates[1]->getState());
+        EXPECT_EQ(eState::PaymentFailed, gates[2]->getState());
+        EXPECT_EQ(eState::PaymentSuccess, gates[3]->getState());
+        EXPECT_EQ(eState::Unlocked, gates[4]->getState());
+
+        // the session is resumed without contacting the gateway again
+        EXPECT_EQ(std::make_tuple(std::string{}, std::string{}, 0), gates[1]->getLastTransaction());
+        EXPECT_EQ("Processing", gates[1]->getPOS().getFirstRow());
+        EXPECT_EQ("No Funds", gates[2]->getPOS().getSecondRow());
+        EXPECT_EQ(SwingDoor::eStatus::Open, gates[3]->getDoor().getStatus());
+        EXPECT_EQ("Fare: 5", gates[3]->getPOS().getSecondRow());
+        EXPECT_EQ("Balance: 25", gates[3]->getPOS().getThirdRow());
+        EXPECT_EQ(LEDController::eStatus::GreenArrow, gates[4]->getLED().getStatus());
+
+        // the restored retry count carries on with the third gateway
+        clock.runFor(2s);
+        EXPECT_EQ(gates[1]->getLastTransaction(), std::make_tuple("Gateway3", "1111", getFare()));
+        EXPECT_EQ(eState::Locked, gates[2]->getState());
+        EXPECT_EQ(eState::Unlocked, gates[3]->getState());
+        std::filesystem::remove(snapshotPath());
+    }
+} // namespace
+
+TEST(Snapshot, TestRoundTripStateTransitions) {
+    testRoundTrip<fsm_state_transitions::FSM>();
+}
+
+TEST(Snapshot, TestRoundTripExternalTransitions) {
+    testRoundTrip<fsm_external_transitions::FSM>();
+}
+
+TEST(Snapshot, TestRejectsInvalidFiles) {
+    using FSM = fsm_state_transitions::FSM;
+    EXPECT_FALSE(adc::SnapshotFile{snapshotPath() + ".missing"}.ok());
+
+    std::ofstream{snapshotPath(), std::ios::binary} << "not a snapshot";
+    EXPECT_FALSE(adc::SnapshotFile{snapshotPath()}.ok());
+
+    ASSERT_TRUE(save(gatesInEveryState<FSM>()));
+    const auto size = std::filesystem::file_size(snapshotPath());
+    std::vector<std::unique_ptr<FSM>> gates;
+    for (int i = 0; i < 5; ++i) {
+        gates.push_back(std::make_unique<FSM>());
+    }
+    std::filesystem::resize_file(snapshotPath(), size - 1);
+    const adc::SnapshotFile truncated{snapshotPath()};
+    ASSERT_TRUE(truncated.ok());
+    EXPECT_FALSE(restore(truncated, gates));
+
+    // a state index out of range
+    std::vector<char> bytes(size);
+    std::ifstream{snapshotPath(), std::ios::binary}.read(bytes.data(), static_cast<std::streamsize>(size - 1));
+    bytes[sizeof(adc::SnapshotHeader) + sizeof(std::uint16_t)] = 9;
+    std::ofstream{snapshotPath(), std::ios::binary}.write(bytes.data(), static_cast<std::streamsize>(size));
+    EXPECT_FALSE(restore(adc::SnapshotFile{snapshotPath()}, gates));
+    std::filesystem::remove(snapshotPath());
+}
+
+TEST(Snapshot, TestRejectedRecordLeavesMachinesUntouched) {
+    using FSM = fsm_state_transitions::FSM;
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    // gate 1 waits on its second gateway; a retry count of 3 has no gateway left
+    ASSERT_TRUE(save(gatesInEveryState<FSM>()));
+    const auto size = std::filesystem::file_size(snapshotPath());
+    std::vector<char> bytes(size);
+    std::ifstream{snapshotPath(), std::ios::binary}.read(bytes.data(), static_cast<std::streamsize>(size));
+    const auto record = bytes.data() + sizeof(adc::SnapshotHeader);
+    std::uint16_t length = 0;
+    std::memcpy(&length, record, sizeof(length));
+    auto & retryCount = record[sizeof(length) + length + sizeof(length) + 1];
+    ASSERT_EQ(1, retryCount);
+    retryCount = 3;
+    std::ofstream{snapshotPath(), std::ios::binary}.write(bytes.data(), static_cast<std::streamsize>(size));
+
+    std::vector<std::unique_ptr<FSM>> gates;
+    for (int i = 0; i < 5; ++i) {
+        gates.push_back(std::make_unique<FSM>());
+    }
+    gates[0]->process(CardPresented{"5555"}).process(TransactionSuccess{5, 25});
+    EXPECT_FALSE(restore(adc::SnapshotFile{snapshotPath()}, gates));
+    EXPECT_EQ(eState::PaymentSuccess, gates[0]->getState());
+    EXPECT_EQ(eState::Locked, gates[1]->getState());
+    EXPECT_EQ("Touch Card", gates[1]->getPOS().getFirstRow());
+
+    // the machine itself rejects the record before replacing its state
+    const auto * next = record + sizeof(length) + length;
+    std::memcpy(&length, next, sizeof(length));
+    adc::SnapshotReader in{next + sizeof(length), next + sizeof(length) + length};
+    EXPECT_FALSE(gates[0]->restore(in));
+    EXPECT_EQ(eState::PaymentSuccess, gates[0]->getState());
+    EXPECT_EQ(SwingDoor::eStatus::Open, gates[0]->getDoor().getStatus());
+    std::filesystem::remove(snapshotPath());
+}
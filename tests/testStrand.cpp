@@ -0,0 +1,174 @@
+#include "FSMStrand.h"
+#include "Strand.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct Sequence {
+        std::size_t producer;
+        std::size_t value;
+    };
+
+    struct Echo {
+        std::size_t value;
+    };
+
+    struct Burst {
+        std::size_t count;
+    };
+
+    // records the events in the order processed; an Echo posts a Sequence back into the strand while it is processed,
+    // a Burst count of them
+    class Recorder {
+    public:
+        using Strand = adc::TStrand<Recorder, Sequence, Echo, Burst>;
+
+        void process(Sequence event) {
+            log.push_back(event);
+        }
+
+        void process(Echo event) {
+            strand->post(Sequence{1, event.value});
+            log.push_back(Sequence{0, event.value});
+        }
+
+        void process(Burst event) {
+            for (std::size_t value = 0; value < event.count; ++value) {
+                refused += !strand->post(Sequence{1, value});
+            }
+        }
+
+        Strand * strand{nullptr};
+        std::vector<Sequence> log;
+        std::size_t refused{0};
+    };
+
+    // A TimerService, except that the next timer cancelled is first made to fire, as if it had expired just before the
+    // transition which cancels it. The cancel returns once its expiry has run on the service's thread.
+    class ExpiringOnCancel final : public adc::TimerSource {
+    public:
+        void schedule(adc::TimerNode & node, std::chrono::milliseconds duration) override {
+            _service.schedule(node, duration);
+        }
+
+        void cancel(adc::TimerNode & node) override {
+            if (_expireNext.exchange(false)) {
+                _service.schedule(node, 0ms);
+                while (_service.pending() > 0) {
+                    std::this_thread::yield();
+                }
+            }
+            _service.cancel(node);
+        }
+
+        void replace(adc::TimerNode & from, adc::TimerNode & to) override {
+            _service.replace(from, to);
+        }
+
+        void expireNextCancelled() {
+            _expireNext = true;
+        }
+
+    private:
+        adc::TimerService _service;
+        std::atomic<bool> _expireNext{false};
+    };
+} // namespace
+
+TEST(Strand, TestIdleStrandProcessesAtOnce) {
+    Recorder recorder;
+    Recorder::Strand strand{recorder};
+    EXPECT_TRUE(strand.post(Sequence{0, 1}));
+    ASSERT_EQ(1U, recorder.log.size());
+    EXPECT_EQ(1U, recorder.log[0].value);
+}
+
+TEST(Strand, TestEventsPostedWhileProcessingRunNext) {
+    Recorder recorder;
+    Recorder::Strand strand{recorder};
+    recorder.strand = &strand;
+    strand.post(Echo{7});
+    // the echo finished before the event it posted ran, and both before post returned
+    ASSERT_EQ(2U, recorder.log.size());
+    EXPECT_EQ(0U, recorder.log[0].producer);
+    EXPECT_EQ(1U, recorder.log[1].producer);
+    EXPECT_EQ(7U, recorder.log[1].value);
+}
+
+TEST(Strand, TestOwnPostsNeverRefused) {
+    Recorder recorder;
+    Recorder::Strand strand{recorder, 2};
+    recorder.strand = &strand;
+    EXPECT_TRUE(strand.post(Burst{100}));
+    EXPECT_EQ(0U, recorder.refused);
+    ASSERT_EQ(100U, recorder.log.size());
+    for (std::size_t value = 0; value < 100; ++value) {
+        EXPECT_EQ(value, recorder.log[value].value);
+    }
+}
+
+TEST(Strand, TestProducersAreSerialised) {
+    constexpr std::size_t PRODUCERS = 4;
+    constexpr std::size_t EVENTS = 20000;
+    Recorder recorder;
+    Recorder::Strand strand{recorder, 64};
+
+    std::vector<std::thread> producers;
+    for (std::size_t producer = 0; producer < PRODUCERS; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (std::size_t value = 0; value < EVENTS; ++value) {
+                while (!strand.post(Sequence{producer, value})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto & producer : producers) {
+        producer.join();
+    }
+
+    ASSERT_EQ(PRODUCERS * EVENTS, recorder.log.size());
+    std::vector<std::size_t> next(PRODUCERS, 0);
+    for (const auto & event : recorder.log) {
+        EXPECT_EQ(next[event.producer]++, event.value);
+    }
+}
+
+TEST(Strand, TestTimersPostIntoTheStrand) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    fsm_strand::FSM fsm;
+    EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    EXPECT_TRUE(fsm.process(TransactionDeclined{"No Funds"}));
+    EXPECT_EQ(eState::PaymentFailed, fsm.getState());
+    EXPECT_EQ(1U, clock.runFor(2s));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+
+    EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    EXPECT_EQ(4U, clock.runFor(8s));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+}
+
+TEST(Strand, TestTimeoutOfStateLeftIsDropped) {
+    ExpiringOnCancel timers;
+    adc::TimerSource::Override useTimers{timers};
+
+    // the payment's timeout fires on the timer thread while the approval is being processed on this one, and is
+    // posted behind it; it must not cut PaymentSuccess short
+    fsm_strand::FSM fsm;
+    EXPECT_TRUE(fsm.process(CardPresented{"1111"}));
+    timers.expireNextCancelled();
+    EXPECT_TRUE(fsm.process(TransactionSuccess{5, 25}));
+    EXPECT_EQ(eState::PaymentSuccess, fsm.getState());
+    EXPECT_EQ(SwingDoor::eStatus::Open, fsm.getDoor().getStatus());
+
+    // a Timeout not from a timer is processed as ever
+    EXPECT_TRUE(fsm.process(Timeout{}));
+    EXPECT_EQ(eState::Unlocked, fsm.getState());
+}
@@ -0,0 +1,93 @@
+#include "Tariff.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+    // today at the given UTC time, which is the local time of a service in UTC
+    std::time_t todayAt(int hour, int minute = 0, int second = 0) {
+        const auto now = std::time(nullptr);
+        return now - now % (24 * 60 * 60) + hour * 3600 + minute * 60 + second;
+    }
+
+    const auto UTC = std::chrono::seconds{0};
+} // namespace
+
+TEST(Tariff, TestDefaultBands) {
+    TariffService tariff{defaultFareTable(), UTC};
+    constexpr int rates[] = {3, 3, 3, 3, 3, 3, 7, 7, 7, 7, 5, 5, 5, 5, 5, 7, 7, 7, 5, 5, 5, 5, 3, 3};
+    for (int hour = 0; hour < 24; ++hour) {
+        EXPECT_EQ(rates[hour], tariff.fare(todayAt(hour, 30))) << hour;
+    }
+}
+
+TEST(Tariff, TestBandBoundaries) {
+    TariffService tariff{defaultFareTable(), UTC};
+    EXPECT_EQ(7, tariff.fare(todayAt(9, 59, 59)));
+    EXPECT_EQ(5, tariff.fare(todayAt(10)));
+    EXPECT_EQ(3, tariff.fare(todayAt(23, 59, 59)));
+    EXPECT_EQ(3, tariff.fare(todayAt(24)));
+    EXPECT_EQ(7, tariff.fare(todayAt(30)));
+    // earlier times are looked up again rather than served from the cache
+    EXPECT_EQ(5, tariff.fare(todayAt(12)));
+}
+
+TEST(Tariff, TestUtcOffset) {
+    TariffService tariff{defaultFareTable(), std::chrono::hours{-3}};
+    EXPECT_EQ(3, tariff.fare(todayAt(8, 30)));
+    EXPECT_EQ(7, tariff.fare(todayAt(9)));
+}
+
+TEST(Tariff, TestParseFareTable) {
+    std::stringstream valid{"# weekday fares\n00:00 2\n\n07:30 6 # morning peak\n19:00 4\n"};
+    const auto table = parseFareTable(valid);
+    ASSERT_TRUE(table);
+    ASSERT_EQ(3u, table->size());
+    EXPECT_EQ(std::chrono::minutes{7 * 60 + 30}, (*table)[1].start);
+    EXPECT_EQ(6, (*table)[1].fare);
+
+    for (const auto * text : {"", "06:00 2\n", "00:00 2\n00:00 3\n", "00:00\n", "00:00 2 3\n", "25:00 1\n", "x\n"}) {
+        std::stringstream invalid{text};
+        EXPECT_FALSE(parseFareTable(invalid)) << text;
+    }
+}
+
+TEST(Tariff, TestLoadFile) {
+    const auto path = (std::filesystem::temp_directory_path() / "fsm_fares_test.txt").string();
+    std::ofstream{path} << "00:00 1\n12:00 9\n";
+    TariffService tariff{defaultFareTable(), UTC};
+    EXPECT_EQ(7, tariff.fare(todayAt(16)));
+    EXPECT_TRUE(tariff.loadFile(path));
+    EXPECT_EQ(9, tariff.fare(todayAt(16)));
+    EXPECT_EQ(1, tariff.fare(todayAt(11)));
+
+    std::ofstream{path} << "12:00 9\n";
+    EXPECT_FALSE(tariff.loadFile(path));
+    EXPECT_FALSE(tariff.loadFile(path + ".missing"));
+    EXPECT_EQ(9, tariff.fare(todayAt(16)));
+    std::filesystem::remove(path);
+}
+
+TEST(Tariff, TestConcurrentReadersAndReloads) {
+    TariffService tariff{defaultFareTable(), UTC};
+    std::vector<std::thread> readers;
+    for (int thread = 0; thread < 4; ++thread) {
+        readers.emplace_back([&tariff, thread] {
+            for (int i = 0; i < 10000; ++i) {
+                const auto fare = tariff.fare(todayAt((thread * 7 + i) % 24));
+                EXPECT_TRUE(fare == 3 || fare == 5 || fare == 7 || fare == 4) << fare;
+            }
+        });
+    }
+    for (int reload = 0; reload < 100; ++reload) {
+        tariff.setTable(reload % 2 ? FareTable{{std::chrono::minutes{0}, 4}} : defaultFareTable());
+    }
+    for (auto & reader : readers) {
+        reader.join();
+    }
+}
@@ -0,0 +1,183 @@
+#include "Turnstile.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct RecordingTimer final : adc::TimerNode {
+        explicit RecordingTimer(std::vector<int> & fired, int id) : fired(fired), id(id) {
+        }
+
+        void expire() override {
+            fired.push_back(id);
+        }
+
+        std::vector<int> & fired;
+        int id;
+    };
+
+    std::vector<int> advance(adc::TimingWheel & wheel, std::uint64_t to) {
+        adc::details::TimerLink expired;
+        wheel.advance(to, expired);
+        std::vector<int> ids;
+        while (const auto timer = adc::TimingWheel::takeFirst(expired)) {
+            ids.push_back(static_cast<RecordingTimer *>(timer)->id);
+        }
+        return ids;
+    }
+} // namespace
+
+TEST(TimingWheel, TestExpiresInDeadlineOrder) {
+    std::vector<int> unused;
+    adc::TimingWheel wheel;
+    RecordingTimer a{unused, 1}, b{unused, 2}, c{unused, 3}, d{unused, 4};
+    wheel.schedule(c, 5000);
+    wheel.schedule(a, 10);
+    wheel.schedule(d, 300000);
+    wheel.schedule(b, 64);
+    EXPECT_EQ(4u, wheel.size());
+    EXPECT_EQ(std::uint64_t{10}, wheel.nextTick());
+
+    EXPECT_TRUE(advance(wheel, 9).empty());
+    EXPECT_EQ(std::vector<int>({1, 2}), advance(wheel, 64));
+    EXPECT_EQ(std::vector<int>({}), advance(wheel, 4999));
+    EXPECT_EQ(std::vector<int>({3}), advance(wheel, 5000));
+    EXPECT_EQ(std::vector<int>({4}), advance(wheel, 1000000));
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_FALSE(wheel.nextTick());
+}
+
+TEST(TimingWheel, TestCancelAndReschedule) {
+    std::vector<int> unused;
+    adc::TimingWheel wheel;
+    RecordingTimer a{unused, 1}, b{unused, 2};
+    wheel.schedule(a, 100);
+    wheel.schedule(b, 200);
+    wheel.cancel(a);
+    EXPECT_FALSE(a.pending());
+    wheel.schedule(b, 50);
+    EXPECT_EQ(1u, wheel.size());
+    EXPECT_EQ(std::vector<int>({2}), advance(wheel, 1000));
+
+    // deadlines in the past expire on the next tick
+    wheel.schedule(a, 3);
+    EXPECT_EQ(std::vector<int>({1}), advance(wheel, 1001));
+}
+
+TEST(TimingWheel, TestFarDeadlines) {
+    std::vector<int> unused;
+    adc::TimingWheel wheel;
+    RecordingTimer far{unused, 1};
+    const auto deadline = std::uint64_t{1} << 40;
+    wheel.schedule(far, deadline);
+    EXPECT_TRUE(advance(wheel, deadline - 1).empty());
+    EXPECT_EQ(std::vector<int>({1}), advance(wheel, deadline));
+}
+
+TEST(TimingWheel, TestServiceFiresTimeoutManager) {
+    std::atomic<int> fired{0};
+    TimeoutManager fast{[&] {
+                            ++fired;
+                        },
+                        std::chrono::milliseconds{5}};
+    TimeoutManager slow{[&] {
+                            fired += 10;
+                        },
+                        std::chrono::milliseconds{5}};
+    slow.restart(std::chrono::hours{1});
+    for (int i = 0; i < 1000 && fired == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(1, fired);
+}
+
+TEST(TimingWheel, TestCancelRacingExpiry) {
+    adc::TimerService service;
+    adc::TimerSource::Override useService{service};
+
+    std::atomic<int> fired{0};
+    std::vector<void *> handles;
+    for (int i = 0; i < 200; ++i) {
+        handles.push_back(createTimer(
+            [&] {
+                ++fired;
+            },
+            std::chrono::milliseconds{i % 4}));
+    }
+    // cancels timers that already fired, are firing and are still pending alike
+    for (const auto handle : handles) {
+        cancelTimer(handle);
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0u, service.pending());
+    const auto firedBefore = fired.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(firedBefore, fired);
+}
+
+TEST(TimingWheel, TestThreadOverrideStaysOnItsThread) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    adc::DeferredTimerSource deferred;
+    {
+        adc::TimerSource::ThreadOverride hold{deferred};
+        EXPECT_EQ(&deferred, &adc::TimerSource::current());
+        std::thread other{[&] {
+            EXPECT_EQ(&clock, &adc::TimerSource::current());
+        }};
+        other.join();
+
+        // held, not armed, until released
+        int fired = 0;
+        TimeoutManager timeout{
+            [&fired] {
+                ++fired;
+            },
+            5ms};
+        EXPECT_EQ(1U, deferred.held());
+        EXPECT_EQ(0U, clock.pending());
+    }
+    EXPECT_EQ(&clock, &adc::TimerSource::current());
+}
+
+TEST(TimingWheel, TestDeferredSourceArmsOnRelease) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+    adc::DeferredTimerSource deferred;
+    int fired = 0;
+    std::optional<TimeoutManager> cancelled;
+    std::optional<TimeoutManager> pending;
+    {
+        adc::TimerSource::ThreadOverride hold{deferred};
+        cancelled.emplace(
+            [&fired] {
+                ++fired;
+            },
+            1ms);
+        pending.emplace(
+            [&fired] {
+                fired += 10;
+            },
+            5ms);
+        cancelled.reset();
+    }
+    clock.runFor(10ms);
+    EXPECT_EQ(0, fired);
+
+    // armed for its full duration from the release on, and forwarded to the clock from then on
+    deferred.release();
+    EXPECT_EQ(1U, clock.pending());
+    clock.runFor(4ms);
+    EXPECT_EQ(0, fired);
+    clock.runFor(1ms);
+    EXPECT_EQ(10, fired);
+    pending->restart(1ms);
+    clock.runFor(1ms);
+    EXPECT_EQ(20, fired);
+}
@@ -0,0 +1,114 @@
+#include "Tracer.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Go {};
+    struct Stay {};
+
+    class Red;
+    class Green;
+
+    class Red {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Green>();
+        }
+        adc::NoTransition process(Stay) {
+            return {};
+        }
+        int getState() const {
+            return 0;
+        }
+    };
+
+    class Green {
+    public:
+        auto process(Go) {
+            return adc::transitionTo<Red>();
+        }
+        std::optional<adc::TTransition<Red>> process(Stay) {
+            return std::nullopt;
+        }
+        int getState() const {
+            return 1;
+        }
+    };
+
+    // a state with a payload, so that the variant is larger than its index
+    class Payload {
+    public:
+        int getState() const {
+            return _value;
+        }
+
+    private:
+        int _value{2};
+    };
+
+    struct RecordingTracer {
+        template <typename Event>
+        void onEvent(std::size_t state, const Event &) {
+            calls.push_back("event " + std::to_string(state));
+        }
+        void onExit(std::size_t state) {
+            calls.push_back("exit " + std::to_string(state));
+        }
+        void onEntry(std::size_t state) {
+            calls.push_back("entry " + std::to_string(state));
+        }
+        void onNoOp(std::size_t state) {
+            calls.push_back("no-op " + std::to_string(state));
+        }
+
+        std::vector<std::string> calls;
+    };
+} // namespace
+
+TEST(Tracer, TestHooks) {
+    adc::TTracedFSMStateTransitions<RecordingTracer, Red, Green> fsm{Red{}};
+    fsm.process(Go{});
+    fsm.process(Stay{});
+    fsm.process(std::variant<Go, Stay>{Go{}});
+    fsm.process(Stay{});
+
+    const std::vector<std::string> expected{
+        "event 0", "exit 0", "entry 1", "event 1", "no-op 1", "event 1", "exit 1", "entry 0", "event 0", "no-op 0"};
+    EXPECT_EQ(expected, fsm.tracer().calls);
+}
+
+TEST(Tracer, TestNullTracerAddsNoState) {
+    // the layout of a machine holding its strategy and variant as plain members, without any tracer
+    struct Untraced {
+        adc::details::StatesHandlingTransitions strategy;
+        std::variant<Red, Green, Payload> state;
+    };
+    EXPECT_LT(sizeof(adc::TFSMStateTransitions<Red, Green, Payload>), sizeof(Untraced));
+    EXPECT_EQ(sizeof(std::variant<Red, Green, Payload>), sizeof(adc::TFSMStateTransitions<Red, Green, Payload>));
+}
+
+TEST(Tracer, TestRingTracerRoundTrip) {
+    adc::TTracedFSMStateTransitions<adc::RingTracer, Red, Green> fsm{Red{}};
+    fsm.tracer().setId(42);
+    fsm.process(Go{});
+    fsm.process(Stay{});
+
+    std::stringstream trace;
+    adc::dumpTrace(trace);
+    std::stringstream decoded;
+    ASSERT_TRUE(adc::decodeTrace(trace, decoded, {"Red", "Green"}));
+
+    const auto text = decoded.str();
+    EXPECT_NE(std::string::npos, text.find("fsm 42: Red -> Green on ")) << text;
+    EXPECT_NE(std::string::npos, text.find("fsm 42: Green ignored ")) << text;
+    EXPECT_NE(std::string::npos, text.find("Stay")) << text;
+}
+
+TEST(Tracer, TestDecodeRejectsGarbage) {
+    std::stringstream garbage{"not a trace"};
+    std::stringstream decoded;
+    EXPECT_FALSE(adc::decodeTrace(garbage, decoded));
+}
@@ -0,0 +1,46 @@
+#include "TurnstileFleet.h"
+
+#include <gtest/gtest.h>
+
+using fsm_fleet::Fleet;
+
+TEST(TurnstileFleet, TestInitialState) {
+    Fleet fleet{3};
+    for (std::size_t id = 0; id < fleet.size(); ++id) {
+        EXPECT_EQ(eState::Locked, fleet.getState(id));
+        EXPECT_EQ(SwingDoor::eStatus::Closed, fleet.getGate(id).getDoor().getStatus());
+        EXPECT_EQ("Touch Card", fleet.getGate(id).getPOS().getFirstRow());
+    }
+}
+
+TEST(TurnstileFleet, TestGatesAreIndependent) {
+    Fleet fleet{3};
+    fleet.process(0, CardPresented{"1111"}).process(2, CardPresented{"2222"}).process(2, TransactionSuccess{5, 25});
+
+    EXPECT_EQ(eState::PaymentProcessing, fleet.getState(0));
+    EXPECT_EQ(eState::Locked, fleet.getState(1));
+    EXPECT_EQ(eState::PaymentSuccess, fleet.getState(2));
+    EXPECT_EQ(SwingDoor::eStatus::Open, fleet.getGate(2).getDoor().getStatus());
+    EXPECT_EQ("Fare: 5", fleet.getGate(2).getPOS().getSecondRow());
+}
+
+TEST(TurnstileFleet, TestSlotsAreReused) {
+    Fleet fleet{2};
+    for (int i = 0; i < 10; ++i) {
+        fleet.process(0, CardPresented{"1111"}).process(0, TransactionDeclined{"Insufficient Funds"});
+        fleet.process(1, CardPresented{"2222"}).process(1, Timeout{});
+        fleet.process(0, Timeout{}).process(1, AnyEvent{TransactionSuccess{5, 25}}).process(1, PersonPassed{});
+    }
+    EXPECT_EQ(eState::Locked, fleet.getState(0));
+    EXPECT_EQ(eState::Locked, fleet.getState(1));
+}
+
+TEST(TurnstileFleet, TestProcessAll) {
+    Fleet fleet{4};
+    fleet.process(1, CardPresented{"1111"}).process(3, CardPresented{"2222"}).process(3, TransactionDeclined{"Expired"});
+
+    // the retry keeps gate 1 in PaymentProcessing, gate 3 returns to Locked
+    EXPECT_EQ(1u, fleet.processAll(Timeout{}));
+    EXPECT_EQ(eState::PaymentProcessing, fleet.getState(1));
+    EXPECT_EQ(eState::Locked, fleet.getState(3));
+}
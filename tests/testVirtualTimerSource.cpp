@@ -0,0 +1,63 @@
+#include "FSMStateTransitions.h"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using FSM = fsm_state_transitions::FSM;
+
+TEST(VirtualTimerSource, TestRetriesUntilNetworkFailure) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    FSM fsm;
+    fsm.process(CardPresented{"1111"});
+    EXPECT_EQ(1u, clock.pending());
+
+    EXPECT_EQ(0u, clock.runFor(1999ms));
+    EXPECT_EQ(eState::PaymentProcessing, fsm.getState());
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway1", "1111", getFare()));
+
+    EXPECT_EQ(1u, clock.runFor(1ms));
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway2", "1111", getFare()));
+
+    // third gateway at 4s, PaymentFailed at 6s and back to Locked at 8s
+    EXPECT_EQ(3u, clock.runFor(8s));
+    EXPECT_EQ(eState::Locked, fsm.getState());
+    EXPECT_EQ(fsm.getLastTransaction(), std::make_tuple("Gateway3", "1111", getFare()));
+    EXPECT_EQ(0u, clock.pending());
+    EXPECT_EQ(10000ms, clock.now());
+}
+
+TEST(VirtualTimerSource, TestTransitionCancelsTimeout) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    FSM fsm;
+    fsm.process(CardPresented{"1111"});
+    clock.runFor(1s);
+    fsm.process(TransactionSuccess{5, 25});
+    EXPECT_EQ(1u, clock.pending());
+
+    EXPECT_EQ(1u, clock.runFor(2s));
+    EXPECT_EQ(eState::Unlocked, fsm.getState());
+    EXPECT_EQ(0u, clock.pending());
+}
+
+TEST(VirtualTimerSource, TestCreateTimer) {
+    adc::VirtualTimerSource clock;
+    adc::TimerSource::Override useVirtualTime{clock};
+
+    int fired = 0;
+    createTimer(
+        [&] {
+            ++fired;
+        },
+        5ms);
+    cancelTimer(createTimer(
+        [&] {
+            fired += 10;
+        },
+        5ms));
+    EXPECT_EQ(1u, clock.runFor(1h));
+    EXPECT_EQ(1, fired);
+}
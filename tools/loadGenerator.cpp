@@ -0,0 +1,130 @@
+#include "LoadGenerator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    void usage(const char * program) {
+        std::cerr << "usage: " << program << " [options]\n"
+                  << "  --gates N                   turnstiles to drive (1000)\n"
+                  << "  --minutes M                 simulated minutes of arrivals (10)\n"
+                  << "  --rate R                    taps per gate and minute (4)\n"
+                  << "  --pass MS                   from the door opening to the rider passing (1500)\n"
+                  << "  --seed S                    (1)\n"
+                  << "  --latency G:fixed:MS\n"
+                  << "  --latency G:uniform:LOW:HIGH\n"
+                  << "  --latency G:lognormal:MEDIAN:SIGMA\n"
+                  << "  --decline G:RATE            fraction of the requests to gateway G declined\n"
+                  << "  --outage G:FROM:TO          gateway G loses the requests made FROM to TO seconds in\n"
+                  << "G is the gateway number, 1 to 3; times are in milliseconds unless stated otherwise.\n";
+    }
+
+    std::vector<std::string_view> split(std::string_view text) {
+        std::vector<std::string_view> fields;
+        for (auto colon = text.find(':'); colon != std::string_view::npos; colon = text.find(':')) {
+            fields.push_back(text.substr(0, colon));
+            text.remove_prefix(colon + 1);
+        }
+        fields.push_back(text);
+        return fields;
+    }
+
+    std::optional<double> number(std::string_view text) {
+        const std::string copy{text};
+        char * end = nullptr;
+        const auto value = std::strtod(copy.c_str(), &end);
+        if (copy.empty() || *end != '\0' || value < 0) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    std::chrono::milliseconds millis(double value) {
+        return std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(value)};
+    }
+
+    // the profile of the gateway named by the first field, or nothing
+    GatewayProfile * gatewayOf(LoadOptions & options, std::string_view field) {
+        const auto gateway = number(field);
+        if (!gateway || *gateway < 1 || *gateway > static_cast<double>(options.gateways.size())) {
+            return nullptr;
+        }
+        return &options.gateways[static_cast<std::size_t>(*gateway) - 1];
+    }
+
+    bool parseGatewayOption(LoadOptions & options, std::string_view option, std::string_view value) {
+        const auto fields = split(value);
+        auto * profile = gatewayOf(options, fields[0]);
+        if (!profile) {
+            return false;
+        }
+        std::vector<double> numbers;
+        for (std::size_t i = option == "--latency" ? 2 : 1; i < fields.size(); ++i) {
+            const auto parsed = number(fields[i]);
+            if (!parsed) {
+                return false;
+            }
+            numbers.push_back(*parsed);
+        }
+        if (option == "--decline" && numbers.size() == 1 && numbers[0] <= 1) {
+            profile->declineRate = numbers[0];
+        } else if (option == "--outage" && numbers.size() == 2 && numbers[0] < numbers[1]) {
+            profile->outages.push_back(Outage{millis(numbers[0] * 1000), millis(numbers[1] * 1000)});
+        } else if (option == "--latency" && fields[1] == "fixed" && numbers.size() == 1) {
+            profile->latency = LatencyModel::fixed(millis(numbers[0]));
+        } else if (option == "--latency" && fields[1] == "uniform" && numbers.size() == 2 && numbers[0] <= numbers[1]) {
+            profile->latency = LatencyModel::uniform(millis(numbers[0]), millis(numbers[1]));
+        } else if (option == "--latency" && fields[1] == "lognormal" && numbers.size() == 2 && numbers[0] >= 1) {
+            profile->latency = LatencyModel::logNormal(millis(numbers[0]), numbers[1]);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseOption(LoadOptions & options, std::string_view option, std::string_view value) {
+        if (option == "--latency" || option == "--decline" || option == "--outage") {
+            return parseGatewayOption(options, option, value);
+        }
+        const auto parsed = number(value);
+        if (!parsed) {
+            return false;
+        }
+        if (option == "--gates") {
+            options.gates = static_cast<std::size_t>(*parsed);
+        } else if (option == "--minutes") {
+            options.duration = millis(*parsed * 60000);
+        } else if (option == "--rate") {
+            options.tapsPerMinute = *parsed;
+        } else if (option == "--pass") {
+            options.passTime = millis(*parsed);
+        } else if (option == "--seed") {
+            options.seed = static_cast<std::uint64_t>(*parsed);
+        } else {
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+// Drives turnstiles against simulated gateways on virtual time and reports how the taps went; entirely offline.
+int main(int argc, char * argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc || !parseOption(options, argv[i], argv[i + 1])) {
+            std::cerr << "invalid option " << argv[i] << (i + 1 < argc ? std::string{" "} + argv[i + 1] : "") << '\n';
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.gates == 0 || options.tapsPerMinute <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::cout << runLoad(options);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "Tracer.h"
+
+#include <fstream>
+#include <iostream>
+
+// Prints a trace written by adc::dumpTrace. The optional state names replace the state indices, in the order the
+// states are listed in the traced FSM.
+int main(int argc, char * argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <trace file> [state names...]\n";
+        return 2;
+    }
+    std::ifstream in{argv[1], std::ios::binary};
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << '\n';
+        return 1;
+    }
+    const std::vector<std::string> stateNames(argv + 2, argv + argc);
+    if (!adc::decodeTrace(in, std::cout, stateNames)) {
+        std::cerr << argv[1] << " is not a complete trace\n";
+        return 1;
+    }
+    return 0;
+}